@@ -173,7 +173,7 @@ namespace malmo
             this->video_frame_writer->close();
     }
 
-    void ALEAgentHost::onVideo(TimestampedVideoFrame message)
+    void ALEAgentHost::onVideo(boost::shared_ptr<TimestampedVideoFrame> message)
     {
         if (this->video_frame_writer)
             this->video_frame_writer->write(message);
@@ -184,10 +184,10 @@ namespace malmo
         {
         case AgentHost::VideoPolicy::LATEST_FRAME_ONLY:
                 this->world_state.video_frames.clear();
-                this->world_state.video_frames.push_back( boost::make_shared<TimestampedVideoFrame>( message ) );
+                this->world_state.video_frames.push_back( message );
                 break;
         case AgentHost::VideoPolicy::KEEP_ALL_FRAMES:
-                this->world_state.video_frames.push_back( boost::make_shared<TimestampedVideoFrame>( message ) );
+                this->world_state.video_frames.push_back( message );
                 break;
         }
         
@@ -277,7 +277,8 @@ namespace malmo
         const ALEScreen& screen = this->ale_interface->getScreen();
 
         // Create a TimestampedVideoFrame for our own use:
-        TimestampedVideoFrame tsframe;
+        boost::shared_ptr<TimestampedVideoFrame> frame = boost::make_shared<TimestampedVideoFrame>();
+        TimestampedVideoFrame& tsframe = *frame;
         tsframe.timestamp = ts;
         tsframe.channels = 3;
         tsframe.width = this->requested_width;
@@ -287,7 +288,7 @@ namespace malmo
         int actual_height = screen.height();
 
         int pixels = requested_width * requested_height;
-        tsframe.pixels.resize(3 * pixels);
+        std::vector<unsigned char> rgb(3 * pixels);
         // AleInterfrace.getScreenRGB has a stupid bug whereby it only returns the top third of the screen,
         // so we need to do this manually.
         // We also do the scaling at the same time, using nearest-neighbour for speed.
@@ -311,9 +312,9 @@ namespace malmo
                         int srcx = (int)((double)dstx * requested_to_actual_width);
                         unsigned int pix = this->ale_interface->theOSystem->colourPalette().getRGB(screen.getArray()[srcx + srcy * actual_width]);
                         int i = 3 * (dstx + dsty* requested_width);
-                        tsframe.pixels[i] = (unsigned char)(pix >> 16);     // red
-                        tsframe.pixels[i + 1] = (unsigned char)(pix >> 8);  // green
-                        tsframe.pixels[i + 2] = (unsigned char)pix;         // blue
+                        rgb[i] = (unsigned char)(pix >> 16);     // red
+                        rgb[i + 1] = (unsigned char)(pix >> 8);  // green
+                        rgb[i + 2] = (unsigned char)pix;         // blue
                     }
                 }
                 else
@@ -324,9 +325,9 @@ namespace malmo
                         int dstx = (int)((double)srcx * actual_to_requested_width);
                         unsigned int pix = this->ale_interface->theOSystem->colourPalette().getRGB(screen.getArray()[srcx + srcy * actual_width]);
                         int i = 3 * (dstx + dsty* requested_width);
-                        tsframe.pixels[i] = (unsigned char)(pix >> 16);     // red
-                        tsframe.pixels[i + 1] = (unsigned char)(pix >> 8);  // green
-                        tsframe.pixels[i + 2] = (unsigned char)pix;         // blue
+                        rgb[i] = (unsigned char)(pix >> 16);     // red
+                        rgb[i + 1] = (unsigned char)(pix >> 8);  // green
+                        rgb[i + 2] = (unsigned char)pix;         // blue
                     }
                 }
             }
@@ -346,9 +347,9 @@ namespace malmo
                         int srcx = (int)((double)dstx * requested_to_actual_width);
                         unsigned int pix = this->ale_interface->theOSystem->colourPalette().getRGB(screen.getArray()[srcx + srcy * actual_width]);
                         int i = 3 * (dstx + dsty* requested_width);
-                        tsframe.pixels[i] = (unsigned char)(pix >> 16);     // red
-                        tsframe.pixels[i + 1] = (unsigned char)(pix >> 8);  // green
-                        tsframe.pixels[i + 2] = (unsigned char)pix;         // blue
+                        rgb[i] = (unsigned char)(pix >> 16);     // red
+                        rgb[i + 1] = (unsigned char)(pix >> 8);  // green
+                        rgb[i + 2] = (unsigned char)pix;         // blue
                     }
                 }
                 else
@@ -359,14 +360,15 @@ namespace malmo
                         int dstx = (int)((double)srcx * actual_to_requested_width);
                         unsigned int pix = this->ale_interface->theOSystem->colourPalette().getRGB(screen.getArray()[srcx + srcy * actual_width]);
                         int i = 3 * (dstx + dsty* requested_width);
-                        tsframe.pixels[i] = (unsigned char)(pix >> 16);     // red
-                        tsframe.pixels[i + 1] = (unsigned char)(pix >> 8);  // green
-                        tsframe.pixels[i + 2] = (unsigned char)pix;         // blue
+                        rgb[i] = (unsigned char)(pix >> 16);     // red
+                        rgb[i + 1] = (unsigned char)(pix >> 8);  // green
+                        rgb[i + 2] = (unsigned char)pix;         // blue
                     }
                 }
             }
         }
-        onVideo(tsframe);
+        tsframe.setPixels(std::move(rgb));
+        onVideo(frame);
 
         // Is the game still running, or did we just die?
         if (this->ale_interface->game_over())
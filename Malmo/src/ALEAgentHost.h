@@ -104,7 +104,7 @@ namespace malmo
         private:
             void initialize(const MissionSpec& mission, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id);
 
-            void onVideo(TimestampedVideoFrame message);
+            void onVideo(boost::shared_ptr<TimestampedVideoFrame> message);
             void onReward(boost::posix_time::ptime ts, float reward);
             void onObservation(TimestampedString message);
 
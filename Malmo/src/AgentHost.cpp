@@ -43,11 +43,20 @@
 #include <MissionEnded.h>
 
 // STL:
+#include <algorithm>
 #include <exception>
+#include <future>
 #include <sstream>
+#include <stdexcept>
 #include <regex>
 #include <mutex>
 #include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #define LOG_COMPONENT Logger::LOG_AGENTHOST
 
@@ -55,35 +64,135 @@ namespace malmo
 {
     std::once_flag test_schemas_flag;
 
-    // set defaults
     AgentHost::AgentHost()
+        : AgentHost( boost::make_shared<boost::asio::io_service>(), boost::make_shared<WorldStateSignal>() )
+    {
+        // start the io_service on a background thread - see setNumberOfIoThreads for more
+        this->owns_io_service = true;
+        this->work = boost::in_place(boost::ref(this->io_service));
+        startBackgroundThreads(1, false);
+    }
+
+    // set defaults
+    AgentHost::AgentHost(boost::shared_ptr<boost::asio::io_service> io_service, boost::shared_ptr<WorldStateSignal> world_state_signal)
         : ArgumentParser( std::string("Malmo version: ") + BOOST_PP_STRINGIZE(MALMO_VERSION) )
+        , shared_io_service(io_service)
+        , io_service(*io_service)
+        , owns_io_service(false)
+        , client_connect_timeout_ms(2000)
+        , client_reply_timeout_ms(5000)
+        , mission_init_timeout_ms(30000)
         , video_policy(LATEST_FRAME_ONLY)
         , rewards_policy(SUM_REWARDS)
         , observations_policy(LATEST_OBSERVATION_ONLY)
+        , video_frames_limit(0)
+        , video_frames_overflow(DROP_OLDEST)
+        , rewards_limit(0)
+        , rewards_overflow(DROP_OLDEST)
+        , observations_limit(0)
+        , observations_overflow(DROP_OLDEST)
+        , frame_stack_depth(0)
+        , align_video(false)
+        , video_alignment_ms(50)
+        , use_shared_memory_video(false)
+        , use_local_sockets(false)
+        , incomplete_video_bundles(0)
+        , is_mission_running(false)
+        , has_mission_begun(false)
+        , video_frames_by_type_since_last_state(TimestampedVideoFrame::_MAX_FRAME_TYPE, 0)
+        , world_state_signal(world_state_signal)
+        , command_time_awaiting_observation(0)
+        , command_time_awaiting_frame(0)
         , current_role( 0 )
     {
         initialiser::initXSD();
 
+        for (auto& count : this->video_frames_received_by_type)
+            count = 0;
+
         this->addOptionalFlag("help,h", "show description of allowed options");
         this->addOptionalFlag("test",   "run this as an integration test");
+    }
 
-        // start the io_service on background threads
-        this->work = boost::in_place(boost::ref(this->io_service));
-        const int NUM_BACKGROUND_THREADS = 1; // can be increased if I/O becomes a bottleneck
-        for( int i = 0; i < NUM_BACKGROUND_THREADS; i++ )
+    AgentHost::~AgentHost()
+    {
+        // (Before the io threads go, since a mission being started needs them to hear from the client.)
+        stopMissionStartThread();
+        if (this->owns_io_service) {
+            LOGSIMPLE(LOG_FINE, "Destroying AgentHost - waiting for io_service to stop...");
+            this->work = boost::none;
+            stopBackgroundThreads();
+            LOGSIMPLE(LOG_FINE, "Destroying AgentHost - io_service stopped.");
+        }
+        // (Callbacks usually call into us, so let them finish while we're still whole.)
+        boost::shared_ptr<CallbackDispatcher> dispatcher = boost::atomic_exchange(&this->callback_dispatcher, boost::shared_ptr<CallbackDispatcher>());
+        if (dispatcher)
+            dispatcher->stop();
+        this->close();
+    }
+
+    void AgentHost::setNumberOfIoThreads(int num_threads, bool pin_to_cores)
+    {
+        if (num_threads < 1)
+            throw std::invalid_argument("Need at least one io thread.");
+        if (!this->owns_io_service)
+            throw std::runtime_error("The io threads of an agent host in a VectorAgentHost are set by the VectorAgentHost.");
+
+        // Stopping the io_service only makes the threads return - any operations in progress carry on when the new threads start running it.
+        boost::lock_guard<boost::mutex> scope_guard(this->background_threads_mutex);
+        stopBackgroundThreads();
+        this->io_service.reset();
+        startBackgroundThreads(num_threads, pin_to_cores);
+    }
+
+    void AgentHost::setClientTimeouts(int connect_timeout_ms, int reply_timeout_ms, int mission_init_timeout_ms)
+    {
+        if (connect_timeout_ms <= 0 || reply_timeout_ms <= 0 || mission_init_timeout_ms <= 0)
+            throw std::invalid_argument("Client timeouts must be positive.");
+        this->client_connect_timeout_ms = connect_timeout_ms;
+        this->client_reply_timeout_ms = reply_timeout_ms;
+        this->mission_init_timeout_ms = mission_init_timeout_ms;
+    }
+
+    void AgentHost::startBackgroundThreads(int num_threads, bool pin_to_cores)
+    {
+        const unsigned int num_cores = std::max(1u, boost::thread::hardware_concurrency());
+        for( int i = 0; i < num_threads; i++ ) {
             this->background_threads.push_back( boost::make_shared<boost::thread>( boost::bind( &boost::asio::io_service::run, &this->io_service ) ) );
+            if (pin_to_cores && !pinThreadToCore(*this->background_threads.back(), i % num_cores))
+                LOGWARNING(LT("Failed to pin io thread "), i, LT(" to a core - carrying on unpinned."));
+        }
     }
 
-    AgentHost::~AgentHost()
+    void AgentHost::stopBackgroundThreads()
     {
-        LOGSIMPLE(LOG_FINE, "Destroying AgentHost - waiting for io_service to stop...");
-        this->work = boost::none;
         this->io_service.stop();
         for( auto& t : this->background_threads )
             t->join();
-        LOGSIMPLE(LOG_FINE, "Destroying AgentHost - io_service stopped.");
-        this->close();
+        this->background_threads.clear();
+    }
+
+    void AgentHost::stopMissionStartThread()
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->mission_start_mutex);
+        this->mission_start_work = boost::none;
+        this->mission_start_service.stop();
+        if (this->mission_start_thread.joinable())
+            this->mission_start_thread.join();
+    }
+
+    bool AgentHost::pinThreadToCore(boost::thread& thread, unsigned int core)
+    {
+#if defined(_WIN32)
+        return SetThreadAffinityMask(thread.native_handle(), static_cast<DWORD_PTR>(1) << (core % (8 * sizeof(DWORD_PTR)))) != 0;
+#elif defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core, &cpus);
+        return pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpus) == 0;
+#else
+        return false;
+#endif
     }
 
     void AgentHost::testSchemasCompatible()
@@ -107,6 +216,11 @@ namespace malmo
         }
     }
 
+    bool AgentHost::isLocalAddress(const std::string& address)
+    {
+        return address == "localhost" || address == "::1" || address.compare(0, 4, "127.") == 0;
+    }
+
     std::string AgentHost::extractVersionNumber(std::string name)
     {
         // Doesn't seem to be a way to use CodeSynthesis to parse the xsd itself, and we don't
@@ -139,20 +253,62 @@ namespace malmo
         startMission(mission, client_pool, mission_record, 0, "");
     }
 
-    bool AgentHost::killClient(const ClientInfo& client)
+    MissionStartFuture AgentHost::startMissionAsync(const MissionSpec& mission, const ClientPool& client_pool, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id)
+    {
+        // MissionSpec copies share the underlying mission, so take a deep copy that the caller can't change underneath us.
+        const MissionSpec mission_copy(mission.getAsXML(false), false);
+        auto promise = boost::make_shared< std::promise< boost::shared_ptr<MissionInitSpec> > >();
+        MissionStartFuture future(promise->get_future().share());
+        {
+            // startMission blocks for as long as the negotiation with the clients takes, so it gets a thread to itself rather than an io thread.
+            boost::lock_guard<boost::mutex> scope_guard(this->mission_start_mutex);
+            if (!this->mission_start_thread.joinable()) {
+                this->mission_start_work = boost::in_place(boost::ref(this->mission_start_service));
+                this->mission_start_thread = boost::thread(boost::bind(&boost::asio::io_service::run, &this->mission_start_service));
+            }
+        }
+        this->mission_start_service.post(boost::bind(&AgentHost::completeMissionStart, this, promise, mission_copy, client_pool, mission_record, role, unique_experiment_id));
+        return future;
+    }
+
+    void AgentHost::completeMissionStart(boost::shared_ptr< std::promise< boost::shared_ptr<MissionInitSpec> > > promise, const MissionSpec& mission, const ClientPool& client_pool, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id)
     {
-        LOGINFO(LT("Sending kill command to "), client.ip_address, LT(":"), client.control_port);
-        std::string reply;
         try
         {
-            reply = SendStringAndGetShortReply(this->io_service, client.ip_address, client.control_port, "MALMO_KILL_CLIENT\n", false);
+            startMission(mission, client_pool, mission_record, role, unique_experiment_id);
+            promise->set_value(this->current_mission_init);
         }
-        catch (std::exception& e)
+        catch (...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    }
+
+    // Notes the client in a list of those that timed out, for the MissionException if the mission can't be started.
+    static void noteTimeout(std::string& timeouts, const ClientInfo& client, const ShortReply& reply)
+    {
+        if (!reply.timed_out)
+            return;
+        timeouts += timeouts.empty() ? " (" : "; ";
+        timeouts += client.ip_address + ":" + std::to_string(client.control_port) + " - " + reply.error;
+    }
+
+    static std::string describeTimeouts(const std::string& timeouts)
+    {
+        return timeouts.empty() ? "" : timeouts + ")";
+    }
+
+    bool AgentHost::killClient(const ClientInfo& client)
+    {
+        LOGINFO(LT("Sending kill command to "), client.ip_address, LT(":"), client.control_port);
+        const ShortReply result = this->control_connections.exchange(client.ip_address, client.control_port, "MALMO_KILL_CLIENT\n", false, this->client_connect_timeout_ms, this->client_reply_timeout_ms);
+        if (!result.ok)
         {
             // This is expected quite often - client is likely not running.
-            LOGINFO(LT("Exception attempting to kill client: "), e.what());
+            LOGINFO(LT("Failed attempting to kill client: "), result.error);
             return false;
         }
+        const std::string& reply = result.reply;
         LOGINFO(LT("Killing client, received reply from "), client.ip_address, LT(": "), reply);
         if (reply == "MALMOBUSY")
             throw MissionException("Failed to kill Minecraft instance - mod is not dormant (is a mission still running?)", MissionException::MISSION_CAN_NOT_KILL_BUSY_CLIENT);
@@ -180,12 +336,18 @@ namespace malmo
                 throw MissionException("Video height must be divisible by 2.", MissionException::MISSION_BAD_VIDEO_REQUEST);
         }
         
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+        boost::lock_guard<boost::mutex> scope_guard(this->mission_mutex);
 
-        if (this->world_state.is_mission_running) {
+        if (this->is_mission_running) {
             throw MissionException("A mission is already running.", MissionException::MISSION_ALREADY_RUNNING);
         }
 
+        {
+            // (Before anything can arrive for this mission.)
+            boost::lock_guard<boost::mutex> world_state_guard(this->world_state_mutex);
+            applyMessageLimits();
+        }
+
         // Once initializeOurServers has completed, we MUST call AgentHost::close() before bailing out of this method with an exception.
         initializeOurServers( mission, mission_record, role, unique_experiment_id );
 
@@ -195,16 +357,17 @@ namespace malmo
             // We are the agent responsible for the integrated server.
             // If we are part of a multi-agent mission, our mission should have been started before any of the others are attempted.
             // This means we are in a position to reserve clients in the client pool:
-            ClientPool reservedAgents = reserveClients(client_pool, mission.getNumberOfAgents());
+            std::string timeouts;
+            ClientPool reservedAgents = reserveClients(client_pool, mission.getNumberOfAgents(), timeouts);
             if (reservedAgents.clients.size() != mission.getNumberOfAgents())
             {
                 // Not enough clients available - go no further.
                 LOGWARNING(LT("Failed to reserve sufficient clients - throwing MissionException."));
                 this->close();
                 if (mission.getNumberOfAgents() == 1)
-                    throw MissionException("Failed to find an available client for this mission - tried all the clients in the supplied client pool.", MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE);
+                    throw MissionException("Failed to find an available client for this mission - tried all the clients in the supplied client pool." + describeTimeouts(timeouts), MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE);
                 else
-                    throw MissionException("There are not enough clients available in the ClientPool to start this " + std::to_string(mission.getNumberOfAgents()) + " agent mission.", MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE);
+                    throw MissionException("There are not enough clients available in the ClientPool to start this " + std::to_string(mission.getNumberOfAgents()) + " agent mission." + describeTimeouts(timeouts), MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE);
             }
             pool = reservedAgents;
         }
@@ -218,9 +381,24 @@ namespace malmo
         // work through the client pool until we find a client to run our mission for us
         findClient( pool );
 
-        this->world_state.clear();
-        // NB. Sets is_mission_running to false. The Mod decides when the mission actually starts (it might need to wait for other agents to join, for example)
-        //     and will then send us a MissionInit message, but at this point in time this->world_state->is_mission_running is false.
+        {
+            // Throw away anything left over from the last mission.
+            boost::lock_guard<boost::mutex> world_state_guard(this->world_state_mutex);
+            collectWorldState();
+            this->world_state.clear();
+            this->world_state.video_frames.reserve(this->video_frames_limit);
+            this->world_state.video_bundles.reserve(this->video_frames_limit);
+            this->world_state.rewards.reserve(this->rewards_limit);
+            this->world_state.observations.reserve(this->observations_limit);
+            std::fill(this->video_frames_by_type_since_last_state.begin(), this->video_frames_by_type_since_last_state.end(), 0);
+            this->has_mission_begun = false;
+        }
+        {
+            boost::lock_guard<boost::mutex> stacks_guard(this->frame_stacks_mutex);
+            this->frame_stacks.assign(TimestampedVideoFrame::_MAX_FRAME_TYPE, FrameStack(this->frame_stack_depth));
+        }
+        // NB. is_mission_running is still false. The Mod decides when the mission actually starts (it might need to wait for other agents to join, for example)
+        //     and will then send us a MissionInit message, but at this point in time this->is_mission_running is false.
 
         if (this->current_mission_record->isRecording()){
             std::ofstream missionInitXML(this->current_mission_record->getMissionInitPath());
@@ -238,6 +416,18 @@ namespace malmo
         this->current_role = role;
 
         listenForMissionControlMessages(this->current_mission_init->getAgentMissionControlPort());
+        boost::lock_guard<boost::mutex> aligner_guard(this->video_aligner_mutex);
+        this->video_aligner = FrameAligner(boost::posix_time::milliseconds(this->video_alignment_ms));
+        if (this->align_video) {
+            if (mission.isVideoRequested(this->current_role))
+                this->video_aligner.expect(TimestampedVideoFrame::VIDEO);
+            if (mission.isDepthRequested(this->current_role))
+                this->video_aligner.expect(TimestampedVideoFrame::DEPTH_MAP);
+            if (mission.isLuminanceRequested(this->current_role))
+                this->video_aligner.expect(TimestampedVideoFrame::LUMINANCE);
+            if (mission.isColourMapRequested(this->current_role))
+                this->video_aligner.expect(TimestampedVideoFrame::COLOUR_MAP);
+        }
         // Video producing handlers.
         if (mission.isVideoRequested(this->current_role)) {
             this->video_server = listenForVideo(this->video_server,
@@ -295,101 +485,160 @@ namespace malmo
             this->current_mission_init->setAgentColourMapPort(this->colourmap_server->getPort());
 
         this->current_mission_init->setAgentRewardsPort(this->rewards_server->getPort());
+
+        // Only offer shared memory if every video stream we're expecting can be received that way. (findClient withdraws the offer from remote clients.)
+        bool shared_memory_ready = this->use_shared_memory_video && !this->shared_memory_prefix.empty();
+        const boost::shared_ptr<VideoServer> requested_servers[] = {
+            mission.isVideoRequested(this->current_role) ? this->video_server : boost::shared_ptr<VideoServer>(),
+            mission.isDepthRequested(this->current_role) ? this->depth_server : boost::shared_ptr<VideoServer>(),
+            mission.isLuminanceRequested(this->current_role) ? this->luminance_server : boost::shared_ptr<VideoServer>(),
+            mission.isColourMapRequested(this->current_role) ? this->colourmap_server : boost::shared_ptr<VideoServer>()
+        };
+        for (const auto& server : requested_servers) {
+            if (server && server->getSharedMemoryName() != SharedMemoryRing::getSegmentName(this->shared_memory_prefix, server->getFrameType()))
+                shared_memory_ready = false;
+        }
+        this->current_mission_init->setAgentSharedMemoryPrefix(shared_memory_ready ? this->shared_memory_prefix : "");
+
+        // Likewise for UNIX-domain sockets, which stand in for each of our ports.
+        bool local_sockets_ready = this->use_local_sockets && IsLocalSocketSupported();
+        if (local_sockets_ready) {
+            local_sockets_ready = listenOnLocalSocket(*this->mission_control_server) && listenOnLocalSocket(*this->observations_server) && listenOnLocalSocket(*this->rewards_server);
+            for (const auto& server : requested_servers) {
+                if (server && !listenOnLocalSocket(*server))
+                    local_sockets_ready = false;
+            }
+        }
+        this->current_mission_init->setAgentLocalSocketPrefix(local_sockets_ready ? this->local_socket_prefix : "");
+    }
+
+    template< typename Server >
+    bool AgentHost::listenOnLocalSocket(Server& server)
+    {
+        if (this->local_socket_prefix.empty())
+            this->local_socket_prefix = MakeLocalSocketPrefix();
+        const std::string name = GetLocalSocketName(this->local_socket_prefix, server.getPort());
+        if (server.getLocalSocket().empty()) {
+            try {
+                server.listenOnLocalSocket(name);
+            }
+            catch (const std::exception& e) {
+                // Not fatal - the client will just connect over TCP instead.
+                LOGWARNING(LT("Failed to listen on local socket "), name, LT(", will use TCP: "), e.what());
+                return false;
+            }
+        }
+        return server.getLocalSocket() == name;
     }
     
-    std::string AgentHost::generateMissionInit()
+    MissionInitTemplate AgentHost::generateMissionInit() const
     {
-        const bool prettyPrint = false;
-        const std::string generated_xml = this->current_mission_init->getAsXML( prettyPrint );
+        // (Validated here, once per mission, however many clients are then offered it.)
+        return MissionInitTemplate( *this->current_mission_init );
+    }
 
-        try {
-            const bool validate = true;
-            MissionInitSpec test_output(generated_xml,validate);
-        }
-        catch (xml_schema::exception& e)
+    static std::vector< std::pair<std::string, int> > controlEndpoints(const std::vector<ClientInfo>& clients)
+    {
+        std::vector< std::pair<std::string, int> > endpoints;
+        for (const ClientInfo& item : clients)
+            endpoints.push_back(std::make_pair(item.ip_address, item.control_port));
+        return endpoints;
+    }
+
+    static void cancelReservations(ControlConnectionPool& control_connections, const std::vector<ClientInfo>& clients, int connect_timeout_ms, int reply_timeout_ms)
+    {
+        if (clients.empty())
+            return;
+        for (const ClientInfo& item : clients)
+            LOGINFO(LT("Cancelling reservation request with "), item.ip_address, LT(":"), item.control_port);
+        const std::vector<ShortReply> replies = control_connections.exchange(controlEndpoints(clients), std::vector<std::string>(clients.size(), "MALMO_CANCEL_REQUEST\n"), false, connect_timeout_ms, reply_timeout_ms);
+        for (size_t i = 0; i < clients.size(); i++)
         {
-            std::ostringstream oss;
-            oss << "Internal error: the XML we generate does not validate: " << e.what() << "\n" << e << "\n" << generated_xml << std::endl;
-            throw std::runtime_error(oss.str());
+            if (!replies[i].ok)
+            {
+                // This is not expected, and probably means something bad has happened.
+                LOGERROR(LT("Failed to cancel reservation request with "), clients[i].ip_address, LT(":"), clients[i].control_port);
+                continue;
+            }
+            LOGINFO(LT("Cancelling reservation, received reply from "), clients[i].ip_address, LT(": "), replies[i].reply);
         }
-
-        return generated_xml;
     }
 
-    ClientPool AgentHost::reserveClients(const ClientPool& client_pool, int clients_required)
+    ClientPool AgentHost::reserveClients(const ClientPool& client_pool, int clients_required, std::string& timeouts)
     {
         LOGSECTION(LOG_FINE, "Reserving clients...");
         ClientPool reservedClients;
-        std::string reply;
+        reservedClients.health = client_pool.health;
+        const std::vector<ClientInfo> clients = client_pool.getClientsByReadiness();
         // TODO - currently reserved for 20 seconds (the 20000 below) - make this configurable.
         std::string request = std::string("MALMO_REQUEST_CLIENT:") + BOOST_PP_STRINGIZE(MALMO_VERSION) + ":20000:" + this->current_mission_init->getExperimentID() + +"\n";
-        for (const ClientInfo& item : client_pool.clients)
-        {
+        for (const ClientInfo& item : clients)
             LOGINFO(LT("Sending reservation request to "), item.ip_address, LT(":"), item.control_port);
-            try
-            {
-                reply = SendStringAndGetShortReply(this->io_service, item.ip_address, item.control_port, request, false);
-            }
-            catch (std::exception&)
+
+        // Ask every client at once, rather than waiting on each in turn for the ones that aren't running.
+        const std::vector<ShortReply> replies = this->control_connections.exchange(controlEndpoints(clients), std::vector<std::string>(clients.size(), request), false, this->client_connect_timeout_ms, this->client_reply_timeout_ms);
+
+        // Keep the first clients to accept, taken in order of readiness, as if they had been asked in that order, and release the rest.
+        std::vector<ClientInfo> surplusClients;
+        for (size_t i = 0; i < clients.size(); i++)
+        {
+            const ClientInfo& item = clients[i];
+            client_pool.health->recordExchange(item, replies[i], ClientHealth::REQUEST);
+            if (!replies[i].ok)
             {
-                // This is expected quite often - client is likely not running.
-                continue;
+                noteTimeout(timeouts, item, replies[i]);
+                continue;   // This is expected quite often - client is likely not running.
             }
-            LOGINFO(LT("Reserving client, received reply from "), item.ip_address, LT(": "), reply);
+            LOGINFO(LT("Reserving client, received reply from "), item.ip_address, LT(": "), replies[i].reply);
 
             const std::string malmo_reservation_prefix = "MALMOOK";
-            if (reply.find(malmo_reservation_prefix) == 0)
+            if (replies[i].reply.find(malmo_reservation_prefix) == 0)
             {
                 // Successfully reserved this client.
-                reservedClients.add(item);
-                clients_required--;
-                if (clients_required == 0)
-                    break;  // We've got all the clients we need.
+                if (clients_required > 0)
+                {
+                    reservedClients.add(item);
+                    clients_required--;
+                }
+                else
+                {
+                    surplusClients.push_back(item);
+                }
             }
         }
         // Were there enough clients available?
         if (clients_required > 0)
         {
             // No - release the clients we already reserved.
-            for (const ClientInfo& item : reservedClients.clients)
-            {
-                LOGINFO(LT("Cancelling reservation request with "), item.ip_address, LT(":"), item.control_port);
-                try
-                {
-                    reply = SendStringAndGetShortReply(this->io_service, item.ip_address, item.control_port, "MALMO_CANCEL_REQUEST\n", false);
-                }
-                catch (std::exception&)
-                {
-                    // This is not expected, and probably means something bad has happened.
-                    LOGERROR(LT("Failed to cancel reservation request with "), item.ip_address, LT(":"), item.control_port);
-                    continue;
-                }
-                LOGINFO(LT("Cancelling reservation, received reply from "), item.ip_address, LT(": "), reply);
-            }
+            surplusClients.insert(surplusClients.end(), reservedClients.clients.begin(), reservedClients.clients.end());
             reservedClients.clients.clear();
         }
+        cancelReservations(this->control_connections, surplusClients, this->client_connect_timeout_ms, this->client_reply_timeout_ms);
         return reservedClients;
     }
 
     bool AgentHost::findServer(const ClientPool& client_pool)
     {
         LOGSECTION(LOG_FINE, "Looking for server...");
-        std::string reply;
         std::string request = std::string("MALMO_FIND_SERVER") + this->current_mission_init->getExperimentID() + +"\n";
         bool serverWarmingUp = false;
-
+        std::string timeouts;
         for (const ClientInfo& item : client_pool.clients)
-        {
             LOGINFO(LT("Sending find server request to "), item.ip_address, LT(":"), item.control_port);
-            try
-            {
-                reply = SendStringAndGetShortReply(this->io_service, item.ip_address, item.control_port, request, false);
-            }
-            catch (std::exception&)
+
+        // Ask every client at once, then take the answers in pool order.
+        const std::vector<ShortReply> replies = this->control_connections.exchange(controlEndpoints(client_pool.clients), std::vector<std::string>(client_pool.clients.size(), request), false, this->client_connect_timeout_ms, this->client_reply_timeout_ms);
+
+        for (size_t i = 0; i < client_pool.clients.size(); i++)
+        {
+            const ClientInfo& item = client_pool.clients[i];
+            client_pool.health->recordExchange(item, replies[i], ClientHealth::REQUEST);
+            if (!replies[i].ok)
             {
-                // This is expected quite often - client is likely not running.
-                continue;
+                noteTimeout(timeouts, item, replies[i]);
+                continue;   // This is expected quite often - client is likely not running.
             }
+            const std::string& reply = replies[i].reply;
             LOGINFO(LT("Seeking server, received reply from "), item.ip_address, LT(": "), reply);
 
             const std::string malmo_server_prefix = "MALMOS";
@@ -417,57 +666,88 @@ namespace malmo
 
         this->close();
         if (serverWarmingUp)
-            throw MissionException("Failed to find the server for this mission - you may need to wait.", MissionException::MISSION_SERVER_WARMING_UP);
+            throw MissionException("Failed to find the server for this mission - you may need to wait." + describeTimeouts(timeouts), MissionException::MISSION_SERVER_WARMING_UP);
         else
-            throw MissionException("Failed to find the server for this mission - you must start the agent that has role 0 first.", MissionException::MISSION_SERVER_NOT_FOUND);
+            throw MissionException("Failed to find the server for this mission - you must start the agent that has role 0 first." + describeTimeouts(timeouts), MissionException::MISSION_SERVER_NOT_FOUND);
     }
 
     void AgentHost::findClient(const ClientPool& client_pool)
     {
         LOGSECTION(LOG_FINE, "Looking for client...");
         std::string reply;
+        std::string timeouts;
+        const std::string shared_memory_prefix = this->current_mission_init->getAgentSharedMemoryPrefix();
+        const std::string local_socket_prefix = this->current_mission_init->getAgentLocalSocketPrefix();
+        const MissionInitTemplate mission_init_template = generateMissionInit();
 
         // As a reasonable optimisation, assume that clients are started in the order of their role, for multi-agent missions.
         // So start looking at position <role> within the client pool.
         // Eg, if the first four agents get clients 1,2,3 and 4 respectively, agent 5 doesn't need to waste time checking
         // the first four clients.
         int num_clients = (int)client_pool.clients.size();
+        std::vector<ClientInfo> candidates;
         for (int i = 0; i < num_clients; i++)
-        {
-            const ClientInfo& item = client_pool.clients[(i + this->current_role) % num_clients];
-            this->current_mission_init->setClientAddress( item.ip_address );
-            this->current_mission_init->setClientMissionControlPort( item.control_port );
-            this->current_mission_init->setClientCommandsPort( item.command_port );
-            const std::string mission_init_xml = generateMissionInit() + "\n";
+            candidates.push_back(client_pool.clients[(i + this->current_role) % num_clients]);
+        // Then try the clients that are expected to be ready soonest first (keeping that order among clients that can't be told apart).
+        candidates = client_pool.health->orderByReadiness(candidates);
 
-            LOGINFO(LT("Sending MissionInit to "), item.ip_address, LT(":"), item.control_port);
-            try 
+        // Check which clients are running all at once, so the ones that aren't cost one timeout between them.
+        // The MissionInit itself is still offered to one client at a time, so that only one of them can take the mission.
+        const std::vector<ShortReply> reachable = this->control_connections.exchange(controlEndpoints(candidates), std::vector<std::string>(candidates.size()), false, this->client_connect_timeout_ms, this->client_reply_timeout_ms);
+
+        for (int i = 0; i < num_clients; i++)
+        {
+            const ClientInfo& item = candidates[i];
+            client_pool.health->recordExchange(item, reachable[i], ClientHealth::CONNECT);
+            if (!reachable[i].ok)
             {
-                reply = SendStringAndGetShortReply( this->io_service, item.ip_address, item.control_port, mission_init_xml, false );
-            }
-            catch( std::exception& ) {
-                LOGINFO(LT("No response from "), item.ip_address, LT(":"), item.control_port);
+                LOGINFO(LT("No response from "), item.ip_address, LT(":"), item.control_port, LT(" - "), reachable[i].error);
+                noteTimeout(timeouts, item, reachable[i]);
                 // This is expected quite often - client is likely not running.
                 continue;
             }
+            const bool is_local = isLocalAddress( item.ip_address );
+            const std::string mission_init_xml = mission_init_template.getXML( item.ip_address, item.control_port, item.command_port, is_local ) + "\n";
+
+            LOGINFO(LT("Sending MissionInit to "), item.ip_address, LT(":"), item.control_port);
+            const ShortReply result = this->control_connections.exchange( item.ip_address, item.control_port, mission_init_xml, false, this->client_connect_timeout_ms, this->mission_init_timeout_ms );
+            client_pool.health->recordExchange( item, result, ClientHealth::MISSION_INIT );
+            if( !result.ok ) {
+                LOGINFO(LT("No response from "), item.ip_address, LT(":"), item.control_port, LT(" - "), result.error);
+                noteTimeout(timeouts, item, result);
+                continue;
+            }
+            reply = result.reply;
             LOGINFO(LT("Looking for client, received reply from "), item.ip_address, LT(": "), reply);
             // this is either a) a single agent mission, b) a multi-agent mission but we are role 0, 
             // or c) a multi-agent mission where we have already located the server
             // expected: MALMOBUSY, MALMOOK, MALMOERROR...
             const std::string malmo_mission_accepted = "MALMOOK";
-            if( reply == malmo_mission_accepted )
-                return; // mission was accepted, now wait for the mission to start
+            if( reply == malmo_mission_accepted ) {
+                // keep the mission init as offered to this client
+                this->current_mission_init->setClientAddress( item.ip_address );
+                this->current_mission_init->setClientMissionControlPort( item.control_port );
+                this->current_mission_init->setClientCommandsPort( item.command_port );
+                this->current_mission_init->setAgentSharedMemoryPrefix( is_local ? shared_memory_prefix : "" );
+                this->current_mission_init->setAgentLocalSocketPrefix( is_local ? local_socket_prefix : "" );
+                // mission was accepted, now wait for the mission to start (and note when it ends, for the client's record)
+                this->mission_client = item;
+                this->mission_client_health = client_pool.health;
+                this->mission_accepted_time = boost::posix_time::microsec_clock::universal_time();
+                return;
+            }
         }
 
         LOGWARNING(LT("Failed to find an available client for this mission - throwing MissionException."));
         this->close();
-        throw MissionException( "Failed to find an available client for this mission - tried all the clients in the supplied client pool.", MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE );
+        throw MissionException( "Failed to find an available client for this mission - tried all the clients in the supplied client pool." + describeTimeouts(timeouts), MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE );
     }
 
     WorldState AgentHost::peekWorldState() const
     {
         boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
 
+        collectWorldState();
         return this->world_state;
     }
 
@@ -475,13 +755,214 @@ namespace malmo
     {
         boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
 
-        WorldState old_world_state( this->world_state );
-        this->world_state.clear();
-        this->world_state.is_mission_running = old_world_state.is_mission_running;
-        this->world_state.has_mission_begun = old_world_state.has_mission_begun;
+        collectWorldState();
+        return takeWorldState();
+    }
+
+    void AgentHost::swapWorldState(WorldState& world_state)
+    {
+        world_state.clear();    // (releasing the old messages before taking the lock)
+
+        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+
+        collectWorldState();
+        this->world_state.swap( world_state );
+        std::fill(this->video_frames_by_type_since_last_state.begin(), this->video_frames_by_type_since_last_state.end(), 0);
+    }
+
+    // Waits until is_satisfied() returns true or the time runs out, then takes the world state.
+    // is_satisfied is called with world_state_mutex held, each time the world state has been collected.
+    template< typename Predicate >
+    WorldState AgentHost::waitUntil(int timeout_ms, Predicate is_satisfied)
+    {
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+
+        WorldStateSignal& signal = *this->world_state_signal;
+        signal.waiters++;
+        // (Pairs with the fence in notifyWorldStateChanged: either we see the producer's message below, or it sees us waiting
+        // and moves the sequence on.)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (bool timed_out = false;; ) {
+            const unsigned int seen = signal.sequence.load(std::memory_order_acquire);
+            {
+                boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+                collectWorldState();
+                if (timed_out || is_satisfied()) {
+                    signal.waiters--;
+                    return takeWorldState();
+                }
+            }
+            timed_out = !signal.waitForChange(seen, deadline);
+        }
+    }
+
+    WorldState AgentHost::waitForWorldState(int timeout_ms, const WorldStateCondition& condition)
+    {
+        return waitUntil(timeout_ms, [&]() {
+            return condition.isSatisfiedBy(this->world_state, this->video_frames_by_type_since_last_state);
+        });
+    }
+
+    WorldState AgentHost::step(std::string command, const WorldStateCondition& condition, int timeout_ms)
+    {
+        const StepBaseline baseline = sendStepCommand(command);
+        return waitUntil(timeout_ms, [&]() { return isStepComplete(baseline, condition); });
+    }
+
+    AgentHost::StepBaseline AgentHost::sendStepCommand(const std::string& command)
+    {
+        StepBaseline baseline;
+        {
+            boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+            collectWorldState();
+            baseline.observations = this->world_state.number_of_observations_since_last_state;
+            baseline.rewards = this->world_state.number_of_rewards_since_last_state;
+            baseline.video_frames = this->world_state.number_of_video_frames_since_last_state;
+            baseline.video_frames_by_type = this->video_frames_by_type_since_last_state;
+            baseline.mission_control_messages = this->world_state.mission_control_messages.size();
+            baseline.errors = this->world_state.errors.size();
+        }
+        sendCommand(command);
+        return baseline;
+    }
+
+    bool AgentHost::isStepComplete(const StepBaseline& baseline, const WorldStateCondition& condition) const
+    {
+        if (!this->world_state.is_mission_running)
+            return true;    // nothing more is coming
+
+        WorldState since_command;
+        since_command.number_of_observations_since_last_state = this->world_state.number_of_observations_since_last_state - baseline.observations;
+        since_command.number_of_rewards_since_last_state = this->world_state.number_of_rewards_since_last_state - baseline.rewards;
+        since_command.number_of_video_frames_since_last_state = this->world_state.number_of_video_frames_since_last_state - baseline.video_frames;
+        std::vector<int> video_frames_by_type_since_command(baseline.video_frames_by_type.size());
+        for (size_t frametype = 0; frametype < video_frames_by_type_since_command.size(); frametype++)
+            video_frames_by_type_since_command[frametype] = this->video_frames_by_type_since_last_state[frametype] - baseline.video_frames_by_type[frametype];
+        since_command.mission_control_messages.assign(this->world_state.mission_control_messages.begin() + baseline.mission_control_messages, this->world_state.mission_control_messages.end());
+        since_command.errors.assign(this->world_state.errors.begin() + baseline.errors, this->world_state.errors.end());
+        since_command.has_mission_begun = this->world_state.has_mission_begun;
+        since_command.is_mission_running = this->world_state.is_mission_running;
+        return condition.isSatisfiedBy(since_command, video_frames_by_type_since_command);
+    }
+
+    LatencyHistogram AgentHost::getCommandToObservationLatencies() const
+    {
+        return this->command_to_observation_latencies;
+    }
+
+    LatencyHistogram AgentHost::getCommandToFrameLatencies() const
+    {
+        return this->command_to_frame_latencies;
+    }
+
+    void AgentHost::resetLatencies()
+    {
+        this->command_to_observation_latencies.reset();
+        this->command_to_frame_latencies.reset();
+    }
+
+    WorldState AgentHost::takeWorldState()
+    {
+        // Swapped rather than copied, so the messages change hands without touching their reference counts.
+        WorldState old_world_state;
+        old_world_state.swap( this->world_state );
+        std::fill(this->video_frames_by_type_since_last_state.begin(), this->video_frames_by_type_since_last_state.end(), 0);
         return old_world_state;
     }
 
+    // Adds newly received messages to those already stored, following the policy.
+    // Returns the number of messages dropped to keep within the limit (0 for no limit).
+    template< typename T >
+    static int storeMessages( std::vector<T>& stored, const std::vector<T>& received, bool latest_only, int limit = 0, AgentHost::OverflowPolicy overflow = AgentHost::DROP_OLDEST )
+    {
+        if (received.empty())
+            return 0;
+        if (latest_only) {
+            stored.clear();
+            stored.push_back( received.back() );
+            return 0;
+        }
+        stored.insert( stored.end(), received.begin(), received.end() );
+        if (limit <= 0 || stored.size() <= static_cast<size_t>(limit))
+            return 0;
+        const size_t excess = stored.size() - limit;
+        if (overflow == AgentHost::DROP_OLDEST)
+            stored.erase( stored.begin(), stored.begin() + excess );
+        else
+            stored.resize( limit );
+        return static_cast<int>( excess );
+    }
+
+    void AgentHost::applyMessageLimits()
+    {
+        const int video_frames_limit = this->video_policy == VideoPolicy::KEEP_ALL_FRAMES ? this->video_frames_limit : 0;
+        this->video_channel.setLimit( video_frames_limit, this->video_frames_overflow == DROP_OLDEST );
+        this->video_bundle_channel.setLimit( video_frames_limit, this->video_frames_overflow == DROP_OLDEST );
+        // (Rewards to be summed go through the queue too, but mustn't be dropped.)
+        const int rewards_limit = this->rewards_policy == RewardsPolicy::KEEP_ALL_REWARDS ? this->rewards_limit : 0;
+        this->reward_channel.setLimit( rewards_limit, this->rewards_overflow == DROP_OLDEST );
+        const int observations_limit = this->observations_policy == ObservationsPolicy::KEEP_ALL_OBSERVATIONS ? this->observations_limit : 0;
+        this->observation_channel.setLimit( observations_limit, this->observations_overflow == DROP_OLDEST );
+    }
+
+    void AgentHost::collectWorldState() const
+    {
+        // Read the flags first: anything sent before the mission was marked as ended is then sure to be collected along with it.
+        this->world_state.is_mission_running = this->is_mission_running;
+        this->world_state.has_mission_begun = this->has_mission_begun;
+
+        std::vector< boost::shared_ptr<TimestampedVideoFrame> >& frames = this->received_frames;
+        frames.clear();
+        this->world_state.number_of_video_frames_since_last_state += static_cast<int>( this->video_channel.take( frames ) );
+        for (size_t frametype = 0; frametype < this->video_frames_by_type_since_last_state.size(); frametype++)
+            this->video_frames_by_type_since_last_state[frametype] += this->video_frames_received_by_type[frametype].exchange( 0 );
+        this->world_state.number_of_video_frames_dropped_since_last_state += static_cast<int>( this->video_channel.takeDroppedCount() );
+        this->world_state.number_of_video_frames_dropped_since_last_state += storeMessages( this->world_state.video_frames, frames, this->video_policy == VideoPolicy::LATEST_FRAME_ONLY, this->video_frames_limit, this->video_frames_overflow );
+        frames.clear();
+
+        std::vector< boost::shared_ptr<FrameBundle> >& bundles = this->received_bundles;
+        bundles.clear();
+        this->video_bundle_channel.take( bundles );
+        this->video_bundle_channel.takeDroppedCount();
+        storeMessages( this->world_state.video_bundles, bundles, this->video_policy == VideoPolicy::LATEST_FRAME_ONLY, this->video_frames_limit, this->video_frames_overflow );
+        bundles.clear();
+        this->world_state.number_of_incomplete_video_bundles_since_last_state += this->incomplete_video_bundles.exchange( 0 );
+
+        std::vector< boost::shared_ptr<TimestampedReward> >& rewards = this->received_rewards;
+        rewards.clear();
+        this->world_state.number_of_rewards_since_last_state += static_cast<int>( this->reward_channel.take( rewards ) );
+        if (this->rewards_policy == RewardsPolicy::SUM_REWARDS) {
+            for (const auto& received : rewards) {
+                TimestampedReward reward( *received );
+                if( !this->world_state.rewards.empty() )
+                    reward.add( *this->world_state.rewards.front() );
+                this->world_state.rewards.clear();
+                this->world_state.rewards.push_back( boost::make_shared<TimestampedReward>( reward ) );
+                // (timestamp is that of latest reward, even if zero)
+            }
+        }
+        else {
+            this->world_state.number_of_rewards_dropped_since_last_state += static_cast<int>( this->reward_channel.takeDroppedCount() );
+            this->world_state.number_of_rewards_dropped_since_last_state += storeMessages( this->world_state.rewards, rewards, this->rewards_policy == RewardsPolicy::LATEST_REWARD_ONLY, this->rewards_limit, this->rewards_overflow );
+        }
+        rewards.clear();
+
+        std::vector< boost::shared_ptr<TimestampedString> >& messages = this->received_strings;
+        messages.clear();
+        this->world_state.number_of_observations_since_last_state += static_cast<int>( this->observation_channel.take( messages ) );
+        this->world_state.number_of_observations_dropped_since_last_state += static_cast<int>( this->observation_channel.takeDroppedCount() );
+        this->world_state.number_of_observations_dropped_since_last_state += storeMessages( this->world_state.observations, messages, this->observations_policy == ObservationsPolicy::LATEST_OBSERVATION_ONLY, this->observations_limit, this->observations_overflow );
+
+        messages.clear();
+        this->mission_control_channel.take( messages );
+        storeMessages( this->world_state.mission_control_messages, messages, false );
+
+        messages.clear();
+        this->error_channel.take( messages );
+        storeMessages( this->world_state.errors, messages, false );
+        messages.clear();
+    }
+
     std::string AgentHost::getRecordingTemporaryDirectory() const
     {
         return this->current_mission_record && this->current_mission_record->isRecording() ? this->current_mission_record->getTemporaryDirectory() : "";
@@ -498,6 +979,44 @@ namespace malmo
         this->video_policy = videoPolicy;
     }
 
+    void AgentHost::setVideoPreprocessor(const FramePreprocessor& preprocessor)
+    {
+        this->video_preprocessor = preprocessor;
+    }
+
+    void AgentHost::setVideoAlignment(bool align, int max_time_difference_ms)
+    {
+        if (max_time_difference_ms < 0)
+            throw std::invalid_argument("Video alignment tolerance can't be negative.");
+        this->align_video = align;
+        this->video_alignment_ms = max_time_difference_ms;
+    }
+
+    void AgentHost::setSharedMemoryVideo(bool use)
+    {
+        this->use_shared_memory_video = use;
+    }
+
+    void AgentHost::setLocalSockets(bool use)
+    {
+        this->use_local_sockets = use;
+    }
+
+    void AgentHost::setFrameStackDepth(int depth)
+    {
+        if (depth < 0)
+            throw std::invalid_argument("Frame stack depth can't be negative.");
+        this->frame_stack_depth = depth;
+    }
+
+    FrameStack AgentHost::getFrameStack(TimestampedVideoFrame::FrameType frametype) const
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->frame_stacks_mutex);
+        if (frametype < 0 || static_cast<size_t>(frametype) >= this->frame_stacks.size())
+            return FrameStack();
+        return this->frame_stacks[frametype];
+    }
+
     void AgentHost::setRewardsPolicy(RewardsPolicy rewardsPolicy)
     {
         this->rewards_policy = rewardsPolicy;
@@ -507,6 +1026,90 @@ namespace malmo
     {
         this->observations_policy = observationsPolicy;
     }
+
+    void AgentHost::setVideoFramesLimit(int max_frames, OverflowPolicy overflow)
+    {
+        if (max_frames < 0)
+            throw std::invalid_argument("The limit on the number of video frames can't be negative.");
+        this->video_frames_limit = max_frames;
+        this->video_frames_overflow = overflow;
+    }
+
+    void AgentHost::setRewardsLimit(int max_rewards, OverflowPolicy overflow)
+    {
+        if (max_rewards < 0)
+            throw std::invalid_argument("The limit on the number of rewards can't be negative.");
+        this->rewards_limit = max_rewards;
+        this->rewards_overflow = overflow;
+    }
+
+    void AgentHost::setObservationsLimit(int max_observations, OverflowPolicy overflow)
+    {
+        if (max_observations < 0)
+            throw std::invalid_argument("The limit on the number of observations can't be negative.");
+        this->observations_limit = max_observations;
+        this->observations_overflow = overflow;
+    }
+
+    void AgentHost::setCallbackThreads(int num_threads, int max_queued_callbacks)
+    {
+        boost::shared_ptr<CallbackDispatcher> dispatcher = boost::make_shared<CallbackDispatcher>(num_threads, NUM_CALLBACK_QUEUES, max_queued_callbacks);
+        boost::shared_ptr<CallbackDispatcher> replaced;
+        {
+            boost::lock_guard<boost::mutex> scope_guard(this->callback_dispatcher_mutex);
+            replaced = boost::atomic_exchange(&this->callback_dispatcher, dispatcher);
+        }
+        // Wait for the old threads here, rather than on whichever io thread happens to let go of the dispatcher last.
+        if (replaced)
+            replaced->stop();
+    }
+
+    boost::shared_ptr<CallbackDispatcher> AgentHost::getCallbackDispatcher()
+    {
+        boost::shared_ptr<CallbackDispatcher> dispatcher = boost::atomic_load(&this->callback_dispatcher);
+        if (dispatcher)
+            return dispatcher;
+        // Only start the threads when the first callback is set.
+        boost::lock_guard<boost::mutex> scope_guard(this->callback_dispatcher_mutex);
+        if (!this->callback_dispatcher)
+            boost::atomic_store(&this->callback_dispatcher, boost::make_shared<CallbackDispatcher>(1, NUM_CALLBACK_QUEUES, 100));
+        return this->callback_dispatcher;
+    }
+
+    void AgentHost::setFrameCallback(FrameCallback callback)
+    {
+        getCallbackDispatcher();
+        boost::atomic_store(&this->frame_callback, callback.empty() ? boost::shared_ptr<FrameCallback>() : boost::make_shared<FrameCallback>(callback));
+    }
+
+    void AgentHost::setObservationCallback(StringCallback callback)
+    {
+        getCallbackDispatcher();
+        boost::atomic_store(&this->observation_callback, callback.empty() ? boost::shared_ptr<StringCallback>() : boost::make_shared<StringCallback>(callback));
+    }
+
+    void AgentHost::setRewardCallback(RewardCallback callback)
+    {
+        getCallbackDispatcher();
+        boost::atomic_store(&this->reward_callback, callback.empty() ? boost::shared_ptr<RewardCallback>() : boost::make_shared<RewardCallback>(callback));
+    }
+
+    void AgentHost::setMissionEndedCallback(StringCallback callback)
+    {
+        getCallbackDispatcher();
+        boost::atomic_store(&this->mission_ended_callback, callback.empty() ? boost::shared_ptr<StringCallback>() : boost::make_shared<StringCallback>(callback));
+    }
+
+    template< typename Message >
+    void AgentHost::dispatchCallback(int queue, const boost::shared_ptr< boost::function<void(Message)> >& callback_slot, const Message& message)
+    {
+        boost::shared_ptr< boost::function<void(Message)> > callback = boost::atomic_load(&callback_slot);
+        if (!callback)
+            return;
+        boost::shared_ptr<CallbackDispatcher> dispatcher = boost::atomic_load(&this->callback_dispatcher);
+        if (dispatcher && !dispatcher->post(queue, [callback, message]() { (*callback)(message); }))
+            LOGFINE(LT("Too many callbacks waiting - dropped one."));
+    }
     
     void AgentHost::listenForMissionControlMessages( int port )
     {
@@ -570,6 +1173,27 @@ namespace malmo
             ret_server = video_server;
         }
 
+        if (this->use_shared_memory_video && SharedMemoryRing::isSupported() && ret_server->getSharedMemoryName().empty()) {
+            if (this->shared_memory_prefix.empty())
+                this->shared_memory_prefix = SharedMemoryRing::makeUniquePrefix();
+            try {
+                ret_server->receiveFromSharedMemory(SharedMemoryRing::getSegmentName(this->shared_memory_prefix, frametype));
+            }
+            catch (const std::exception& e) {
+                // Not fatal - the frames will just come over TCP instead.
+                LOGWARNING(LT("Failed to set up shared memory for video, will use TCP: "), e.what());
+            }
+        }
+
+        if (frametype == TimestampedVideoFrame::VIDEO){
+            try {
+                ret_server->preprocess(this->video_preprocessor);
+            }
+            catch (const std::invalid_argument& e) {
+                throw MissionException(std::string("Video preprocessing doesn't suit the requested video: ") + e.what(), MissionException::MISSION_BAD_VIDEO_REQUEST);
+            }
+        }
+
         ret_server->startRecording();
         return ret_server;
     }
@@ -602,7 +1226,7 @@ namespace malmo
     
     void AgentHost::onMissionControlMessage(TimestampedString xml)
     {
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+        boost::lock_guard<boost::mutex> scope_guard(this->mission_mutex);
 
         std::stringstream ss( xml.text );
         boost::property_tree::ptree pt;
@@ -612,7 +1236,7 @@ namespace malmo
         catch( std::exception&e ) {
             TimestampedString error_message( xml );
             error_message.text = std::string("Error parsing mission control message as XML: ") + e.what() + ":\n" + xml.text.substr(0,20) + "...\n";
-            this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+            addError( error_message );
             return;
         }
 
@@ -620,24 +1244,25 @@ namespace malmo
         {
             TimestampedString error_message( xml );
             error_message.text = "Empty XML string in mission control message";
-            this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+            addError( error_message );
             return;
         }
         std::string root_node_name(pt.front().first.data());
 
-        if( !this->world_state.is_mission_running && root_node_name == "MissionInit" ) {
+        bool should_close = false;
+        if( !this->is_mission_running && root_node_name == "MissionInit" ) {
             try {
                 const bool validate = true;
                 this->current_mission_init = boost::make_shared<MissionInitSpec>(xml.text,validate);
-                this->world_state.is_mission_running = true;
-                this->world_state.has_mission_begun = true;
+                this->is_mission_running = true;
+                this->has_mission_begun = true;
             }
             catch (const xml_schema::exception& e) {
                 std::ostringstream oss;
                 oss << "Error parsing MissionInit message XML: " << e.what() << " : " << e << ":" << xml.text.substr(0, 20) << "...";
                 TimestampedString error_message(xml);
                 error_message.text = oss.str();
-                this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+                addError( error_message );
                 return;
             }
             this->openCommandsConnection();
@@ -646,20 +1271,14 @@ namespace malmo
             
             try {
                 const bool validate = true;
-                
-                xml_schema::properties props;
-                props.schema_location(xml_namespace, FindSchemaFile("MissionEnded.xsd"));
-
-                xml_schema::flags flags = xml_schema::flags::dont_initialize;
-                if( !validate )
-                    flags = flags | xml_schema::flags::dont_validate;
-
-                std::istringstream iss(xml.text);
-                std::unique_ptr<malmo::schemas::MissionEnded> mission_ended = malmo::schemas::MissionEnded_(iss, flags, props);
+                DOMDocumentPtr doc = ParseXML(xml.text, validate);
+                std::unique_ptr<malmo::schemas::MissionEnded> mission_ended = malmo::schemas::MissionEnded_(*doc, xml_schema::flags::dont_initialize);
 
                 switch( mission_ended->Status() ) {
                     case malmo::schemas::MissionResult::ENDED:
                     case malmo::schemas::MissionResult::PLAYER_DIED:
+                        if( this->mission_client_health )
+                            this->mission_client_health->recordMissionEnded( this->mission_client, ( boost::posix_time::microsec_clock::universal_time() - this->mission_accepted_time ).total_milliseconds() / 1000.0 );
                         break;
                     default: 
                     {
@@ -667,12 +1286,13 @@ namespace malmo
                         oss << "Mission ended abnormally: " << mission_ended->HumanReadableStatus();
                         TimestampedString error_message(xml);
                         error_message.text = oss.str();
-                        this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+                        addError( error_message );
                     }
                     break;
                 }
+                this->mission_client_health.reset();
                 
-                if (this->world_state.is_mission_running) {
+                if (this->is_mission_running) {
                     schemas::MissionEnded::Reward_optional final_reward_optional = mission_ended->Reward();
                     if( final_reward_optional.present() ) {
                         TimestampedReward final_reward(xml.timestamp,final_reward_optional.get());
@@ -715,14 +1335,20 @@ namespace malmo
                 oss << "Error parsing MissionEnded message XML: " << e.what() << " : " << e << ":" << xml.text.substr(0, 20) << "...";
                 TimestampedString error_message(xml);
                 error_message.text = oss.str();
-                this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+                addError( error_message );
                 return;
             }
             if (this->current_mission_record->isRecording()){
                 std::ofstream missionEndedXML(this->current_mission_record->getMissionEndedPath());
                 missionEndedXML << xml.text;
             }
-            this->close();
+            std::vector< boost::shared_ptr<FrameBundle> > bundles;
+            {
+                boost::lock_guard<boost::mutex> aligner_guard(this->video_aligner_mutex);
+                this->video_aligner.flush(bundles);
+            }
+            storeVideoBundles(bundles);
+            should_close = true;
         }
         else if (root_node_name == "ping") {
             // The mod is pinging us to check we are still around - do nothing.
@@ -730,11 +1356,19 @@ namespace malmo
         else {
             TimestampedString error_message( xml );
             error_message.text = "Unknown mission control message root node or at wrong time: " + root_node_name + " :" + xml.text.substr(0, 200) + "...";
-            this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+            addError( error_message );
             return;
         }
 
-        this->world_state.mission_control_messages.push_back( boost::make_shared<TimestampedString>( xml ) );
+        boost::shared_ptr<TimestampedString> message = boost::make_shared<TimestampedString>( xml );
+        this->mission_control_channel.push( message, true );
+
+        // (Only now, so that an agent that sees the mission has ended is sure to get the MissionEnded message too.)
+        if (should_close)
+            this->close();
+        notifyWorldStateChanged();
+        if (should_close)
+            dispatchCallback(MISSION_ENDED_CALLBACKS, this->mission_ended_callback, message);
     }
     
     void AgentHost::openCommandsConnection()
@@ -746,13 +1380,17 @@ namespace malmo
 
         std::string mod_address = this->current_mission_init->getClientAddress();
 
-        this->commands_connection = ClientConnection::create( this->io_service, mod_address, mod_commands_port );
+        // The client offers a local socket only if it supports them; we only use it if we're allowed to and it's on our machine.
+        const std::string mod_local_socket = this->use_local_sockets && isLocalAddress(mod_address) ? this->current_mission_init->getClientCommandsLocalSocket() : "";
+
+        this->commands_connection = ClientConnection::create( this->io_service, mod_address, mod_commands_port, mod_local_socket );
     }
 
     void AgentHost::close()
     {
         LOGSECTION(LOG_FINE, "Closing AgentHost.");
-        this->world_state.is_mission_running = false;
+        this->is_mission_running = false;
+        notifyWorldStateChanged();
         closeServers();
         closeRecording();
     }
@@ -797,27 +1435,63 @@ namespace malmo
         this->current_mission_record.reset();
     }
 
-    void AgentHost::onVideo(TimestampedVideoFrame message)
+    void AgentHost::onVideo(boost::shared_ptr<TimestampedVideoFrame> message)
     {
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+        {
+            boost::lock_guard<boost::mutex> stacks_guard(this->frame_stacks_mutex);
+            if (message->frametype >= 0 && static_cast<size_t>(message->frametype) < this->frame_stacks.size()) {
+                try {
+                    this->frame_stacks[message->frametype].push(*message);
+                }
+                catch (const std::exception& e) {
+                    LOGERROR(LT("Failed to add video frame to frame stack: "), e.what());
+                }
+            }
+        }
+
+        recordCommandLatency(this->command_time_awaiting_frame, this->command_to_frame_latencies, message->timestamp);
+        if (message->frametype >= 0 && message->frametype < TimestampedVideoFrame::_MAX_FRAME_TYPE)
+            this->video_frames_received_by_type[message->frametype]++;
+        this->video_channel.push( message, this->video_policy == VideoPolicy::KEEP_ALL_FRAMES );
 
-        switch( this->video_policy )
+        std::vector< boost::shared_ptr<FrameBundle> > bundles;
         {
-            case VideoPolicy::LATEST_FRAME_ONLY:
-                this->world_state.video_frames.clear();
-                this->world_state.video_frames.push_back( boost::make_shared<TimestampedVideoFrame>( message ) );
-                break;
-            case VideoPolicy::KEEP_ALL_FRAMES:
-                this->world_state.video_frames.push_back( boost::make_shared<TimestampedVideoFrame>( message ) );
-                break;
+            boost::lock_guard<boost::mutex> aligner_guard(this->video_aligner_mutex);
+            this->video_aligner.add(message, bundles);
+        }
+        storeVideoBundles(bundles);
+        notifyWorldStateChanged();
+        dispatchCallback(FRAME_CALLBACKS, this->frame_callback, message);
+    }
+
+    void AgentHost::storeVideoBundles( const std::vector< boost::shared_ptr<FrameBundle> >& bundles )
+    {
+        for (const auto& bundle : bundles) {
+            if (!bundle->is_complete)
+                this->incomplete_video_bundles++;
+            this->video_bundle_channel.push( bundle, this->video_policy == VideoPolicy::KEEP_ALL_FRAMES );
+        }
+    }
+
+    void AgentHost::addError( const TimestampedString& error_message )
+    {
+        this->error_channel.push( boost::make_shared<TimestampedString>( error_message ), true );
+        notifyWorldStateChanged();
+    }
+
+    void AgentHost::notifyWorldStateChanged()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        WorldStateSignal& signal = *this->world_state_signal;
+        if (signal.waiters.load(std::memory_order_relaxed) > 0) {
+            boost::lock_guard<boost::mutex> scope_guard(signal.mutex);
+            signal.sequence++;
+            signal.changed.notify_all();
         }
-        
-        this->world_state.number_of_video_frames_since_last_state++;
     }
     
     void AgentHost::onReward(TimestampedString message)
     {
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
         try {
             TimestampedReward reward;
             reward.createFromSimpleString(message.timestamp, message.text);
@@ -828,52 +1502,44 @@ namespace malmo
             oss << "Error parsing Reward message: " << e.what() << " : " << message.text;
             TimestampedString error_message(message);
             error_message.text = oss.str();
-            this->world_state.errors.push_back(boost::make_shared<TimestampedString>(error_message));
+            addError( error_message );
         }
     }
         
     void AgentHost::processReceivedReward( TimestampedReward reward )
     {
-        switch( this->rewards_policy )
-        {
-            case RewardsPolicy::LATEST_REWARD_ONLY:
-                this->world_state.rewards.clear();
-                this->world_state.rewards.push_back( boost::make_shared<TimestampedReward>( reward ) );
-                break;
-            case RewardsPolicy::SUM_REWARDS:
-                if( !this->world_state.rewards.empty() ) {
-                    reward.add(*this->world_state.rewards.front());
-                    this->world_state.rewards.clear();
-                }
-                this->world_state.rewards.push_back( boost::make_shared<TimestampedReward>( reward ) );
-                // (timestamp is that of latest reward, even if zero)
-                break;
-            case RewardsPolicy::KEEP_ALL_REWARDS:
-                this->world_state.rewards.push_back( boost::make_shared<TimestampedReward>( reward ) );
-                break;
-        }
-        
-        this->world_state.number_of_rewards_since_last_state++;
+        // (Rewards to be summed are all kept until the world state is collected, and summed then.)
+        boost::shared_ptr<TimestampedReward> message = boost::make_shared<TimestampedReward>( reward );
+        this->reward_channel.push( message, this->rewards_policy != RewardsPolicy::LATEST_REWARD_ONLY );
+        notifyWorldStateChanged();
+        dispatchCallback(REWARD_CALLBACKS, this->reward_callback, message);
     }
     
     void AgentHost::onObservation(TimestampedString message)
     {
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
-
-        switch( this->observations_policy )
-        {
-            case ObservationsPolicy::LATEST_OBSERVATION_ONLY:
-                this->world_state.observations.clear();
-                this->world_state.observations.push_back( boost::make_shared<TimestampedString>( message ) );
-                break;
-            case ObservationsPolicy::KEEP_ALL_OBSERVATIONS:
-                this->world_state.observations.push_back( boost::make_shared<TimestampedString>( message ) );
-                break;
-        }
-        
-        this->world_state.number_of_observations_since_last_state++;
+        recordCommandLatency(this->command_time_awaiting_observation, this->command_to_observation_latencies, message.timestamp);
+        boost::shared_ptr<TimestampedString> observation = boost::make_shared<TimestampedString>( message );
+        this->observation_channel.push( observation, this->observations_policy == ObservationsPolicy::KEEP_ALL_OBSERVATIONS );
+        notifyWorldStateChanged();
+        dispatchCallback(OBSERVATION_CALLBACKS, this->observation_callback, observation);
     }
     
+    static int64_t microsecondsSinceEpoch(const boost::posix_time::ptime& time)
+    {
+        return (time - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1))).total_microseconds();
+    }
+
+    // The first message received after a command claims the command's time, and counts the latency from it.
+    void AgentHost::recordCommandLatency(std::atomic<int64_t>& command_time, LatencyHistogram& latencies, const boost::posix_time::ptime& received)
+    {
+        int64_t sent = command_time.load();
+        if (sent == 0)
+            return;
+        const int64_t received_time = microsecondsSinceEpoch(received);
+        if (received_time >= sent && command_time.compare_exchange_strong(sent, 0))
+            latencies.add(boost::posix_time::microseconds(received_time - sent));
+    }
+
     void AgentHost::sendCommand(std::string command)
     {
         sendCommand(command, std::string());
@@ -881,33 +1547,56 @@ namespace malmo
 
     void AgentHost::sendCommand(std::string command, std::string key)
     {
-        boost::lock_guard<boost::mutex> scope_guard(this->world_state_mutex);
+        sendCommands(std::vector<std::string>(1, command), key);
+    }
+
+    void AgentHost::sendCommands(const std::vector<std::string>& commands)
+    {
+        sendCommands(commands, std::string());
+    }
+
+    void AgentHost::sendCommands(const std::vector<std::string>& commands, std::string key)
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->mission_mutex);
 
         if( !this->commands_connection ) {
             TimestampedString error_message(
                 boost::posix_time::microsec_clock::universal_time(),
                 "AgentHost::sendCommand : commands connection is not open. Is the mission running?"
                 );
-            this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+            addError( error_message );
             return;
         }
+        if( commands.empty() )
+            return;
 
-        std::string full_command = key.empty() ? command : key + " " + command;
+        std::vector<std::string> full_commands;
+        full_commands.reserve(commands.size());
+        for (const auto& command : commands)
+            full_commands.push_back(key.empty() ? command : key + " " + command);
+        const boost::posix_time::ptime sent = boost::posix_time::microsec_clock::universal_time();
         try {
-            this->commands_connection->send(full_command);
+            // (All in one go, so that they leave in a single write.)
+            this->commands_connection->send(full_commands);
         }
         catch (const std::runtime_error& e) {
             TimestampedString error_message(
                 boost::posix_time::microsec_clock::universal_time(),
                 "AgentHost::sendCommand : failed to send command: " + std::string(e.what())
                 );
-            this->world_state.errors.push_back( boost::make_shared<TimestampedString>( error_message ) );
+            addError( error_message );
             return;
         }
 
+        const int64_t sent_time = microsecondsSinceEpoch(sent);
+        this->command_time_awaiting_observation = sent_time;
+        this->command_time_awaiting_frame = sent_time;
+
         if (this->commands_stream.is_open()){
             std::string timestamp = boost::posix_time::to_iso_string(boost::posix_time::microsec_clock::universal_time());
-            this->commands_stream << timestamp << " " << command << std::endl;
+            for (const auto& command : commands)
+                this->commands_stream << timestamp << " " << command << "\n";
+            this->commands_stream.flush();
         }
     }
 
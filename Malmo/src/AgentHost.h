@@ -22,22 +22,34 @@
 
 // Local:
 #include "ArgumentParser.h"
+#include "CallbackDispatcher.h"
 #include "ClientConnection.h"
 #include "ClientPool.h"
+#include "ControlConnectionPool.h"
+#include "FrameAligner.h"
+#include "FrameStack.h"
+#include "FramePreprocessor.h"
+#include "LatencyHistogram.h"
+#include "MessageChannel.h"
 #include "MissionInitSpec.h"
+#include "MissionInitTemplate.h"
 #include "MissionRecord.h"
 #include "MissionSpec.h"
+#include "MissionStartFuture.h"
 #include "StringServer.h"
 #include "VideoServer.h"
 #include "WorldState.h"
+#include "WorldStateCondition.h"
 #include "Logger.h"
 
 // Boost:
 #include <boost/thread.hpp>
 
 // STL:
+#include <atomic>
 #include <string>
 #include <exception>
+#include <future>
 
 namespace malmo
 {
@@ -95,12 +107,33 @@ namespace malmo
                 , KEEP_ALL_OBSERVATIONS      //!< Attempt to store all the observations.
             };
 
+            //! Specifies which messages to drop when a KEEP_ALL policy has a limit and more messages are waiting than it allows.
+            enum OverflowPolicy {
+                  DROP_OLDEST                //!< Keep the most recent messages. This is the default.
+                , DROP_NEWEST                //!< Keep the earliest messages, dropping any that arrive once the limit is reached.
+            };
+
             //! Creates an agent host with default settings.
             AgentHost();
 
             //! Destructor
             ~AgentHost();
 
+            //! Sets the number of background threads that handle network traffic - receiving video, observations and so on, and sending commands.
+            //! There is one thread by default. Each stream is handled in order, but different streams can be handled at the same time on different threads.
+            //! \param num_threads The number of threads to use. Must be at least one.
+            //! Can't be used on the agent hosts of a VectorAgentHost, whose threads are shared - set them with the VectorAgentHost instead.
+            //! \param pin_to_cores If true, restricts thread i to CPU core i (wrapping around if there are more threads than cores). Ignored on platforms that don't support it.
+            void setNumberOfIoThreads(int num_threads, bool pin_to_cores);
+
+            //! Sets how long startMission and killClient wait on the mission control ports of the Minecraft clients.
+            //! A client that refuses the connection is given up on at once; one that can't be reached or doesn't answer is given up on when
+            //! its deadline passes, and if the mission can't be started, the MissionException names the clients that timed out.
+            //! \param connect_timeout_ms How long connecting to a client may take. 2000 by default.
+            //! \param reply_timeout_ms How long a connected client may take to answer a reservation request, a find server request or a kill command. 5000 by default.
+            //! \param mission_init_timeout_ms How long a connected client may take to accept or refuse a MissionInit, which it validates first. 30000 by default.
+            void setClientTimeouts(int connect_timeout_ms, int reply_timeout_ms, int mission_init_timeout_ms);
+
             //! Starts a mission running. Throws an exception if something goes wrong.
             //! \param mission The mission specification.
             //! \param client_pool A list of the Minecraft instances that can be used.
@@ -114,6 +147,18 @@ namespace malmo
             //! \param mission_record The specification of the mission recording to make.
             void startMission(const MissionSpec& mission, const MissionRecordSpec& mission_record);
 
+            //! Starts a mission running without waiting for it: startMission runs on a thread of the agent host's own, and the returned future
+            //! completes when it returns. Meanwhile the caller can carry on - training on the last episode, say - and the io threads carry on
+            //! handling messages. Nothing about the mission can be relied on until the future is ready. Starts requested before an earlier one
+            //! has finished run in turn; destroying the agent host waits for the one in progress, and abandons the rest.
+            //! \param mission The mission specification. A copy is taken, so it can be changed once this returns.
+            //! \param client_pool A list of the Minecraft instances that can be used.
+            //! \param mission_record The specification of the mission recording to make.
+            //! \param role Index of the agent that this agent host is to manage. Zero-based index. Use zero if there is only one agent in this mission.
+            //! \param unique_experiment_id An arbitrary identifier that is used to disambiguate our mission from other runs.
+            //! \returns A future holding the MissionInit the mission was started with, or the exception startMission threw.
+            MissionStartFuture startMissionAsync(const MissionSpec& mission, const ClientPool& client_pool, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id);
+
             //! Attempts to remotely shut down a Minecraft client - useful in cases when Minecraft has become old and sluggish. Note that the client will refuse
             //! if it is busy, or if it wasn't run with the "replaceable" flag set.
             bool killClient(const ClientInfo& client);
@@ -126,6 +171,41 @@ namespace malmo
             //! \returns The world state.
             WorldState getWorldState();
 
+            //! Gets the latest world state received from the game and resets it to empty, like getWorldState, but without allocating:
+            //! the world state is exchanged with the one passed in, which is emptied first and then kept to collect the next world state.
+            //! Passing the same WorldState each time means the vectors are reused rather than reallocated.
+            //! \param world_state Receives the world state. Whatever it held before is discarded.
+            void swapWorldState(WorldState& world_state);
+
+            //! Waits until the condition is met or the time runs out, then gets the world state and resets it to empty, as getWorldState does.
+            //! Returns as soon as the condition is met: there is no need to call getWorldState in a loop with a sleep.
+            //! \param timeout_ms The longest time to wait, in milliseconds.
+            //! \param condition What to wait for.
+            //! \returns The world state, which won't meet the condition if the time ran out.
+            WorldState waitForWorldState(int timeout_ms, const WorldStateCondition& condition);
+
+            //! Sends a command to the game client and waits for what it leads to: returns as soon as the condition is met by what has arrived
+            //! since the command was sent, or when the mission ends or the time runs out. For a gym-style step, require an observation,
+            //! a video frame and a reward, combined with WorldStateCondition::ALL.
+            //! The world state is then got and reset to empty, as getWorldState does, so it also holds anything that arrived before the command
+            //! but hadn't been got yet. (The world state mustn't be got from another thread while this waits.)
+            //! \param command The command to send as a string. e.g. "move 1"
+            //! \param condition What to wait for after sending it.
+            //! \param timeout_ms The longest time to wait, in milliseconds.
+            //! \returns The world state, which won't meet the condition if the time ran out.
+            WorldState step(std::string command, const WorldStateCondition& condition, int timeout_ms);
+
+            //! Gets the times from sending each command to receiving the first observation after it, over all commands sent since the last reset.
+            //! \returns A copy of the histogram of the latencies.
+            LatencyHistogram getCommandToObservationLatencies() const;
+
+            //! Gets the times from sending each command to receiving the first video frame after it, over all commands sent since the last reset.
+            //! \returns A copy of the histogram of the latencies.
+            LatencyHistogram getCommandToFrameLatencies() const;
+
+            //! Empties the command-to-observation and command-to-frame latency histograms.
+            void resetLatencies();
+
             //! Gets the temporary directory being used for the mission record, if recording is taking place.
             //! \returns The temporary directory for the mission record, or an empty string if no recording is going on.
             std::string getRecordingTemporaryDirectory() const;
@@ -137,6 +217,38 @@ namespace malmo
             //! \param videoPolicy How you want to deal with multiple video frames coming in asynchronously.
             void setVideoPolicy(VideoPolicy videoPolicy);
 
+            //! Specifies how the video frames should be transformed (cropped, resized, etc.) before being put into the world state.
+            //! Takes effect from the next call to startMission. Recordings still get the original frames.
+            //! \param preprocessor The transformations to apply.
+            void setVideoPreprocessor(const FramePreprocessor& preprocessor);
+
+            //! Specifies whether frames from the different video streams should be grouped into bundles of frames rendered together.
+            //! Takes effect from the next call to startMission. The bundles are put in WorldState::video_bundles, as well as the frames in WorldState::video_frames.
+            //! \param align Whether to group the frames.
+            //! \param max_time_difference_ms How far apart, in milliseconds, the arrival of frames in the same bundle may be.
+            void setVideoAlignment(bool align, int max_time_difference_ms);
+
+            //! Specifies whether the client may send video frames through shared memory rather than over TCP, when it is on the same machine.
+            //! Takes effect from the next call to startMission. Off by default. Ignored on platforms without POSIX shared memory.
+            //! \param use Whether to offer shared memory to clients on the same machine.
+            void setSharedMemoryVideo(bool use);
+
+            //! Specifies whether the client may connect to the agent (and the agent to the client) through UNIX-domain sockets rather than TCP, when they are on the same machine.
+            //! Takes effect from the next call to startMission. Off by default. The TCP ports stay open as a fallback. Ignored on platforms without UNIX-domain sockets.
+            //! \param use Whether to offer UNIX-domain sockets to clients on the same machine.
+            void setLocalSockets(bool use);
+
+            //! Specifies how many of the most recent frames of each video stream to keep in a frame stack.
+            //! Takes effect from the next call to startMission, which empties the stacks.
+            //! \param depth The number of frames to keep, or zero (the default) to keep no stacks.
+            void setFrameStackDepth(int depth);
+
+            //! Gets a snapshot of the frame stack for one of the video streams.
+            //! Holds the frames after any preprocessing - see setVideoPreprocessor.
+            //! \param frametype The video stream.
+            //! \returns The frame stack, which is empty unless setFrameStackDepth has been called.
+            FrameStack getFrameStack(TimestampedVideoFrame::FrameType frametype) const;
+
             //! Specifies how you want to deal with multiple rewards.
             //! \param rewardsPolicy How you want to deal with multiple rewards coming in asynchronously.
             void setRewardsPolicy(RewardsPolicy rewardsPolicy);
@@ -144,6 +256,53 @@ namespace malmo
             //! Specifies how you want to deal with multiple observations.
             //! \param observationsPolicy How you want to deal with multiple observations coming in asynchronously.
             void setObservationsPolicy(ObservationsPolicy observationsPolicy);
+
+            //! Limits how many video frames are kept under KEEP_ALL_FRAMES, so that an agent that falls behind doesn't run out of memory.
+            //! Dropped frames are counted in WorldState::number_of_video_frames_dropped_since_last_state. Bundles are limited in the same way.
+            //! Takes effect from the next call to startMission.
+            //! \param max_frames The most frames that may be waiting to be taken, or 0 for no limit (the default).
+            //! \param overflow Which frames to drop when there are too many.
+            void setVideoFramesLimit(int max_frames, OverflowPolicy overflow);
+
+            //! Limits how many rewards are kept under KEEP_ALL_REWARDS, so that an agent that falls behind doesn't run out of memory.
+            //! Dropped rewards are counted in WorldState::number_of_rewards_dropped_since_last_state. Takes effect from the next call to startMission.
+            //! \param max_rewards The most rewards that may be waiting to be taken, or 0 for no limit (the default).
+            //! \param overflow Which rewards to drop when there are too many.
+            void setRewardsLimit(int max_rewards, OverflowPolicy overflow);
+
+            //! Limits how many observations are kept under KEEP_ALL_OBSERVATIONS, so that an agent that falls behind doesn't run out of memory.
+            //! Dropped observations are counted in WorldState::number_of_observations_dropped_since_last_state. Takes effect from the next call to startMission.
+            //! \param max_observations The most observations that may be waiting to be taken, or 0 for no limit (the default).
+            //! \param overflow Which observations to drop when there are too many.
+            void setObservationsLimit(int max_observations, OverflowPolicy overflow);
+
+            typedef boost::function<void(boost::shared_ptr<TimestampedVideoFrame>)> FrameCallback;
+            typedef boost::function<void(boost::shared_ptr<TimestampedString>)> StringCallback;
+            typedef boost::function<void(boost::shared_ptr<TimestampedReward>)> RewardCallback;
+
+            //! Specifies how the callbacks are run. Each kind of callback runs one at a time, in order, but different kinds can run in parallel.
+            //! If callbacks of one kind are waiting faster than they can run, new ones are dropped, so a slow callback never holds up the network.
+            //! By default there is one thread, and up to 100 callbacks of each kind may be waiting. Callbacks waiting when this is called are dropped,
+            //! and this waits for any that are running to finish.
+            //! \param num_threads The number of threads to run the callbacks on.
+            //! \param max_queued_callbacks The most callbacks of each kind that may be waiting to run.
+            void setCallbackThreads(int num_threads, int max_queued_callbacks);
+
+            //! Specifies a function to call with each video frame as it arrives, from any of the video streams. Frames still go into the world state too.
+            //! \param callback The function, which is run on the callback threads. Pass an empty function to stop the calls.
+            void setFrameCallback(FrameCallback callback);
+
+            //! Specifies a function to call with each observation as it arrives. Observations still go into the world state too.
+            //! \param callback The function, which is run on the callback threads. Pass an empty function to stop the calls.
+            void setObservationCallback(StringCallback callback);
+
+            //! Specifies a function to call with each reward as it arrives (before any summing). Rewards still go into the world state too.
+            //! \param callback The function, which is run on the callback threads. Pass an empty function to stop the calls.
+            void setRewardCallback(RewardCallback callback);
+
+            //! Specifies a function to call with the MissionEnded message when the mission ends.
+            //! \param callback The function, which is run on the callback threads. Pass an empty function to stop the calls.
+            void setMissionEndedCallback(StringCallback callback);
             
             //! Sends a command to the game client.
             //! See the mission handlers documentation for the permitted commands for your chosen command handler.
@@ -156,6 +315,11 @@ namespace malmo
             //! \param key The command-key (provided via observations) which must match in order for the command to be processed.
             void sendCommand(std::string command, std::string key);
 
+            //! Sends several commands to the game client at once. They leave together in a single write, rather than one write per command.
+            //! See the mission handlers documentation for the permitted commands for your chosen command handler.
+            //! \param commands The commands to send, in order. e.g. "move 1", "turn 0.3", "attack 1"
+            void sendCommands(const std::vector<std::string>& commands);
+
             //! Returns a pointer to the current MissionInitSpec, to allow retrieval of the ports being used.
             //! (If port 0 is requested this means bind to any port that is available.)
             //! \returns A shared pointer to the MissionInitSpec.
@@ -163,15 +327,58 @@ namespace malmo
             const boost::shared_ptr<MissionInitSpec> getMissionInit() const;
 
             friend std::ostream& operator<<(std::ostream& os, const AgentHost& ah);
+            friend class VectorAgentHost;
         private:
 
+            // Wakes whoever is waiting for new messages. Agent hosts in a VectorAgentHost share one, so it can wait on all of them at once.
+            // A waiter reads the sequence, checks the world state without holding the mutex, then only sleeps if the sequence
+            // hasn't moved on since - so producers are never held up by a waiter that is collecting.
+            struct WorldStateSignal
+            {
+                WorldStateSignal() : waiters(0), sequence(0) {}
+
+                //! Waits until the sequence moves on from seen.
+                //! \returns False if the deadline passed first.
+                bool waitForChange(unsigned int seen, const boost::system_time& deadline)
+                {
+                    boost::unique_lock<boost::mutex> lock(this->mutex);
+                    while (this->sequence.load(std::memory_order_relaxed) == seen) {
+                        if (!this->changed.timed_wait(lock, deadline))
+                            return this->sequence.load(std::memory_order_relaxed) != seen;
+                    }
+                    return true;
+                }
+
+                std::atomic<int> waiters;               // the producers only take the mutex to notify when someone is waiting
+                std::atomic<unsigned int> sequence;     // moved on, under the mutex, by each notification
+                boost::mutex mutex;
+                boost::condition_variable changed;
+            };
+
+            // How much had arrived when a step's command was sent; only what arrives after it counts towards the step's condition.
+            struct StepBaseline
+            {
+                int observations;
+                int rewards;
+                int video_frames;
+                std::vector<int> video_frames_by_type;
+                std::size_t mission_control_messages;
+                std::size_t errors;
+            };
+
+            // Creates an agent host whose servers run on an io_service that the caller runs, and stops before destroying the agent host.
+            AgentHost(boost::shared_ptr<boost::asio::io_service> io_service, boost::shared_ptr<WorldStateSignal> world_state_signal);
+
             static void testSchemasCompatible();
+            static bool pinThreadToCore(boost::thread& thread, unsigned int core);
             static std::string extractVersionNumber(std::string name);
+            static bool isLocalAddress(const std::string& address);
+            template< typename Server > bool listenOnLocalSocket(Server& server);
 
             void initializeOurServers(const MissionSpec& mission, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id);
-            std::string generateMissionInit();
+            MissionInitTemplate generateMissionInit() const;
 
-            ClientPool reserveClients(const ClientPool& client_pool, int clients_required);
+            ClientPool reserveClients(const ClientPool& client_pool, int clients_required, std::string& timeouts);
             void findClient(const ClientPool& client_pool);
             bool findServer(const ClientPool& client_pool);
 
@@ -181,19 +388,41 @@ namespace malmo
             void listenForObservations( int port );
             
             void onMissionControlMessage(TimestampedString message);
-            void onVideo(TimestampedVideoFrame message);
+            void onVideo(boost::shared_ptr<TimestampedVideoFrame> message);
             void onReward(TimestampedString message);
             void onObservation(TimestampedString message);
             
             void openCommandsConnection();
 
+            void startBackgroundThreads(int num_threads, bool pin_to_cores);
+            void stopBackgroundThreads();
+            void stopMissionStartThread();
+
+            // Runs startMission on the mission start thread for startMissionAsync, passing on its outcome.
+            void completeMissionStart(boost::shared_ptr< std::promise< boost::shared_ptr<MissionInitSpec> > > promise, const MissionSpec& mission, const ClientPool& client_pool, const MissionRecordSpec& mission_record, int role, std::string unique_experiment_id);
+
             void close();
             void closeServers();
             void closeRecording();
             
             void processReceivedReward( TimestampedReward reward );
+            void storeVideoBundles( const std::vector< boost::shared_ptr<FrameBundle> >& bundles );
+            void sendCommands(const std::vector<std::string>& commands, std::string key);
+            void addError( const TimestampedString& error_message );
+            void notifyWorldStateChanged();
+            boost::shared_ptr<CallbackDispatcher> getCallbackDispatcher();
+            template< typename Message > void dispatchCallback(int queue, const boost::shared_ptr< boost::function<void(Message)> >& callback_slot, const Message& message);
+            void applyMessageLimits();
+            void collectWorldState() const;
+            template< typename Predicate > WorldState waitUntil(int timeout_ms, Predicate is_satisfied);
+            WorldState takeWorldState();
+            StepBaseline sendStepCommand(const std::string& command);
+            bool isStepComplete(const StepBaseline& baseline, const WorldStateCondition& condition) const;
+            void recordCommandLatency(std::atomic<int64_t>& command_time, LatencyHistogram& latencies, const boost::posix_time::ptime& received);
             
-            boost::asio::io_service io_service;
+            boost::shared_ptr<boost::asio::io_service> shared_io_service;
+            boost::asio::io_service& io_service;        // *shared_io_service
+            bool owns_io_service;                       // false if the io_service and its threads belong to a VectorAgentHost
             boost::shared_ptr<StringServer>   mission_control_server;
             boost::shared_ptr<VideoServer>    video_server;
             boost::shared_ptr<VideoServer>    depth_server;
@@ -203,16 +432,87 @@ namespace malmo
             boost::shared_ptr<StringServer>   observations_server;
             boost::optional<boost::asio::io_service::work> work;
             std::vector<boost::shared_ptr<boost::thread>> background_threads;
-
+            boost::mutex background_threads_mutex;
+
+            // Runs the negotiations for startMissionAsync one at a time, so that they don't hold up an io thread (started by the first call):
+            boost::asio::io_service mission_start_service;
+            boost::optional<boost::asio::io_service::work> mission_start_work;
+            boost::thread mission_start_thread;
+            boost::mutex mission_start_mutex;
+
+            ControlConnectionPool control_connections;  // kept open to the clients' mission control ports between missions
+            int client_connect_timeout_ms;
+            int client_reply_timeout_ms;
+            int mission_init_timeout_ms;
+            ClientInfo mission_client;                              // the client that accepted the current mission,
+            boost::shared_ptr<ClientHealth> mission_client_health;  // the record to note how the mission went in,
+            boost::posix_time::ptime mission_accepted_time;         // and when it was accepted
             boost::shared_ptr<ClientConnection> commands_connection;
             std::ofstream commands_stream;
 
             VideoPolicy        video_policy;
             RewardsPolicy      rewards_policy;
             ObservationsPolicy observations_policy;
+            int                video_frames_limit;
+            OverflowPolicy     video_frames_overflow;
+            int                rewards_limit;
+            OverflowPolicy     rewards_overflow;
+            int                observations_limit;
+            OverflowPolicy     observations_overflow;
+            FramePreprocessor  video_preprocessor;
+            int                frame_stack_depth;
+            bool               align_video;
+            int                video_alignment_ms;
+            FrameAligner       video_aligner;
+            boost::mutex       video_aligner_mutex;
+            bool               use_shared_memory_video;
+            std::string        shared_memory_prefix;
+            bool               use_local_sockets;
+            std::string        local_socket_prefix;
+
+            std::vector<FrameStack> frame_stacks;
+            mutable boost::mutex frame_stacks_mutex;
             
-            WorldState world_state;
-            mutable boost::mutex world_state_mutex;
+            // Each kind of message reaches the world state through its own channel, so the network threads never wait for the agent or
+            // for each other. The channels are only emptied into world_state (applying the policies) when the agent asks for the world state.
+            mutable MessageChannel< boost::shared_ptr<TimestampedVideoFrame> > video_channel;
+            mutable MessageChannel< boost::shared_ptr<FrameBundle> >           video_bundle_channel;
+            mutable MessageChannel< boost::shared_ptr<TimestampedReward> >     reward_channel;
+            mutable MessageChannel< boost::shared_ptr<TimestampedString> >     observation_channel;
+            mutable MessageChannel< boost::shared_ptr<TimestampedString> >     mission_control_channel;
+            mutable MessageChannel< boost::shared_ptr<TimestampedString> >     error_channel;
+            std::atomic<int>  incomplete_video_bundles;
+            std::atomic<int>  video_frames_received_by_type[TimestampedVideoFrame::_MAX_FRAME_TYPE];
+            std::atomic<bool> is_mission_running;
+            std::atomic<bool> has_mission_begun;
+
+            mutable WorldState world_state;
+            mutable boost::mutex world_state_mutex;     // only taken by the agent's calls, to collect and copy the world state
+            mutable std::vector<int> video_frames_by_type_since_last_state;
+            // (Storage for emptying the channels into, kept from one collection to the next.)
+            mutable std::vector< boost::shared_ptr<TimestampedVideoFrame> > received_frames;
+            mutable std::vector< boost::shared_ptr<FrameBundle> >           received_bundles;
+            mutable std::vector< boost::shared_ptr<TimestampedReward> >     received_rewards;
+            mutable std::vector< boost::shared_ptr<TimestampedString> >     received_strings;
+            boost::mutex mission_mutex;                 // serializes starting a mission, mission control messages and sending commands
+
+            // The callbacks are swapped atomically, so the network threads never wait to read them.
+            enum CallbackQueue { FRAME_CALLBACKS, OBSERVATION_CALLBACKS, REWARD_CALLBACKS, MISSION_ENDED_CALLBACKS, NUM_CALLBACK_QUEUES };
+            boost::shared_ptr<CallbackDispatcher> callback_dispatcher;
+            boost::mutex callback_dispatcher_mutex;
+            boost::shared_ptr<FrameCallback> frame_callback;
+            boost::shared_ptr<StringCallback> observation_callback;
+            boost::shared_ptr<RewardCallback> reward_callback;
+            boost::shared_ptr<StringCallback> mission_ended_callback;
+
+            // waitForWorldState sleeps on this until new messages arrive.
+            boost::shared_ptr<WorldStateSignal> world_state_signal;
+
+            // When the last command was sent, in microseconds since the epoch, until the first observation (or frame) after it claims it; 0 when claimed.
+            std::atomic<int64_t> command_time_awaiting_observation;
+            std::atomic<int64_t> command_time_awaiting_frame;
+            LatencyHistogram command_to_observation_latencies;
+            LatencyHistogram command_to_frame_latencies;
             
             boost::shared_ptr<MissionInitSpec> current_mission_init;
             boost::shared_ptr<MissionRecord> current_mission_record;
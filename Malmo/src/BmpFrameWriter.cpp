@@ -63,7 +63,8 @@ namespace malmo
 
         void addFrame(const TimestampedVideoFrame& frame)
         {
-            if (!this->tarball || frame.pixels.size() + this->unzipped_byte_count > this->max_tar_size)
+            const std::vector<unsigned char>& pixels = frame.getPixels();
+            if (!this->tarball || pixels.size() + this->unzipped_byte_count > this->max_tar_size)
                 reset();
 
             std::stringstream frame_name;
@@ -82,8 +83,8 @@ namespace malmo
                 std::string magic_number = (frame.channels == 1) ? "P5" : "P6";
                 frame_header << magic_number << "\n" << frame.width << " " << frame.height << "\n255\n";
                 std::string header = frame_header.str();
-                this->tarball->putMemWithHeader(header.c_str(), header.length(), reinterpret_cast<const char*>(&(frame.pixels[0])), frame.pixels.size(), frame_name.str().c_str());
-                this->unzipped_byte_count += header.length() + frame.pixels.size();
+                this->tarball->putMemWithHeader(header.c_str(), header.length(), reinterpret_cast<const char*>(&(pixels[0])), pixels.size(), frame_name.str().c_str());
+                this->unzipped_byte_count += header.length() + pixels.size();
             }
             else if (this->numpy_format)
             {
@@ -122,8 +123,8 @@ namespace malmo
                 frame_header << pydict.str();
                 std::string header = frame_header.str();
                 // Now store the data, with this header:
-                this->tarball->putMemWithHeader(header.c_str(), header.length(), reinterpret_cast<const char*>(&(frame.pixels[0])), frame.pixels.size(), frame_name.str().c_str());
-                this->unzipped_byte_count += header.length() + frame.pixels.size();
+                this->tarball->putMemWithHeader(header.c_str(), header.length(), reinterpret_cast<const char*>(&(pixels[0])), pixels.size(), frame_name.str().c_str());
+                this->unzipped_byte_count += header.length() + pixels.size();
             }
             else
             {
@@ -137,10 +138,10 @@ namespace malmo
                 int offset_a = frame.width * frame.height * 3;
                 for (int i = 0; i < frame.width*frame.height; i++)
                 {
-                    out_pixels[offset_rgb] = frame.pixels[i * 4];
-                    out_pixels[offset_rgb + 1] = frame.pixels[i * 4 + 1];
-                    out_pixels[offset_rgb + 2] = frame.pixels[i * 4 + 2];
-                    out_pixels[offset_a] = frame.pixels[i * 4 + 3];   // copy alpha value
+                    out_pixels[offset_rgb] = pixels[i * 4];
+                    out_pixels[offset_rgb + 1] = pixels[i * 4 + 1];
+                    out_pixels[offset_rgb + 2] = pixels[i * 4 + 2];
+                    out_pixels[offset_a] = pixels[i * 4 + 3];   // copy alpha value
                     offset_rgb += 3;
                     offset_a += 1;
                 }
@@ -160,7 +161,7 @@ namespace malmo
                 rgb_frame_header << "P6" << "\n" << frame.width << " " << frame.height << "\n255\n";
                 header = rgb_frame_header.str();
                 this->tarball->putMemWithHeader(header.c_str(), header.length(), reinterpret_cast<const char*>(&(out_pixels[0])), frame.width * frame.height * 3, rgb_frame_name.str().c_str());
-                this->unzipped_byte_count += 2 * header.length() + frame.pixels.size();
+                this->unzipped_byte_count += 2 * header.length() + pixels.size();
                 delete[] out_pixels;
             }
             this->frame_count++;
@@ -277,7 +278,7 @@ namespace malmo
                 }
             }
             while (true) {
-                TimestampedVideoFrame frame;
+                boost::shared_ptr<TimestampedVideoFrame> frame;
                 {
                     boost::lock_guard<boost::mutex> buffer_guard(this->frame_buffer_mutex);
 
@@ -292,14 +293,14 @@ namespace malmo
                     }
                 }
                 // Write frame into tarball:
-                LOGTRACE(LT("Tarring frame "), tarrer.getFrameCount() + 1, LT(", "), frame.width, LT("x"), frame.height, LT("x"), frame.channels);
-                tarrer.addFrame(frame);
+                LOGTRACE(LT("Tarring frame "), tarrer.getFrameCount() + 1, LT(", "), frame->width, LT("x"), frame->height, LT("x"), frame->channels);
+                tarrer.addFrame(*frame);
                 // And add details to index files:
                 std::stringstream name;
                 name << "frame_" << std::setfill('0') << std::setw(6) << tarrer.getFrameCount();
                 std::stringstream posdata;
-                posdata << "xyzyp: " << frame.xPos << " " << frame.yPos << " " << frame.zPos << " " << frame.yaw << " " << frame.pitch;
-                this->frame_info_stream << boost::posix_time::to_iso_string(frame.timestamp) << " " << name.str() << " " << posdata.str() << std::endl;
+                posdata << "xyzyp: " << frame->xPos << " " << frame->yPos << " " << frame->zPos << " " << frame->yaw << " " << frame->pitch;
+                this->frame_info_stream << boost::posix_time::to_iso_string(frame->timestamp) << " " << name.str() << " " << posdata.str() << std::endl;
                 this->frames_actually_written++;
             }
         }
@@ -308,15 +309,15 @@ namespace malmo
         this->frame_info_stream.flush();
     }
 
-    bool BmpFrameWriter::write(TimestampedVideoFrame frame)
+    bool BmpFrameWriter::write(boost::shared_ptr<TimestampedVideoFrame> frame)
     {
-        this->last_timestamp = frame.timestamp;
+        this->last_timestamp = frame->timestamp;
         bool addedFrame = false;
         {
             boost::lock_guard<boost::mutex> buffer_guard(this->frame_buffer_mutex);
             // Drop the frame if our buffer has reached a certain size.
             if (this->frame_buffer.size() < 300) {
-                LOGTRACE(LT("Pushing frame "), this->frame_index, LT(", "), frame.width, LT("x"), frame.height, LT("x"), frame.channels, LT(" to write buffer."));
+                LOGTRACE(LT("Pushing frame "), this->frame_index, LT(", "), frame->width, LT("x"), frame->height, LT("x"), frame->channels, LT(" to write buffer."));
                 this->frame_buffer.push(frame);
                 this->frame_index++;
                 addedFrame = true;
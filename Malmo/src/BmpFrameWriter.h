@@ -45,7 +45,7 @@ namespace malmo
         virtual void open();
         virtual void close();
         
-        virtual bool write(TimestampedVideoFrame frame);
+        virtual bool write(boost::shared_ptr<TimestampedVideoFrame> frame);
         virtual bool isOpen() const;
         virtual size_t getFrameWriteCount() const { return frames_actually_written; }
 
@@ -68,7 +68,7 @@ namespace malmo
         int frame_index;
         int frames_actually_written = 0;
 
-        std::queue<TimestampedVideoFrame> frame_buffer;
+        std::queue< boost::shared_ptr<TimestampedVideoFrame> > frame_buffer;
         boost::mutex write_mutex;
         boost::mutex frame_buffer_mutex;
         boost::mutex frames_available_mutex;
@@ -48,15 +48,18 @@
 %shared_ptr(TimestampedVideoFrame)
 %shared_ptr(TimestampedReward)
 %shared_ptr(TimestampedString)
+%shared_ptr(FrameBundle)
 
 %template(TimestampedVideoFramePtr) boost::shared_ptr< TimestampedVideoFrame >;
 %template(TimestampedRewardPtr)     boost::shared_ptr< TimestampedReward >;
 %template(TimestampedStringPtr)     boost::shared_ptr< TimestampedString >;
+%template(FrameBundlePtr)           boost::shared_ptr< FrameBundle >;
 
 %template(StringVector)                std::vector< std::string >;
 %template(TimestampedVideoFrameVector) std::vector< boost::shared_ptr< TimestampedVideoFrame > >;
 %template(TimestampedRewardVector)     std::vector< boost::shared_ptr< TimestampedReward > >;
 %template(TimestampedStringVector)     std::vector< boost::shared_ptr< TimestampedString > >;
+%template(FrameBundleVector)           std::vector< boost::shared_ptr< FrameBundle > >;
 %template(ByteVector)                  std::vector<unsigned char>;
 
 namespace boost::posix_time
@@ -191,6 +194,70 @@ public:
     std::string getMessage() const;
 };
 
+class FramePreprocessor
+{
+public:
+  enum ResizeFilter {
+    AREA
+    , BILINEAR
+  };
+
+  FramePreprocessor();
+  void crop(short x, short y, short width, short height);
+  void resize(short width, short height);
+  void resize(short width, short height, ResizeFilter filter);
+  void convertToGrayscale();
+  void reorderToChannelsFirst();
+  void convertToFloat();
+  void convertToFloat(float scale, float offset);
+};
+
+class FrameStack
+{
+public:
+  FrameStack();
+  FrameStack(int depth);
+  int getDepth() const;
+  int getCount() const;
+  short getWidth() const;
+  short getHeight() const;
+  short getChannels() const;
+  bool isFloat() const;
+  std::size_t getFrameSize() const;
+
+  %exception getSlot %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  int getSlot(int age) const;
+
+  %exception getNewestSlot %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  int getNewestSlot() const;
+
+  %exception getTimestamp %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  boost::posix_time::ptime getTimestamp(int slot) const;
+
+  const std::vector<unsigned char>& getData() const;
+};
+
 class MissionRecordSpec
 {
 public:
@@ -244,6 +311,8 @@ public:
 class WorldState
 {
 public:
+  WorldState();
+
   const bool is_mission_running;
 
   const bool has_mission_begun;
@@ -254,8 +323,18 @@ public:
 
   const int number_of_observations_since_last_state;
 
+  const int number_of_video_frames_dropped_since_last_state;
+
+  const int number_of_rewards_dropped_since_last_state;
+
+  const int number_of_observations_dropped_since_last_state;
+
   const std::vector< boost::shared_ptr< TimestampedVideoFrame > > video_frames;
 
+  const int number_of_incomplete_video_bundles_since_last_state;
+
+  const std::vector< boost::shared_ptr< FrameBundle > > video_bundles;
+
   const std::vector< boost::shared_ptr< TimestampedReward > > rewards;
 
   const std::vector< boost::shared_ptr< TimestampedString > > observations;
@@ -265,6 +344,39 @@ public:
   const std::vector< boost::shared_ptr< TimestampedString > > errors;
 };
 
+class WorldStateCondition
+{
+public:
+  enum Combination {
+    ANY
+    , ALL
+  };
+
+  WorldStateCondition();
+  WorldStateCondition(Combination combination);
+  void requireObservations(int count);
+  void requireRewards(int count);
+  void requireVideoFrames(int count);
+  void requireVideoFramesOfType(TimestampedVideoFrame::FrameType frametype, int count);
+  void requireMissionBegun();
+  void requireMissionEnded();
+};
+
+class LatencyHistogram
+{
+public:
+  static const int NUM_BUCKETS = 104;
+
+  LatencyHistogram();
+  void reset();
+  int getCount() const;
+  double getMeanMs() const;
+  double getMinMs() const;
+  double getMaxMs() const;
+  double getPercentileMs(double percentile) const;
+  static double getBucketUpperBoundMs(int bucket);
+};
+
 class AgentHost : public ArgumentParser {
 public:
   enum VideoPolicy { 
@@ -283,6 +395,11 @@ public:
   , KEEP_ALL_OBSERVATIONS      
   };
 
+  enum OverflowPolicy {
+    DROP_OLDEST
+  , DROP_NEWEST
+  };
+
   AgentHost();
 
   void startMission(
@@ -304,16 +421,108 @@ public:
   
   WorldState getWorldState();
 
+  WorldState waitForWorldState(int timeout_ms, const WorldStateCondition& condition);
+
+  void swapWorldState(WorldState& world_state);
+
+  WorldState step(std::string command, const WorldStateCondition& condition, int timeout_ms);
+
+  LatencyHistogram getCommandToObservationLatencies() const;
+
+  LatencyHistogram getCommandToFrameLatencies() const;
+
+  void resetLatencies();
+
+  %exception setNumberOfIoThreads %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setNumberOfIoThreads(int num_threads, bool pin_to_cores);
+
+  %exception setClientTimeouts %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setClientTimeouts(int connect_timeout_ms, int reply_timeout_ms, int mission_init_timeout_ms);
+
   void setVideoPolicy(VideoPolicy videoPolicy);
 
   void setRewardsPolicy(RewardsPolicy rewardsPolicy);
 
   void setObservationsPolicy(ObservationsPolicy observationsPolicy);
 
+  %exception setVideoFramesLimit %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setVideoFramesLimit(int max_frames, OverflowPolicy overflow);
+
+  %exception setRewardsLimit %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setRewardsLimit(int max_rewards, OverflowPolicy overflow);
+
+  %exception setObservationsLimit %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setObservationsLimit(int max_observations, OverflowPolicy overflow);
+
+  void setVideoPreprocessor(const FramePreprocessor& preprocessor);
+
+  %exception setVideoAlignment %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setVideoAlignment(bool align, int max_time_difference_ms);
+
+  void setSharedMemoryVideo(bool use);
+
+  void setLocalSockets(bool use);
+
+  %exception setFrameStackDepth %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  void setFrameStackDepth(int depth);
+
+  FrameStack getFrameStack(TimestampedVideoFrame::FrameType frametype) const;
+
   void sendCommand(std::string command);
 
   void sendCommand(std::string command, std::string key);
 
+  void sendCommands(const std::vector<std::string>& commands);
+
   std::string getRecordingTemporaryDirectory();
 
   void setDebugOutput(bool debug);
@@ -512,13 +721,58 @@ struct TimestampedReward {
 
 struct TimestampedUnsignedCharVector {
   const boost::posix_time::ptime timestamp;
+};
+
+class FrameView {
+public:
+  short getWidth() const;
+
+  short getHeight() const;
+
+  short getChannels() const;
+
+  long long getRowStride() const;
+
+  long long getPixelStride() const;
+
+  bool isPacked() const;
 
-  const std::vector<unsigned char> data;
+  %exception getValue %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  unsigned char getValue(int x, int y, int channel) const;
+
+  %exception crop %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  FrameView crop(int x, int y, int width, int height) const;
+
+  %exception subsample %{
+    try {
+      $action
+    } catch (std::exception& e) {
+      SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+    }
+  %}
+
+  FrameView subsample(int step) const;
+
+  std::vector<unsigned char> packed() const;
 };
 
 struct TimestampedVideoFrame {
 private:
-  TimestampedVideoFrame(short width, short height, short channels, TimestampedUnsignedCharVector& message);
+  TimestampedVideoFrame(short width, short height, short channels, const TimestampedUnsignedCharVector& message);
 
 public:
     enum FrameType {
@@ -548,7 +802,42 @@ public:
 
   const FrameType frametype;
 
+  const bool channels_first;
+
+  const bool float_pixels;
+
+  FrameView getView() const;
+};
+
+%extend TimestampedVideoFrame {
+  // The pixels are packed on first use, so expose them through the accessor. (SWIG gets class-typed members by pointer.)
   const std::vector<unsigned char> pixels;
+}
+%{
+  const std::vector<unsigned char>* TimestampedVideoFrame_pixels_get(TimestampedVideoFrame* frame) { return &frame->getPixels(); }
+%}
+
+%nodefaultctor FrameBundle;
+struct FrameBundle {
+  const boost::posix_time::ptime timestamp;
+
+  const float xPos;
+
+  const float yPos;
+
+  const float zPos;
+
+  const float yaw;
+
+  const float pitch;
+
+  const bool is_complete;
+
+  bool hasFrame(TimestampedVideoFrame::FrameType frametype) const;
+
+  boost::shared_ptr<TimestampedVideoFrame> getFrame(TimestampedVideoFrame::FrameType frametype) const;
+
+  int getNumberOfFrames() const;
 };
 
 struct ClientInfo {
@@ -563,9 +852,38 @@ public:
     int command_port;
 };
 
+struct ClientRecord {
+public:
+    ClientRecord();
+
+    int replies;
+    double latency_ms;
+    double recent_busy;
+    double recent_failures;
+    int missions_completed;
+    double mission_seconds;
+
+    double getExpectedDelayMs() const;
+    double getMissionsPerHour() const;
+};
+
 class ClientPool {
 public:
     void add( const ClientInfo& client_info );
+
+    ClientRecord getClientRecord( const ClientInfo& client_info ) const;
+
+    %exception startHealthProbes %{
+      try {
+        $action
+      } catch (std::exception& e) {
+        SWIG_CSharpSetPendingException(SWIG_CSharpApplicationException, e.what());
+      }
+    %}
+
+    void startHealthProbes( int interval_ms, int timeout_ms );
+
+    void stopHealthProbes();
 };
 
 class ParameterSet{
@@ -0,0 +1,110 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "CallbackDispatcher.h"
+#include "Logger.h"
+
+// Boost:
+#include <boost/make_shared.hpp>
+#include <boost/utility/in_place_factory.hpp>
+
+// STL:
+#include <exception>
+#include <stdexcept>
+
+#define LOG_COMPONENT Logger::LOG_AGENTHOST
+
+namespace malmo
+{
+    CallbackDispatcher::Queue::Queue(boost::asio::io_service& io_service)
+        : strand(io_service)
+        , queued(0)
+        , dropped(0)
+    {
+    }
+
+    CallbackDispatcher::CallbackDispatcher(int num_threads, int num_queues, int max_queued)
+        : state(boost::make_shared<State>())
+        , max_queued(max_queued)
+    {
+        if (num_threads < 1)
+            throw std::invalid_argument("Need at least one callback thread.");
+        if (max_queued < 1)
+            throw std::invalid_argument("Need room for at least one callback in each queue.");
+
+        for (int i = 0; i < num_queues; i++)
+            this->state->queues.push_back(boost::make_shared<Queue>(boost::ref(this->state->io_service)));
+        this->state->work = boost::in_place(boost::ref(this->state->io_service));
+
+        boost::shared_ptr<State> state = this->state;
+        for (int i = 0; i < num_threads; i++)
+            this->threads.push_back(boost::make_shared<boost::thread>([state]() { state->io_service.run(); }));
+    }
+
+    CallbackDispatcher::~CallbackDispatcher()
+    {
+        stop();
+    }
+
+    void CallbackDispatcher::stop()
+    {
+        this->state->work = boost::none;
+        this->state->io_service.stop();
+        for (auto& thread : this->threads) {
+            if (thread->get_id() == boost::this_thread::get_id())
+                thread->detach();   // (We're in one of its callbacks, so it can't be joined. All it does after the callback is return.)
+            else if (thread->joinable())
+                thread->join();
+        }
+    }
+
+    bool CallbackDispatcher::post(int queue, boost::function<void()> callback)
+    {
+        Queue* q = this->state->queues.at(queue).get();
+        if (q->queued.fetch_add(1) >= this->max_queued) {
+            q->queued--;
+            q->dropped++;
+            return false;
+        }
+        q->strand.post([q, callback]() { run(q, callback); });
+        return true;
+    }
+
+    int CallbackDispatcher::getDroppedCount(int queue) const
+    {
+        return this->state->queues.at(queue)->dropped;
+    }
+
+    void CallbackDispatcher::run(Queue* queue, const boost::function<void()>& callback)
+    {
+        try {
+            callback();
+        }
+        catch (const std::exception& e) {
+            LOGERROR(LT("Callback threw an exception: "), e.what());
+        }
+        catch (...) {
+            LOGERROR(LT("Callback threw an unknown exception."));
+        }
+        queue->queued--;
+    }
+}
+
+#undef LOG_COMPONENT
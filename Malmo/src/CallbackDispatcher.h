@@ -0,0 +1,96 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _CALLBACKDISPATCHER_H_
+#define _CALLBACKDISPATCHER_H_
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <atomic>
+#include <vector>
+
+namespace malmo
+{
+    //! Runs callbacks on a pool of threads of its own, so that a slow callback can't hold up the threads that are receiving messages.
+    //! Callbacks are posted to numbered queues. Those in one queue run one at a time, in the order they were posted; different queues run in parallel.
+    //! Each queue is bounded: a callback posted to a full queue is dropped rather than waiting for room.
+    class CallbackDispatcher
+    {
+        public:
+
+            //! Starts the threads.
+            //! \param num_threads The number of threads to run the callbacks on.
+            //! \param num_queues The number of queues.
+            //! \param max_queued The most callbacks that may be waiting or running in each queue.
+            CallbackDispatcher(int num_threads, int num_queues, int max_queued);
+
+            //! Stops the threads, as stop() does.
+            ~CallbackDispatcher();
+
+            //! Stops the threads, waiting for any callbacks that are running to finish. Callbacks that haven't started are dropped.
+            //! Since it waits, call this before letting go of the dispatcher on a thread that mustn't be held up.
+            //! If called from a callback, the thread running it is left to finish the callback after this returns.
+            void stop();
+
+            //! Queues a callback. Can be called from any thread.
+            //! \param queue The number of the queue.
+            //! \param callback The callback. Exceptions it throws are logged.
+            //! \returns False if the queue was full, in which case the callback was dropped.
+            bool post(int queue, boost::function<void()> callback);
+
+            //! Gets the number of callbacks that have been dropped from a queue because it was full.
+            //! \param queue The number of the queue.
+            int getDroppedCount(int queue) const;
+
+        private:
+
+            struct Queue
+            {
+                Queue(boost::asio::io_service& io_service);
+                boost::asio::io_service::strand strand;
+                std::atomic<int> queued;
+                std::atomic<int> dropped;
+            };
+
+            // Shared with the threads, in case one is still running a callback when we are destroyed.
+            struct State
+            {
+                boost::asio::io_service io_service;
+                boost::optional<boost::asio::io_service::work> work;
+                std::vector< boost::shared_ptr<Queue> > queues;
+            };
+
+            static void run(Queue* queue, const boost::function<void()>& callback);
+
+            CallbackDispatcher(const CallbackDispatcher&);
+            CallbackDispatcher& operator=(const CallbackDispatcher&);
+
+            boost::shared_ptr<State> state;
+            std::vector< boost::shared_ptr<boost::thread> > threads;
+            const int max_queued;
+    };
+}
+
+#endif
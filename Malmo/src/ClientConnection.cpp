@@ -30,18 +30,34 @@ namespace malmo
 {
     boost::shared_ptr< ClientConnection > ClientConnection::create( boost::asio::io_service& io_service, std::string address, int port )
     {
-        return boost::shared_ptr< ClientConnection >(new ClientConnection( io_service, address, port ) );
+        return boost::shared_ptr< ClientConnection >(new ClientConnection( io_service, address, port, "" ) );
+    }
+
+    boost::shared_ptr< ClientConnection > ClientConnection::create( boost::asio::io_service& io_service, std::string address, int port, const std::string& local_socket )
+    {
+        return boost::shared_ptr< ClientConnection >(new ClientConnection( io_service, address, port, local_socket ) );
     }
     
     void ClientConnection::send( std::string message )
     {
         //LOGTRACE(LT("Request to send "), message, LT(" to "), this->)
-        this->io_service.post( boost::bind( &ClientConnection::writeImpl, shared_from_this(), message ) );
+        this->strand.post( boost::bind( &ClientConnection::writeImpl, shared_from_this(), message ) );
+    }
+
+    void ClientConnection::send( const std::vector< std::string >& messages )
+    {
+        this->strand.post( boost::bind( &ClientConnection::writeAllImpl, shared_from_this(), messages ) );
     }
 
-    ClientConnection::ClientConnection( boost::asio::io_service& io_service, std::string address, int port )
+    ClientConnection::ClientConnection( boost::asio::io_service& io_service, std::string address, int port, const std::string& local_socket )
         : io_service( io_service )
+        , strand( io_service )
+        , writes_started( 0 )
     {
+        this->socket = boost::shared_ptr< StreamSocket >(new StreamSocket(io_service));
+        if (!local_socket.empty() && connectToLocalSocket(local_socket))
+            return;
+
         LOGTRACE(LT("Creating ClientConnection to "), address, LT(":"), port);
         // connect the socket to the requested endpoint
         boost::asio::ip::tcp::resolver resolver( io_service );
@@ -52,8 +68,17 @@ namespace malmo
             LOGERROR(LT("Failed to resolve endpoint "), address, LT(":"), port, LT(" - "), ec.message());
         try
         {
-            this->socket = std::unique_ptr< boost::asio::ip::tcp::socket >(new boost::asio::ip::tcp::socket(io_service));
-            boost::asio::ip::tcp::resolver::iterator connected_endpoint = boost::asio::connect(*this->socket, endpoint_iterator);
+            // (Connect to each in turn by hand - the generic socket can't take the resolver's entries directly.)
+            boost::asio::ip::tcp::resolver::iterator connected_endpoint = endpoint_iterator;
+            ec = boost::asio::error::host_not_found;
+            for (; connected_endpoint != boost::asio::ip::tcp::resolver::iterator(); ++connected_endpoint) {
+                this->socket->close(ec);
+                this->socket->connect(connected_endpoint->endpoint(), ec);
+                if (!ec)
+                    break;
+            }
+            if (ec)
+                throw boost::system::system_error(ec);
             LOGFINE(LT("Connected - "), connected_endpoint->service_name(), LT(" - "), connected_endpoint->host_name());
         }
         catch (boost::system::system_error e)
@@ -62,6 +87,27 @@ namespace malmo
         }
     }
     
+    bool ClientConnection::connectToLocalSocket( const std::string& local_socket )
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        LOGTRACE(LT("Creating ClientConnection to "), local_socket);
+        boost::system::error_code ec;
+        this->socket->connect(MakeLocalEndpoint(local_socket), ec);
+        if (!ec) {
+            LOGFINE(LT("Connected - "), local_socket);
+            return true;
+        }
+        LOGINFO(LT("Failed to connect to "), local_socket, LT(" - "), ec.message(), LT(" - trying TCP instead"));
+        this->socket->close(ec);
+#endif
+        return false;
+    }
+
+    int ClientConnection::getWritesStarted() const
+    {
+        return this->writes_started;
+    }
+
     ClientConnection::~ClientConnection()
     {        
     }
@@ -70,59 +116,81 @@ namespace malmo
     {
         boost::lock_guard<boost::mutex> scope_guard(this->outbox_mutex);
 
-        if (message.back() != '\n')
+        enqueue( message );
+        if ( this->sending.empty() )
+            this->write();
+    }
+
+    void ClientConnection::writeAllImpl( const std::vector< std::string >& messages )
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->outbox_mutex);
+
+        // Queue the whole batch before writing, so that it goes out in one write rather than its first message alone.
+        for( const auto& message : messages )
+            enqueue( message );
+        if ( this->sending.empty() && !this->outbox.empty() )
+            this->write();
+    }
+
+    void ClientConnection::enqueue( std::string message )
+    {
+        if (message.empty() || message.back() != '\n')
             message += '\n';
-        this->outbox.push_back( message );
-        if ( this->outbox.size() > 1 ) {
-            // outstanding write
+        this->outbox.push_back( std::move( message ) );
+        if ( !this->sending.empty() ) {
+            // outstanding write - this message will go out with the next one
             boost::system::error_code ec;
-            LOGTRACE(LT("Backlog writing to "), this->socket->remote_endpoint(ec), LT(" - "), this->outbox.size(), LT(" items awaiting send"));
+            LOGTRACE(LT("Backlog writing to "), DescribeEndpoint(this->socket->remote_endpoint(ec)), LT(" - "), this->outbox.size(), LT(" items awaiting send"));
             if (ec)
                 LOGERROR(LT("Error resolving remote endpoint: "), ec.message());
-            return;
         }
-
-        this->write();
     }
     
     void ClientConnection::write()
     {
-        const std::string& message = this->outbox.front();
+        // Send everything that's waiting in one gather write, rather than one write per message.
+        this->sending.swap( this->outbox );
+        this->sending_buffers.clear();
+        for( const auto& message : this->sending )
+            this->sending_buffers.push_back( boost::asio::buffer( message ) );
+
         boost::system::error_code ec;
-        LOGFINE(LT("About to async_write "), message, LT(" to "), this->socket->remote_endpoint(ec));
+        LOGFINE(LT("About to async_write "), this->sending.size(), LT(" messages, starting "), this->sending.front(), LT(" to "), DescribeEndpoint(this->socket->remote_endpoint(ec)));
         if (ec)
             LOGERROR(LT("Error resolving remote endpoint: "), ec.message());
+        this->writes_started++;
         boost::asio::async_write(
             *this->socket,
-            boost::asio::buffer( message ),
-            boost::bind(
+            this->sending_buffers,
+            this->strand.wrap(boost::bind(
                 &ClientConnection::wrote,
                 shared_from_this(),
                 boost::asio::placeholders::error,
                 boost::asio::placeholders::bytes_transferred
-            ) 
+            ))
         );
     }
 
     void ClientConnection::wrote( const boost::system::error_code& error,
                                   size_t bytes_transferred )
     {        
+        boost::lock_guard<boost::mutex> scope_guard(this->outbox_mutex);
         if (error)
         {
+            // (Not retried: part of the write may have got through, and sending it again would repeat those commands.)
             boost::system::error_code ec;
-            LOGERROR(LT("Failed to write to "), this->socket->remote_endpoint(ec), LT(" - transferred "), bytes_transferred, LT(" bytes - "), error.message());
+            LOGERROR(LT("Failed to write "), this->sending.size(), LT(" messages to "), DescribeEndpoint(this->socket->remote_endpoint(ec)), LT(" - transferred "), bytes_transferred, LT(" bytes - "), error.message());
             if (ec)
                 LOGERROR(LT("Error resolving remote endpoint: "), ec.message());
         }
         else
         {
             boost::system::error_code ec;
-            LOGTRACE(LT("Successfully wrote "), this->outbox.front(), LT(" to "), this->socket->remote_endpoint(ec));
+            LOGTRACE(LT("Successfully wrote "), this->sending.size(), LT(" messages ("), bytes_transferred, LT(" bytes) to "), DescribeEndpoint(this->socket->remote_endpoint(ec)));
             if (ec)
                 LOGERROR(LT("Error resolving remote endpoint: "), ec.message());
-            boost::lock_guard<boost::mutex> scope_guard(this->outbox_mutex);
-            this->outbox.pop_front();
         }
+        this->sending.clear();
         if( !this->outbox.empty() )
             this->write();  
     }
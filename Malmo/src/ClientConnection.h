@@ -20,10 +20,14 @@
 #ifndef _CLIENTCONNECTION_H_
 #define _CLIENTCONNECTION_H_
 
+// Local:
+#include "LocalSocket.h"
+
 // STL:
-#include <deque>
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Boost:
 #include <boost/asio.hpp>
@@ -32,7 +36,7 @@
 
 namespace malmo
 {
-    //! Opens a TCP connection and sends newline-terminated strings on request.
+    //! Opens a TCP (or UNIX-domain socket) connection and sends newline-terminated strings on request.
     //! If you only need to send one-off messages, use SendStringOverTCP instead.
     //! \ref SendStringOverTCP
     class ClientConnection : public boost::enable_shared_from_this< ClientConnection >
@@ -44,19 +48,40 @@ namespace malmo
             //! \param port The port of the remote endpoint.
             //! \returns The connection as a shared pointer.
             static boost::shared_ptr< ClientConnection > create( boost::asio::io_service& io_service, std::string address, int port );        
+
+            //! Opens a connection through a UNIX-domain socket, falling back to TCP if that fails.
+            //! \param address The IP address of the remote endpoint.
+            //! \param port The port of the remote endpoint.
+            //! \param local_socket The name of the UNIX-domain socket to try first - see MakeLocalEndpoint(). If empty, only TCP is tried.
+            //! \returns The connection as a shared pointer.
+            static boost::shared_ptr< ClientConnection > create( boost::asio::io_service& io_service, std::string address, int port, const std::string& local_socket );
             
             //! Sends a string over the open connection.
             //! \param message The string to send. Will have newline appended if needed.
             void send( std::string message );
+
+            //! Sends several strings over the open connection, in order. They go out in one write, along with anything else waiting to be sent.
+            //! \param messages The strings to send. Each will have newline appended if needed.
+            void send( const std::vector< std::string >& messages );
+
+            //! Gets the number of writes started on this connection so far. Each write may carry several messages.
+            //! \returns The number of writes started.
+            int getWritesStarted() const;
         
             ~ClientConnection();
             
         private:
         
-            ClientConnection( boost::asio::io_service& io_service, std::string address, int port );
+            ClientConnection( boost::asio::io_service& io_service, std::string address, int port, const std::string& local_socket );
+
+            bool connectToLocalSocket( const std::string& local_socket );
             
             void writeImpl( std::string message );
 
+            void writeAllImpl( const std::vector< std::string >& messages );
+
+            void enqueue( std::string message );
+
             void write();
 
             void wrote( const boost::system::error_code& error,
@@ -65,9 +90,14 @@ namespace malmo
             void read();
             
             boost::asio::io_service& io_service;
-            boost::shared_ptr< boost::asio::ip::tcp::socket > socket;
-            std::deque< std::string > outbox;
+            boost::asio::io_service::strand strand;     // keeps our writes in order when the io_service has several threads
+            boost::shared_ptr< StreamSocket > socket;
+            // Messages queued while a write is in progress all go out together in the next one - a single gather write of everything waiting.
+            std::vector< std::string > outbox;
+            std::vector< std::string > sending;         // being written; swapped with the outbox, so both keep their capacity
+            std::vector< boost::asio::const_buffer > sending_buffers;
             boost::mutex outbox_mutex;
+            std::atomic<int> writes_started;
     };
 }
 
@@ -0,0 +1,215 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "ClientHealth.h"
+#include "Logger.h"
+#include "TCPClient.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <algorithm>
+#include <stdexcept>
+
+#define LOG_COMPONENT Logger::LOG_TCP
+
+namespace malmo
+{
+    // How much each new time or mission length moves the moving averages.
+    static const double smoothing = 0.25;
+
+    static double smooth(double average, double sample, int previous_samples)
+    {
+        return previous_samples == 0 ? sample : average + smoothing * (sample - average);
+    }
+
+    ClientRecord::ClientRecord()
+        : connects(0)
+        , connect_ms(0)
+        , replies(0)
+        , reply_ms(0)
+        , recent_busy(0)
+        , recent_failures(0)
+        , missions_completed(0)
+        , mission_seconds(0)
+    {
+    }
+
+    double ClientRecord::getExpectedDelayMs() const
+    {
+        return this->connect_ms + this->reply_ms + this->recent_busy * ClientHealth::BUSY_PENALTY_MS + this->recent_failures * ClientHealth::FAILURE_PENALTY_MS;
+    }
+
+    double ClientRecord::getMissionsPerHour() const
+    {
+        return this->missions_completed > 0 && this->mission_seconds > 0 ? 3600.0 / this->mission_seconds : 0;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const ClientRecord& record)
+    {
+        os << "ClientRecord: " << record.connects << " connects of " << record.connect_ms << "ms, " << record.replies << " replies of " << record.reply_ms << "ms, " << record.recent_busy << " recently busy, "
+           << record.recent_failures << " recent failures, " << record.missions_completed << " missions of " << record.mission_seconds << "s";
+        return os;
+    }
+
+    ClientHealth::ClientHealth()
+        : probe_owner(0)
+        , stop_probing(false)
+    {
+    }
+
+    ClientHealth::~ClientHealth()
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->probe_thread_mutex);
+        stopProbeThread();
+    }
+
+    ClientHealth::Key ClientHealth::keyFor(const ClientInfo& client)
+    {
+        return Key(client.ip_address, client.control_port);
+    }
+
+    void ClientHealth::recordExchange(const ClientInfo& client, const ShortReply& reply, ExchangeKind kind)
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->records_mutex);
+
+        ClientRecord& record = this->records[keyFor(client)];
+        if (!reply.ok) {
+            record.recent_failures += 1;
+            return;
+        }
+        if (kind == CONNECT) {
+            record.connect_ms = smooth(record.connect_ms, reply.elapsed_ms, record.connects);
+            record.connects++;
+        }
+        else if (kind == REQUEST) {
+            record.reply_ms = smooth(record.reply_ms, reply.elapsed_ms, record.replies);
+            record.replies++;
+        }
+        record.recent_failures /= 2;
+        if (reply.reply.find("MALMOBUSY") == 0)
+            record.recent_busy += 1;
+        else if (!reply.reply.empty())
+            record.recent_busy /= 2;
+    }
+
+    void ClientHealth::recordMissionEnded(const ClientInfo& client, double seconds)
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->records_mutex);
+
+        ClientRecord& record = this->records[keyFor(client)];
+        record.mission_seconds = smooth(record.mission_seconds, seconds, record.missions_completed);
+        record.missions_completed++;
+    }
+
+    ClientRecord ClientHealth::getRecord(const ClientInfo& client) const
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->records_mutex);
+
+        auto record = this->records.find(keyFor(client));
+        return record == this->records.end() ? ClientRecord() : record->second;
+    }
+
+    std::vector<ClientInfo> ClientHealth::orderByReadiness(const std::vector<ClientInfo>& clients) const
+    {
+        std::vector<ClientRecord> client_records;
+        for (const ClientInfo& client : clients)
+            client_records.push_back(getRecord(client));
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < clients.size(); i++)
+            order.push_back(i);
+        std::stable_sort(order.begin(), order.end(), [&client_records](size_t a, size_t b) {
+            const double delay_a = client_records[a].getExpectedDelayMs();
+            const double delay_b = client_records[b].getExpectedDelayMs();
+            if (delay_a != delay_b)
+                return delay_a < delay_b;
+            return client_records[a].getMissionsPerHour() > client_records[b].getMissionsPerHour();
+        });
+
+        std::vector<ClientInfo> ordered;
+        for (size_t i : order)
+            ordered.push_back(clients[i]);
+        return ordered;
+    }
+
+    void ClientHealth::startProbing(const std::vector<ClientInfo>& clients, int interval_ms, int timeout_ms, const void* owner)
+    {
+        if (interval_ms <= 0 || timeout_ms <= 0)
+            throw std::invalid_argument("Probe interval and timeout must be positive.");
+
+        boost::lock_guard<boost::mutex> scope_guard(this->probe_thread_mutex);
+        stopProbeThread();
+        {
+            boost::lock_guard<boost::mutex> probe_guard(this->probe_mutex);
+            this->stop_probing = false;
+        }
+        this->probe_thread = boost::make_shared<boost::thread>(&ClientHealth::probe, this, clients, interval_ms, timeout_ms);
+        this->probe_owner = owner;
+    }
+
+    void ClientHealth::stopProbing(const void* owner)
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->probe_thread_mutex);
+        if (this->probe_owner == owner)
+            stopProbeThread();
+    }
+
+    // Called with probe_thread_mutex held.
+    void ClientHealth::stopProbeThread()
+    {
+        if (!this->probe_thread)
+            return;
+        {
+            boost::lock_guard<boost::mutex> probe_guard(this->probe_mutex);
+            this->stop_probing = true;
+        }
+        this->probe_cond.notify_all();
+        this->probe_thread->join();
+        this->probe_thread.reset();
+        this->probe_owner = 0;
+    }
+
+    void ClientHealth::probe(std::vector<ClientInfo> clients, int interval_ms, int timeout_ms)
+    {
+        std::vector< std::pair<std::string, int> > endpoints;
+        for (const ClientInfo& client : clients)
+            endpoints.push_back(keyFor(client));
+
+        boost::unique_lock<boost::mutex> probe_lock(this->probe_mutex);
+        while (!this->stop_probing) {
+            probe_lock.unlock();
+            // (an empty message only connects, so this doesn't disturb the clients)
+            const std::vector<ShortReply> replies = SendStringsAndGetShortReplies(endpoints, std::vector<std::string>(endpoints.size()), false, timeout_ms, timeout_ms);
+            for (size_t i = 0; i < clients.size(); i++) {
+                recordExchange(clients[i], replies[i], CONNECT);
+                LOGFINE(LT("Probed "), clients[i].ip_address, LT(":"), clients[i].control_port, LT(" - "), replies[i].ok ? std::to_string(replies[i].elapsed_ms) + "ms" : replies[i].error);
+            }
+            probe_lock.lock();
+
+            const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(interval_ms);
+            while (!this->stop_probing && this->probe_cond.timed_wait(probe_lock, deadline)) {}
+        }
+    }
+}
+
+#undef LOG_COMPONENT
@@ -0,0 +1,163 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _CLIENTHEALTH_H_
+#define _CLIENTHEALTH_H_
+
+// Local:
+#include "ClientInfo.h"
+
+// Boost:
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace malmo
+{
+    struct ShortReply;
+
+    //! What has been seen of a Mod client: how quickly it answers, how often it has lately been busy or out of reach, and how fast it gets through missions.
+    struct ClientRecord
+    {
+        //! Constructs the record of a client that hasn't been seen yet.
+        ClientRecord();
+
+        //! The number of times the client has been connected to, just to see that it was there.
+        int connects;
+
+        //! The moving average of the time those connections took, in milliseconds.
+        double connect_ms;
+
+        //! The number of times the client has answered a short request, such as a reservation.
+        int replies;
+
+        //! The moving average of the time the client takes to answer a short request, in milliseconds.
+        double reply_ms;
+
+        //! The number of recent answers saying the client was busy, halved by each answer saying it wasn't.
+        double recent_busy;
+
+        //! The number of recent attempts to reach the client that were refused or timed out, halved by each answer.
+        double recent_failures;
+
+        //! The number of missions the client has run to the end.
+        int missions_completed;
+
+        //! The moving average length of those missions, in seconds.
+        double mission_seconds;
+
+        //! Gets how long the client can be expected to take to accept a mission: the time to connect to it and the time it takes to answer,
+        //! plus a penalty for each recent busy reply or failure. A client that hasn't been seen yet is expected to take no time at all, so that it gets tried.
+        //! \returns The expected delay in milliseconds.
+        double getExpectedDelayMs() const;
+
+        //! Gets the rate the client gets through missions, from their average length.
+        //! \returns Missions per hour, or 0 if the client hasn't run any to the end.
+        double getMissionsPerHour() const;
+
+        friend std::ostream& operator<<(std::ostream& os, const ClientRecord& record);
+    };
+
+    //! Keeps a ClientRecord for each of the clients in a ClientPool, and orders the clients by how ready they are expected to be.
+    //! Shared by the copies of the pool, so what one mission start learns is there for the next. Can be used from any thread.
+    //! Can also probe the clients every so often on a background thread, to keep the records fresh between missions.
+    class ClientHealth : boost::noncopyable
+    {
+        public:
+
+            //! How much a recent busy reply adds to a client's expected delay, in milliseconds.
+            static const int BUSY_PENALTY_MS = 2000;
+
+            //! How much a recent refusal or timeout adds to a client's expected delay, in milliseconds.
+            static const int FAILURE_PENALTY_MS = 5000;
+
+            //! The kinds of exchange with a client's mission control port. Their times are kept apart, as they measure different things.
+            enum ExchangeKind {
+                CONNECT,        //!< Only connecting, to see whether the client is there.
+                REQUEST,        //!< A short request that the client answers straight away, such as a reservation.
+                MISSION_INIT    //!< Offering the client a mission. Its reply waits on validating the mission, so says nothing about how quick the client is, and isn't timed.
+            };
+
+            ClientHealth();
+
+            //! Stops any background probes.
+            ~ClientHealth();
+
+            //! Records the outcome of an exchange with a client's mission control port.
+            //! \param client The client.
+            //! \param reply The outcome of the exchange. A reply starting MALMOBUSY counts as busy; an empty reply (connection only) says nothing about busyness.
+            //! \param kind What the exchange was, which decides which of the client's times it counts towards, if any.
+            void recordExchange(const ClientInfo& client, const ShortReply& reply, ExchangeKind kind);
+
+            //! Records that a client has run a mission to the end.
+            //! \param client The client.
+            //! \param seconds How long the mission took, from being accepted to ending.
+            void recordMissionEnded(const ClientInfo& client, double seconds);
+
+            //! Gets what has been seen of a client.
+            //! \param client The client.
+            //! \returns The client's record, which is empty if nothing has been seen of it.
+            ClientRecord getRecord(const ClientInfo& client) const;
+
+            //! Orders clients by how ready they are expected to be - see ClientRecord::getExpectedDelayMs - with those that get through
+            //! missions faster first among equals. Clients that can't be told apart keep their order.
+            //! \param clients The clients.
+            //! \returns The same clients, the one expected to be ready soonest first.
+            std::vector<ClientInfo> orderByReadiness(const std::vector<ClientInfo>& clients) const;
+
+            //! Starts connecting to each of the clients every so often, on a background thread, recording how long each connection takes or that it failed.
+            //! Replaces any probes already running, whoever started them.
+            //! \param clients The clients to probe.
+            //! \param interval_ms The time between rounds of probes.
+            //! \param timeout_ms How long each probe may take.
+            //! \param owner Whatever the probes belong to (in practice, the ClientPool object that started them): only it can stop them.
+            void startProbing(const std::vector<ClientInfo>& clients, int interval_ms, int timeout_ms, const void* owner);
+
+            //! Stops the background probes, if they are running and belong to owner.
+            //! \param owner What the probes were started for.
+            void stopProbing(const void* owner);
+
+        private:
+
+            typedef std::pair<std::string, int> Key;
+            static Key keyFor(const ClientInfo& client);
+
+            void probe(std::vector<ClientInfo> clients, int interval_ms, int timeout_ms);
+            void stopProbeThread();
+
+            std::map<Key, ClientRecord> records;
+            mutable boost::mutex records_mutex;
+
+            boost::shared_ptr<boost::thread> probe_thread;
+            const void* probe_owner;
+            boost::mutex probe_thread_mutex;        // guards the two above, and is held while starting and stopping the thread
+            bool stop_probing;
+            boost::mutex probe_mutex;               // guards stop_probing, and is held by the probe thread while it waits
+            boost::condition_variable probe_cond;
+    };
+}
+
+#endif
@@ -21,12 +21,46 @@
 #include "ClientPool.h"
 #include <sstream>
 
+// Boost:
+#include <boost/make_shared.hpp>
+
 namespace malmo 
 {
+    ClientPool::ClientPool()
+        : health(boost::make_shared<ClientHealth>())
+    {
+    }
+
+    ClientPool::~ClientPool()
+    {
+        if (this->health)
+            this->health->stopProbing(this);
+    }
+
     void ClientPool::add(const ClientInfo& client_info)
     {
         this->clients.push_back(client_info);
     }
+
+    std::vector< ClientInfo > ClientPool::getClientsByReadiness() const
+    {
+        return this->health->orderByReadiness(this->clients);
+    }
+
+    ClientRecord ClientPool::getClientRecord(const ClientInfo& client_info) const
+    {
+        return this->health->getRecord(client_info);
+    }
+
+    void ClientPool::startHealthProbes(int interval_ms, int timeout_ms)
+    {
+        this->health->startProbing(this->clients, interval_ms, timeout_ms, this);
+    }
+
+    void ClientPool::stopHealthProbes()
+    {
+        this->health->stopProbing(this);
+    }
     std::ostream& operator<<(std::ostream& os, const ClientPool& cp)
     {
         os << "ClientPool";
@@ -21,9 +21,13 @@
 #define _CLIENTPOOL_H_
 
 // Local:
+#include "ClientHealth.h"
 #include "ClientInfo.h"
 #include "Logger.h"
 
+// Boost:
+#include <boost/shared_ptr.hpp>
+
 // STL:
 #include <vector>
 
@@ -34,11 +38,39 @@ namespace malmo
     {
         MALMO_LOGGABLE_OBJECT(ClientPool)
 
+        //! Constructs an empty pool.
+        ClientPool();
+
+        //! Stops the health probes this pool started, if they are still running.
+        ~ClientPool();
+
         //! Adds a client to the pool.
         //! \param client_info The client information.
         void add(const ClientInfo& client_info);
 
+        //! Gets the clients in the order they are expected to be ready to take a mission, judging by what has been seen of them - see ClientHealth.
+        //! startMission tries them in this order, so keep using the same pool (or copies of it) for the records to build up.
+        //! \returns The clients, the one expected to be ready soonest first.
+        std::vector< ClientInfo > getClientsByReadiness() const;
+
+        //! Gets what has been seen of one of the clients.
+        //! \param client_info The client.
+        //! \returns The client's record.
+        ClientRecord getClientRecord(const ClientInfo& client_info) const;
+
+        //! Starts connecting to each of the clients every so often on a background thread, to keep their records fresh between missions.
+        //! Probes the clients in the pool when it is called; call again after adding clients.
+        //! The probes belong to this pool object, not to its copies: they run until it calls stopHealthProbes or is destroyed, or a copy
+        //! starts probes of its own in their place. The copies - such as the one startMissionAsync keeps - share the records they keep.
+        //! \param interval_ms The time between rounds of probes.
+        //! \param timeout_ms How long each probe may take.
+        void startHealthProbes(int interval_ms, int timeout_ms);
+
+        //! Stops the background probes, if this pool object started them.
+        void stopHealthProbes();
+
         std::vector< ClientInfo > clients; //!< The list of clients.
+        boost::shared_ptr< ClientHealth > health; //!< What has been seen of the clients, shared by the copies of this pool.
         friend std::ostream& operator<<(std::ostream& os, const ClientPool& cp);
     };
 }
@@ -0,0 +1,345 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "ControlConnectionPool.h"
+#include "Logger.h"
+
+// Boost:
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <stdexcept>
+using boost::asio::ip::tcp;
+
+#define LOG_COMPONENT Logger::LOG_TCP
+
+namespace malmo
+{
+    // A connection to one endpoint, and the exchange in progress on it: connect if need be, write all the messages, then read
+    // the size header and body of each reply in turn, each step started by the completion of the one before. Connecting and
+    // replying each have a deadline; if one passes first, the timer closes the socket, which fails whichever step is outstanding.
+    // Only ever run on one thread, so needs no locking.
+    class ControlConnectionPool::Connection : public boost::enable_shared_from_this< ControlConnectionPool::Connection >
+    {
+        public:
+            Connection(boost::asio::io_service& io_service, const std::string& ip_address, int port)
+                : resolver(io_service)
+                , socket(io_service)
+                , timer(io_service)
+                , ip_address(ip_address)
+                , port(port)
+                , size_header(0)
+                , finished(true)
+                , reused(false)
+                , connecting(false)
+            {
+            }
+
+            bool isOpen() const
+            {
+                return this->socket.is_open();
+            }
+
+            void close()
+            {
+                boost::system::error_code ec;
+                this->socket.close(ec);
+            }
+
+            void start(const std::vector<std::string>& messages, const std::vector<ShortReply*>& results, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms)
+            {
+                this->messages = messages;
+                this->results = results;
+                this->with_size_header = withSizeHeader;
+                this->connect_timeout_ms = connect_timeout_ms;
+                this->reply_timeout_ms = reply_timeout_ms;
+                this->next_reply = 0;
+                this->finished = false;
+                this->start_time = boost::posix_time::microsec_clock::universal_time();
+                if (this->socket.is_open()) {
+                    this->reused = true;
+                    this->connecting = false;
+                    startTimer(this->reply_timeout_ms);
+                    write();
+                }
+                else {
+                    resolve();
+                }
+            }
+
+        private:
+            static const int SIZE_HEADER_LENGTH = 4;
+            static const int MAX_PACKET_LENGTH = 1024;
+
+            void startTimer(int timeout_ms)
+            {
+                // (restarting the timer aborts the wait for the last deadline)
+                this->timer.expires_from_now(boost::posix_time::milliseconds(timeout_ms));
+                this->timer.async_wait(boost::bind(&Connection::timedOut, shared_from_this(), boost::asio::placeholders::error));
+            }
+
+            void resolve()
+            {
+                this->reused = false;
+                this->connecting = true;
+                startTimer(this->connect_timeout_ms);
+                for (size_t i = 0; i < this->messages.size(); i++)
+                    if (this->messages[i].empty())
+                        this->results[i]->ok = false;   // (not connected after all, if this is a reconnect)
+                tcp::resolver::query query(this->ip_address, boost::lexical_cast<std::string>(this->port));
+                this->resolver.async_resolve(query, boost::bind(&Connection::resolved, shared_from_this(), boost::asio::placeholders::error, boost::asio::placeholders::iterator));
+            }
+
+            void resolved(const boost::system::error_code& ec, tcp::resolver::iterator endpoint_iterator)
+            {
+                if (this->finished)
+                    return;
+                if (ec)
+                    return finish("Failed to resolve - " + ec.message());
+                boost::asio::async_connect(this->socket, endpoint_iterator, boost::bind(&Connection::connected, shared_from_this(), boost::asio::placeholders::error));
+            }
+
+            void connected(const boost::system::error_code& ec)
+            {
+                if (this->finished)
+                    return;
+                if (ec)
+                    return finish("Failed to connect - " + ec.message());   // (at once, if refused)
+                this->connecting = false;
+                startTimer(this->reply_timeout_ms);
+                write();
+            }
+
+            void write()
+            {
+                // The messages go together, and the replies come back in the same order. Those that only wanted a connection have one.
+                this->write_buffer.clear();
+                for (size_t i = 0; i < this->messages.size(); i++) {
+                    const std::string& message = this->messages[i];
+                    if (message.empty()) {
+                        this->results[i]->ok = true;
+                        this->results[i]->elapsed_ms = elapsedMs();
+                        continue;
+                    }
+                    if (this->with_size_header) {
+                        // the size header is 4 bytes containing the size of the body of the message as a network byte order integer
+                        const u_long message_size_header = htonl((u_long)message.size());
+                        const unsigned char* header = reinterpret_cast<const unsigned char*>(&message_size_header);
+                        this->write_buffer.insert(this->write_buffer.end(), header, header + SIZE_HEADER_LENGTH);
+                    }
+                    this->write_buffer.insert(this->write_buffer.end(), message.begin(), message.end());
+                }
+                if (this->write_buffer.empty())
+                    return readNext();
+                boost::asio::async_write(this->socket, boost::asio::buffer(this->write_buffer), boost::bind(&Connection::wrote, shared_from_this(), boost::asio::placeholders::error));
+            }
+
+            void wrote(const boost::system::error_code& ec)
+            {
+                if (this->finished)
+                    return;
+                if (ec)
+                    return fail("Failed to write message - ", ec);
+                readNext();
+            }
+
+            void readNext()
+            {
+                while (this->next_reply < this->messages.size() && this->messages[this->next_reply].empty())
+                    this->next_reply++;     // (connect only - no reply to read)
+                if (this->next_reply == this->messages.size())
+                    return finish("");
+                boost::asio::async_read(this->socket, boost::asio::buffer(&this->size_header, SIZE_HEADER_LENGTH), boost::asio::transfer_exactly(SIZE_HEADER_LENGTH),
+                    boost::bind(&Connection::readHeader, shared_from_this(), boost::asio::placeholders::error));
+            }
+
+            void readHeader(const boost::system::error_code& ec)
+            {
+                if (this->finished)
+                    return;
+                if (ec)
+                    return fail("Failed to read response header - ", ec);
+                this->size_header = ntohl(this->size_header);
+                if (this->size_header > MAX_PACKET_LENGTH)
+                    return finish("Packet length of " + std::to_string(this->size_header) + " exceeds maximum allowed.");
+                boost::asio::async_read(this->socket, boost::asio::buffer(this->data, this->size_header), boost::asio::transfer_exactly(this->size_header),
+                    boost::bind(&Connection::readBody, shared_from_this(), boost::asio::placeholders::error));
+            }
+
+            void readBody(const boost::system::error_code& ec)
+            {
+                if (this->finished)
+                    return;
+                if (ec)
+                    return fail("Failed to read response body - ", ec);
+                ShortReply& result = *this->results[this->next_reply++];
+                result.reply.assign(this->data, this->data + this->size_header);
+                result.ok = true;
+                result.elapsed_ms = elapsedMs();
+                LOGFINE(LT("Received reply from  "), this->ip_address, LT(":"), this->port, LT(" - "), result.reply);
+                readNext();
+            }
+
+            void timedOut(const boost::system::error_code& ec)
+            {
+                if (this->finished || ec == boost::asio::error::operation_aborted)
+                    return;
+                if (this->timer.expires_at() > boost::asio::deadline_timer::traits_type::now())
+                    return;     // (the timer was restarted after this wait had already finished)
+                for (ShortReply* result : this->results)
+                    result->timed_out = !result->ok;
+                if (this->connecting)
+                    finish("Timed out connecting after " + std::to_string(this->connect_timeout_ms) + "ms");
+                else
+                    finish("Timed out waiting for a reply after " + std::to_string(this->reply_timeout_ms) + "ms");
+            }
+
+            void fail(const std::string& what, const boost::system::error_code& ec)
+            {
+                // A kept connection that the other end has closed since (the client was restarted, say) fails as soon as it's used, before any
+                // reply: then the messages can't have been read, so open a new connection and send them again.
+                const bool closed_by_peer = ec == boost::asio::error::eof || ec == boost::asio::error::connection_reset
+                    || ec == boost::asio::error::broken_pipe || ec == boost::asio::error::connection_aborted;
+                if (this->reused && closed_by_peer && !anyReplies()) {
+                    LOGFINE(LT("Connection to "), this->ip_address, LT(":"), this->port, LT(" was closed - reconnecting."));
+                    close();
+                    return resolve();
+                }
+                finish(what + ec.message());
+            }
+
+            double elapsedMs() const
+            {
+                return (boost::posix_time::microsec_clock::universal_time() - this->start_time).total_microseconds() / 1000.0;
+            }
+
+            bool anyReplies() const
+            {
+                for (size_t i = 0; i < this->next_reply; i++)
+                    if (!this->messages[i].empty())
+                        return true;
+                return false;
+            }
+
+            void finish(const std::string& error)
+            {
+                this->finished = true;
+                boost::system::error_code ec;
+                this->timer.cancel(ec);
+                if (error.empty())
+                    return;     // (keep the connection for next time)
+
+                LOGFINE(LT("No reply from "), this->ip_address, LT(":"), this->port, LT(" - "), error);
+                for (size_t i = this->next_reply; i < this->results.size(); i++)
+                    if (!this->results[i]->ok)
+                        this->results[i]->error = error;
+                // After a failure the replies could be out of step with the requests, so start again with a new connection.
+                this->resolver.cancel();
+                close();
+            }
+
+            tcp::resolver resolver;
+            tcp::socket socket;
+            boost::asio::deadline_timer timer;
+            std::string ip_address;
+            int port;
+
+            std::vector<std::string> messages;
+            std::vector<ShortReply*> results;
+            bool with_size_header;
+            int connect_timeout_ms;
+            int reply_timeout_ms;
+            std::vector<unsigned char> write_buffer;
+            size_t next_reply;
+            boost::posix_time::ptime start_time;
+            u_long size_header;
+            unsigned char data[MAX_PACKET_LENGTH];
+            bool finished;
+            bool reused;
+            bool connecting;
+    };
+
+    ControlConnectionPool::ControlConnectionPool()
+    {
+    }
+
+    ControlConnectionPool::~ControlConnectionPool()
+    {
+        close();
+    }
+
+    std::vector<ShortReply> ControlConnectionPool::exchange(const std::vector< std::pair<std::string, int> >& endpoints, const std::vector<std::string>& messages, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms)
+    {
+        if (messages.size() != endpoints.size())
+            throw std::invalid_argument("Need one message for each endpoint.");
+
+        boost::lock_guard<boost::mutex> scope_guard(this->connections_mutex);
+
+        // Gather each endpoint's messages, in order, to go down its connection together.
+        std::vector<ShortReply> results(messages.size());
+        std::map< std::pair<std::string, int>, std::pair< std::vector<std::string>, std::vector<ShortReply*> > > batches;
+        for (size_t i = 0; i < messages.size(); i++) {
+            auto& batch = batches[endpoints[i]];
+            batch.first.push_back(messages[i]);
+            batch.second.push_back(&results[i]);
+        }
+
+        for (const auto& batch : batches) {
+            boost::shared_ptr<Connection>& connection = this->connections[batch.first];
+            if (!connection)
+                connection = boost::make_shared<Connection>(boost::ref(this->io_service), batch.first.first, batch.first.second);
+            connection->start(batch.second.first, batch.second.second, withSizeHeader, connect_timeout_ms, reply_timeout_ms);
+        }
+        this->io_service.reset();
+        this->io_service.run();     // (returns once every exchange has finished)
+        return results;
+    }
+
+    ShortReply ControlConnectionPool::exchange(const std::string& ip_address, int port, const std::string& message, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms)
+    {
+        return exchange(std::vector< std::pair<std::string, int> >(1, std::make_pair(ip_address, port)), std::vector<std::string>(1, message), withSizeHeader, connect_timeout_ms, reply_timeout_ms).front();
+    }
+
+    int ControlConnectionPool::getNumberOfConnections() const
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->connections_mutex);
+
+        int count = 0;
+        for (const auto& connection : this->connections)
+            if (connection.second->isOpen())
+                count++;
+        return count;
+    }
+
+    void ControlConnectionPool::close()
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->connections_mutex);
+
+        for (auto& connection : this->connections)
+            connection.second->close();
+        this->connections.clear();
+    }
+}
+
+#undef LOG_COMPONENT
@@ -0,0 +1,89 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _CONTROLCONNECTIONPOOL_H_
+#define _CONTROLCONNECTIONPOOL_H_
+
+// Local:
+#include "TCPClient.h"
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace malmo
+{
+    //! Keeps a TCP connection open to each endpoint it has exchanged messages with, for the request-and-short-reply exchanges
+    //! of the Mod's mission control port - reservations, finding the server, MissionInits and so on. Saves a connection set-up
+    //! (and a socket left in TIME_WAIT) per exchange. A connection that has been closed at the other end since it was last
+    //! used is reopened, and the exchange retried, without the caller seeing. A connection whose exchange fails is closed.
+    //! Exchanges run on a private io_service on the calling thread, one caller at a time.
+    class ControlConnectionPool : boost::noncopyable
+    {
+        public:
+
+            ControlConnectionPool();
+            ~ControlConnectionPool();
+
+            //! Sends a string to each of several endpoints and reads a short reply to each, all at once. Each endpoint's messages
+            //! are written together on its connection and the replies read back in order, so an endpoint can be given more than one.
+            //! \param endpoints The IP address and port for each message.
+            //! \param messages The messages. An empty message only makes sure its endpoint is connected, and gets no reply.
+            //! \param withSizeHeader If true, prepends a 4-byte integer containing the size of each message.
+            //! \param connect_timeout_ms The longest resolving and connecting to an endpoint may take, where it isn't already connected.
+            //! \param reply_timeout_ms The longest each endpoint may take, once connected, to send back all its replies.
+            //! \returns The outcome of each message's exchange, in the order of the messages.
+            std::vector<ShortReply> exchange(const std::vector< std::pair<std::string, int> >& endpoints, const std::vector<std::string>& messages, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms);
+
+            //! Sends a string to an endpoint and reads a short reply.
+            //! \param ip_address The IP address of the endpoint.
+            //! \param port The port of the endpoint.
+            //! \param message The message. An empty message only makes sure the endpoint is connected, and gets no reply.
+            //! \param withSizeHeader If true, prepends a 4-byte integer containing the size of the message.
+            //! \param connect_timeout_ms The longest resolving and connecting may take, if not already connected.
+            //! \param reply_timeout_ms The longest the endpoint may take, once connected, to reply.
+            //! \returns The outcome of the exchange.
+            ShortReply exchange(const std::string& ip_address, int port, const std::string& message, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms);
+
+            //! Gets the number of connections that are open.
+            //! \returns The number of open connections.
+            int getNumberOfConnections() const;
+
+            //! Closes all the connections.
+            void close();
+
+        private:
+
+            class Connection;
+
+            boost::asio::io_service io_service;
+            std::map< std::pair<std::string, int>, boost::shared_ptr<Connection> > connections;
+            mutable boost::mutex connections_mutex;
+    };
+}
+
+#endif
@@ -0,0 +1,125 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FrameAligner.h"
+
+// Boost:
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <cmath>
+
+namespace malmo
+{
+    FrameAligner::FrameAligner()
+        : max_time_difference(boost::posix_time::milliseconds(50))
+        , max_pose_difference(0.001f)
+        , expected(TimestampedVideoFrame::_MAX_FRAME_TYPE, false)
+        , number_expected(0)
+        , incomplete_bundles(0)
+    {
+    }
+
+    FrameAligner::FrameAligner(boost::posix_time::time_duration max_time_difference, float max_pose_difference)
+        : max_time_difference(max_time_difference)
+        , max_pose_difference(max_pose_difference)
+        , expected(TimestampedVideoFrame::_MAX_FRAME_TYPE, false)
+        , number_expected(0)
+        , incomplete_bundles(0)
+    {
+    }
+
+    void FrameAligner::expect(TimestampedVideoFrame::FrameType frametype)
+    {
+        if (!this->expected[frametype]) {
+            this->expected[frametype] = true;
+            this->number_expected++;
+        }
+    }
+
+    bool FrameAligner::isExpected(TimestampedVideoFrame::FrameType frametype) const
+    {
+        return frametype >= 0 && static_cast<std::size_t>(frametype) < this->expected.size() && this->expected[frametype];
+    }
+
+    void FrameAligner::add(boost::shared_ptr<TimestampedVideoFrame> frame, std::vector< boost::shared_ptr<FrameBundle> >& ready)
+    {
+        if (!isExpected(frame->frametype))
+            return;
+
+        // Give up on bundles that are too old for this frame (or any later one) to belong to:
+        std::size_t expired = 0;
+        while (expired < this->pending.size() && this->pending[expired]->timestamp + this->max_time_difference < frame->timestamp)
+            expired++;
+        release(expired, ready);
+
+        for (std::size_t i = 0; i < this->pending.size(); i++) {
+            FrameBundle& bundle = *this->pending[i];
+            if (bundle.frames[frame->frametype] || !matches(bundle, *frame))
+                continue;
+
+            bundle.frames[frame->frametype] = frame;
+            if (bundle.getNumberOfFrames() == this->number_expected) {
+                // Streams arrive in order, so the older bundles will never be completed - they must be missing a frame that this one has.
+                release(i, ready);
+                bundle.is_complete = true;
+                ready.push_back(this->pending.front());
+                this->pending.pop_front();
+            }
+            return;
+        }
+
+        // The first frame of a new render tick:
+        this->pending.push_back(boost::make_shared<FrameBundle>(frame));
+        if (this->number_expected == 1) {
+            this->pending.back()->is_complete = true;
+            ready.push_back(this->pending.back());
+            this->pending.pop_back();
+        }
+        else if (this->pending.size() > MAX_PENDING_BUNDLES) {
+            release(this->pending.size() - MAX_PENDING_BUNDLES, ready);
+        }
+    }
+
+    void FrameAligner::flush(std::vector< boost::shared_ptr<FrameBundle> >& ready)
+    {
+        release(this->pending.size(), ready);
+    }
+
+    bool FrameAligner::matches(const FrameBundle& bundle, const TimestampedVideoFrame& frame) const
+    {
+        const boost::posix_time::time_duration gap = frame.timestamp - bundle.timestamp;
+        return (gap.is_negative() ? gap.invert_sign() : gap) <= this->max_time_difference
+            && std::fabs(frame.xPos - bundle.xPos) <= this->max_pose_difference
+            && std::fabs(frame.yPos - bundle.yPos) <= this->max_pose_difference
+            && std::fabs(frame.zPos - bundle.zPos) <= this->max_pose_difference
+            && std::fabs(frame.yaw - bundle.yaw) <= this->max_pose_difference
+            && std::fabs(frame.pitch - bundle.pitch) <= this->max_pose_difference;
+    }
+
+    void FrameAligner::release(std::size_t count, std::vector< boost::shared_ptr<FrameBundle> >& ready)
+    {
+        for (std::size_t i = 0; i < count; i++) {
+            ready.push_back(this->pending.front());
+            this->pending.pop_front();
+            this->incomplete_bundles++;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMEALIGNER_H_
+#define _FRAMEALIGNER_H_
+
+// Local:
+#include "FrameBundle.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <deque>
+#include <vector>
+
+namespace malmo
+{
+    //! Groups the frames arriving on separate video streams into bundles of frames that were rendered together.
+    //! Frames belong together if their timestamps are within a tolerance and their pose headers agree.
+    //! Each stream must deliver its frames in order.
+    class FrameAligner
+    {
+        public:
+            //! Constructs an aligner with the default tolerances (50ms, and 0.001 in each pose value), expecting no streams.
+            FrameAligner();
+
+            //! Constructs an aligner expecting no streams.
+            //! \param max_time_difference How far apart the timestamps of frames in the same bundle may be.
+            //! \param max_pose_difference How far apart the position, yaw and pitch of frames in the same bundle may be.
+            explicit FrameAligner(boost::posix_time::time_duration max_time_difference, float max_pose_difference = 0.001f);
+
+            //! Adds a stream to the set that a bundle needs a frame from to be complete.
+            void expect(TimestampedVideoFrame::FrameType frametype);
+
+            //! Returns true if frames of a particular type are being aligned.
+            bool isExpected(TimestampedVideoFrame::FrameType frametype) const;
+
+            //! Adds a frame. Frames from streams that aren't expected are ignored.
+            //! \param frame The frame that has arrived.
+            //! \param ready Any bundles that are finished with - complete or not - are appended here, oldest first.
+            void add(boost::shared_ptr<TimestampedVideoFrame> frame, std::vector< boost::shared_ptr<FrameBundle> >& ready);
+
+            //! Gives up waiting on all the bundles that are still being filled.
+            //! \param ready The incomplete bundles are appended here, oldest first.
+            void flush(std::vector< boost::shared_ptr<FrameBundle> >& ready);
+
+            //! Returns the number of bundles that were given up on before they were complete.
+            int getNumberOfIncompleteBundles() const { return this->incomplete_bundles; }
+
+        private:
+            bool matches(const FrameBundle& bundle, const TimestampedVideoFrame& frame) const;
+            void release(std::size_t count, std::vector< boost::shared_ptr<FrameBundle> >& ready);
+
+            // Bundles may wait on at most this many render ticks before the oldest is given up on:
+            static const std::size_t MAX_PENDING_BUNDLES = 8;
+
+            boost::posix_time::time_duration max_time_difference;
+            float max_pose_difference;
+            std::vector<bool> expected;
+            int number_expected;
+            std::deque< boost::shared_ptr<FrameBundle> > pending;
+            int incomplete_bundles;
+    };
+}
+
+#endif
@@ -0,0 +1,78 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FrameBundle.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace malmo
+{
+    FrameBundle::FrameBundle()
+        : xPos(0)
+        , yPos(0)
+        , zPos(0)
+        , yaw(0)
+        , pitch(0)
+        , is_complete(false)
+        , frames(TimestampedVideoFrame::_MAX_FRAME_TYPE)
+    {
+    }
+
+    FrameBundle::FrameBundle(boost::shared_ptr<TimestampedVideoFrame> frame)
+        : timestamp(frame->timestamp)
+        , xPos(frame->xPos)
+        , yPos(frame->yPos)
+        , zPos(frame->zPos)
+        , yaw(frame->yaw)
+        , pitch(frame->pitch)
+        , is_complete(false)
+        , frames(TimestampedVideoFrame::_MAX_FRAME_TYPE)
+    {
+        this->frames[frame->frametype] = frame;
+    }
+
+    bool FrameBundle::hasFrame(TimestampedVideoFrame::FrameType frametype) const
+    {
+        return getFrame(frametype) != 0;
+    }
+
+    boost::shared_ptr<TimestampedVideoFrame> FrameBundle::getFrame(TimestampedVideoFrame::FrameType frametype) const
+    {
+        if (frametype < 0 || static_cast<size_t>(frametype) >= this->frames.size())
+            return boost::shared_ptr<TimestampedVideoFrame>();
+        return this->frames[frametype];
+    }
+
+    int FrameBundle::getNumberOfFrames() const
+    {
+        int count = 0;
+        for (const auto& frame : this->frames)
+            if (frame)
+                count++;
+        return count;
+    }
+
+    std::ostream& operator<<(std::ostream& os, const FrameBundle& bundle)
+    {
+        os << "FrameBundle: " << to_simple_string(bundle.timestamp) << ", " << bundle.getNumberOfFrames() << " frames" << (bundle.is_complete ? "" : " (incomplete)") << ", (" << bundle.xPos << "," << bundle.yPos << "," << bundle.zPos << " - yaw:" << bundle.yaw << ", pitch:" << bundle.pitch << ")";
+        return os;
+    }
+}
@@ -0,0 +1,73 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMEBUNDLE_H_
+#define _FRAMEBUNDLE_H_
+
+// Local:
+#include "TimestampedVideoFrame.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <vector>
+
+namespace malmo
+{
+    //! The frames from each of the video streams (video, depth, luminance, colour map) that were rendered at the same moment.
+    struct FrameBundle
+    {
+        //! Constructs an empty bundle.
+        FrameBundle();
+
+        //! Constructs a bundle from its first frame, taking the timestamp and pose from it.
+        FrameBundle(boost::shared_ptr<TimestampedVideoFrame> frame);
+
+        //! The timestamp of the first frame in the bundle.
+        boost::posix_time::ptime timestamp;
+
+        //! The position and orientation of the player at render time, as given by the first frame.
+        float xPos;
+        float yPos;
+        float zPos;
+        float yaw;
+        float pitch;
+
+        //! True if the bundle has a frame from every stream that was requested.
+        bool is_complete;
+
+        //! The frames, indexed by TimestampedVideoFrame::FrameType. Null for streams that didn't supply one.
+        std::vector< boost::shared_ptr< TimestampedVideoFrame > > frames;
+
+        //! Returns true if the bundle holds a frame of a particular type.
+        bool hasFrame(TimestampedVideoFrame::FrameType frametype) const;
+
+        //! Returns the frame of a particular type, or null if the bundle doesn't hold one.
+        boost::shared_ptr<TimestampedVideoFrame> getFrame(TimestampedVideoFrame::FrameType frametype) const;
+
+        //! Returns the number of frames in the bundle.
+        int getNumberOfFrames() const;
+
+        friend std::ostream& operator<<(std::ostream& os, const FrameBundle& bundle);
+    };
+}
+
+#endif
@@ -0,0 +1,234 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FramePreprocessor.h"
+
+// STL:
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace malmo
+{
+    FramePreprocessor::FramePreprocessor()
+        : cropping(false)
+        , crop_x(0)
+        , crop_y(0)
+        , crop_width(0)
+        , crop_height(0)
+        , out_width(0)
+        , out_height(0)
+        , filter(AREA)
+        , grayscale(false)
+        , channels_first(false)
+        , to_float(false)
+        , scale(1.0f)
+        , offset(0.0f)
+        , in_channels(0)
+        , out_channels(0)
+    {
+    }
+
+    void FramePreprocessor::crop(short x, short y, short width, short height)
+    {
+        this->cropping = true;
+        this->crop_x = x;
+        this->crop_y = y;
+        this->crop_width = width;
+        this->crop_height = height;
+    }
+
+    void FramePreprocessor::resize(short width, short height)
+    {
+        resize(width, height, AREA);
+    }
+
+    void FramePreprocessor::resize(short width, short height, ResizeFilter filter)
+    {
+        this->out_width = width;
+        this->out_height = height;
+        this->filter = filter;
+    }
+
+    void FramePreprocessor::convertToGrayscale()
+    {
+        this->grayscale = true;
+    }
+
+    void FramePreprocessor::reorderToChannelsFirst()
+    {
+        this->channels_first = true;
+    }
+
+    void FramePreprocessor::convertToFloat()
+    {
+        convertToFloat(1.0f / 255.0f, 0.0f);
+    }
+
+    void FramePreprocessor::convertToFloat(float scale, float offset)
+    {
+        this->to_float = true;
+        this->scale = scale;
+        this->offset = offset;
+    }
+
+    bool FramePreprocessor::isIdentity() const
+    {
+        return !this->cropping && this->out_width == 0 && this->out_height == 0 && !this->grayscale && !this->channels_first && !this->to_float;
+    }
+
+    void FramePreprocessor::prepare(short width, short height, short channels)
+    {
+        if (channels < 1 || channels > 4)
+            throw std::invalid_argument("Can only preprocess frames with between one and four channels.");
+        if (this->grayscale && channels < 3)
+            throw std::invalid_argument("Can only convert frames with RGB channels to grayscale.");
+
+        if (!this->cropping){
+            this->crop_x = 0;
+            this->crop_y = 0;
+            this->crop_width = width;
+            this->crop_height = height;
+        }
+        if (this->crop_x < 0 || this->crop_y < 0 || this->crop_width <= 0 || this->crop_height <= 0 || this->crop_x + this->crop_width > width || this->crop_y + this->crop_height > height)
+            throw std::invalid_argument("Crop rectangle doesn't fit inside the frame.");
+
+        const short width_after = this->out_width > 0 ? this->out_width : this->crop_width;
+        const short height_after = this->out_height > 0 ? this->out_height : this->crop_height;
+        if (width_after <= 0 || height_after <= 0)
+            throw std::invalid_argument("Can't resize to an empty frame.");
+
+        this->in_channels = channels;
+        this->out_channels = this->grayscale ? (channels == 4 ? 2 : 1) : channels;
+        this->x_taps.build(this->crop_width, width_after, this->filter);
+        this->y_taps.build(this->crop_height, height_after, this->filter);
+    }
+
+    void FramePreprocessor::apply(const TimestampedVideoFrame& in, TimestampedVideoFrame& out) const
+    {
+        FrameView source = in.getView();
+        if (source.getChannels() != this->in_channels || source.getWidth() < this->crop_x + this->crop_width || source.getHeight() < this->crop_y + this->crop_height)
+            throw std::invalid_argument("Frame doesn't match the size the preprocessor was prepared for.");
+        source = source.crop(this->crop_x, this->crop_y, this->crop_width, this->crop_height);
+
+        const int width = static_cast<int>(this->x_taps.first.size()) - 1;
+        const int height = static_cast<int>(this->y_taps.first.size()) - 1;
+        const std::size_t num_pixels = static_cast<std::size_t>(width) * height;
+
+        out.timestamp = in.timestamp;
+        out.frametype = in.frametype;
+        out.xPos = in.xPos;
+        out.yPos = in.yPos;
+        out.zPos = in.zPos;
+        out.yaw = in.yaw;
+        out.pitch = in.pitch;
+        out.width = width;
+        out.height = height;
+        out.channels = this->out_channels;
+        out.channels_first = this->channels_first;
+        out.float_pixels = this->to_float;
+
+        // Borrow the output frame's old storage, so that a recycled frame doesn't need a new allocation:
+        std::vector<unsigned char> buffer;
+        out.swapPixels(buffer);
+        buffer.resize(num_pixels * this->out_channels * (this->to_float ? sizeof(float) : 1));
+
+        // Everything happens in one pass over the output: resample from the (cropped) view, combine the channels, then store.
+        float values[4];
+        float result[4];
+        for (int oy = 0; oy < height; oy++){
+            for (int ox = 0; ox < width; ox++){
+                std::fill(values, values + this->in_channels, 0.0f);
+                for (int ty = this->y_taps.first[oy]; ty < this->y_taps.first[oy + 1]; ty++){
+                    for (int tx = this->x_taps.first[ox]; tx < this->x_taps.first[ox + 1]; tx++){
+                        const float w = this->y_taps.weight[ty] * this->x_taps.weight[tx];
+                        const unsigned char* p = source.pixel(this->x_taps.index[tx], this->y_taps.index[ty]);
+                        for (int c = 0; c < this->in_channels; c++)
+                            values[c] += w * p[c];
+                    }
+                }
+
+                if (this->grayscale){
+                    result[0] = 0.299f * values[0] + 0.587f * values[1] + 0.114f * values[2];
+                    result[1] = values[3];  // (only used if there is a depth channel)
+                }
+                else {
+                    std::copy(values, values + this->in_channels, result);
+                }
+
+                const std::size_t pixel_index = static_cast<std::size_t>(oy) * width + ox;
+                for (int k = 0; k < this->out_channels; k++){
+                    const std::size_t i = this->channels_first ? k * num_pixels + pixel_index : pixel_index * this->out_channels + k;
+                    if (this->to_float){
+                        const float f = result[k] * this->scale + this->offset;
+                        std::memcpy(&buffer[i * sizeof(float)], &f, sizeof(float));
+                    }
+                    else {
+                        buffer[i] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, result[k] + 0.5f)));
+                    }
+                }
+            }
+        }
+        out.swapPixels(buffer);
+    }
+
+    void FramePreprocessor::Taps::build(int in_size, int out_size, ResizeFilter filter)
+    {
+        this->first.clear();
+        this->index.clear();
+        this->weight.clear();
+
+        const double ratio = static_cast<double>(in_size) / out_size;
+        for (int o = 0; o < out_size; o++){
+            this->first.push_back(static_cast<int>(this->index.size()));
+            if (filter == AREA && ratio > 1.0){
+                // Weight each source pixel by how much of it the output pixel covers:
+                const double start = o * ratio;
+                const double end = (o + 1) * ratio;
+                for (int i = static_cast<int>(start); i < end && i < in_size; i++){
+                    const double overlap = std::min<double>(i + 1, end) - std::max<double>(i, start);
+                    if (overlap > 0){
+                        this->index.push_back(i);
+                        this->weight.push_back(static_cast<float>(overlap / ratio));
+                    }
+                }
+            }
+            else {
+                // Bilinear - also used for AREA when enlarging, where there is nothing to average:
+                const double centre = std::max(0.0, (o + 0.5) * ratio - 0.5);
+                const int i0 = std::min(static_cast<int>(std::floor(centre)), in_size - 1);
+                const int i1 = std::min(i0 + 1, in_size - 1);
+                const double f = centre - i0;
+                if (i1 == i0 || f <= 0){
+                    this->index.push_back(i0);
+                    this->weight.push_back(1.0f);
+                }
+                else {
+                    this->index.push_back(i0);
+                    this->weight.push_back(static_cast<float>(1.0 - f));
+                    this->index.push_back(i1);
+                    this->weight.push_back(static_cast<float>(f));
+                }
+            }
+        }
+        this->first.push_back(static_cast<int>(this->index.size()));
+    }
+}
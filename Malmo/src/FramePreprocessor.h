@@ -0,0 +1,120 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMEPREPROCESSOR_H_
+#define _FRAMEPREPROCESSOR_H_
+
+// Local:
+#include "TimestampedVideoFrame.h"
+
+// STL:
+#include <vector>
+
+namespace malmo
+{
+    //! Specifies how video frames should be transformed as soon as they arrive, before being put into the world state.
+    //! The stages always run in this order: crop, resize, convert to grayscale, reorder to channels-first, convert to float.
+    //! Each is optional; by default frames are passed through untouched. Recordings always see the original frames.
+    class FramePreprocessor
+    {
+        public:
+
+            //! How to resample when resizing.
+            enum ResizeFilter {
+                  AREA                       //!< Average the source pixels covered by each output pixel. Best for shrinking. This is the default.
+                , BILINEAR                   //!< Interpolate between the four nearest source pixels.
+            };
+
+            //! Constructs a preprocessor that leaves frames untouched.
+            FramePreprocessor();
+
+            //! Requests that frames are cropped to a rectangle before anything else is done.
+            //! \param x The left edge of the rectangle, in pixels.
+            //! \param y The top edge of the rectangle, in pixels.
+            //! \param width The width of the rectangle, in pixels.
+            //! \param height The height of the rectangle, in pixels.
+            void crop(short x, short y, short width, short height);
+
+            //! Requests that frames are resized, using area averaging.
+            //! \param width The width to resize to.
+            //! \param height The height to resize to.
+            void resize(short width, short height);
+
+            //! Requests that frames are resized.
+            //! \param width The width to resize to.
+            //! \param height The height to resize to.
+            //! \param filter How to resample.
+            void resize(short width, short height, ResizeFilter filter);
+
+            //! Requests that the RGB channels are reduced to a single luma channel (Rec. 601 weights). A depth channel, if present, is kept.
+            void convertToGrayscale();
+
+            //! Requests that the pixels are stored one channel plane after another (CHW), rather than interleaved (HWC).
+            void reorderToChannelsFirst();
+
+            //! Requests that each value is converted to a 32-bit float in the range 0-1.
+            void convertToFloat();
+
+            //! Requests that each value v is converted to the 32-bit float v * scale + offset.
+            //! \param scale The factor to multiply each byte value by.
+            //! \param offset The amount to add after scaling.
+            void convertToFloat(float scale, float offset);
+
+            //! Returns true if no stages have been requested.
+            bool isIdentity() const;
+
+            //! Works out the resampling for frames of a particular size. Must be called before apply().
+            //! Throws std::invalid_argument if the requested stages don't make sense for this input.
+            void prepare(short width, short height, short channels);
+
+            //! Transforms a frame. The output frame's storage is reused where possible.
+            //! \param in A frame of the size passed to prepare().
+            //! \param out The frame to fill.
+            void apply(const TimestampedVideoFrame& in, TimestampedVideoFrame& out) const;
+
+        private:
+
+            // For each output pixel along one axis, the source pixels that contribute to it and their weights.
+            struct Taps
+            {
+                std::vector<int> first;     // out_size + 1 entries, indexing into index and weight
+                std::vector<int> index;
+                std::vector<float> weight;
+
+                void build(int in_size, int out_size, ResizeFilter filter);
+            };
+
+            bool cropping;
+            short crop_x, crop_y, crop_width, crop_height;
+            short out_width, out_height;
+            ResizeFilter filter;
+            bool grayscale;
+            bool channels_first;
+            bool to_float;
+            float scale;
+            float offset;
+
+            short in_channels;
+            short out_channels;
+            Taps x_taps;
+            Taps y_taps;
+    };
+}
+
+#endif
@@ -0,0 +1,243 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FrameStack.h"
+#include "FrameTransforms.h"
+
+// Boost:
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+namespace malmo
+{
+    // Stamps are unique across all stacks, so two buffers holding the same stamp for a slot hold the same frame there.
+    static std::atomic<std::uint64_t> last_stamp(0);
+
+    FrameStack::FrameStack()
+        : next(0)
+        , count(0)
+        , width(0)
+        , height(0)
+        , channels(0)
+        , float_pixels(false)
+    {
+    }
+
+    FrameStack::FrameStack(int depth)
+        : timestamps(std::max(depth, 0))
+        , next(0)
+        , count(0)
+        , width(0)
+        , height(0)
+        , channels(0)
+        , float_pixels(false)
+    {
+        if (depth < 0)
+            throw std::invalid_argument("Frame stack depth can't be negative.");
+    }
+
+    FrameStack::FrameStack(const FrameStack& other)
+        : data(other.data)
+        , timestamps(other.timestamps)
+        , next(other.next)
+        , count(other.count)
+        , width(other.width)
+        , height(other.height)
+        , channels(other.channels)
+        , float_pixels(other.float_pixels)
+    {
+    }
+
+    FrameStack& FrameStack::operator=(const FrameStack& other)
+    {
+        // (keeps our own spare, which may still come in useful)
+        this->data = other.data;
+        this->timestamps = other.timestamps;
+        this->next = other.next;
+        this->count = other.count;
+        this->width = other.width;
+        this->height = other.height;
+        this->channels = other.channels;
+        this->float_pixels = other.float_pixels;
+        return *this;
+    }
+
+    std::size_t FrameStack::getFrameSize() const
+    {
+        return static_cast<std::size_t>(this->width) * this->height * this->channels * (this->float_pixels ? sizeof(float) : 1);
+    }
+
+    int FrameStack::getSlot(int age) const
+    {
+        const int depth = getDepth();
+        if (age < 0 || age >= depth)
+            throw std::out_of_range("Frame age is outside the stack.");
+        return ((this->next - 1 - age) % depth + depth) % depth;
+    }
+
+    boost::posix_time::ptime FrameStack::getTimestamp(int slot) const
+    {
+        return this->timestamps.at(slot);
+    }
+
+    const std::vector<unsigned char>& FrameStack::getData() const
+    {
+        static const std::vector<unsigned char> no_data;
+        return this->data ? this->data->bytes : no_data;
+    }
+
+    void FrameStack::push(const TimestampedVideoFrame& frame)
+    {
+        const int depth = getDepth();
+        if (depth == 0)
+            return;
+
+        fitTo(frame);     // (first, as resetting moves the newest index)
+        put(this->next, frame);
+        this->next = (this->next + 1) % depth;
+        this->count = std::min(this->count + 1, depth);
+    }
+
+    void FrameStack::put(int slot, const TimestampedVideoFrame& frame)
+    {
+        if (slot < 0 || slot >= getDepth())
+            throw std::out_of_range("Slot is outside the stack.");
+
+        fitTo(frame);
+
+        // Read the frame through its view, which saves packing it - except for planar pixels, which have no view:
+        const FrameView view = frame.getView();
+        const int value_size = this->float_pixels ? sizeof(float) : 1;
+        if (view.empty() ? frame.getPixels().size() != getFrameSize() : (view.getWidth() != this->width || view.getHeight() != this->height || view.getChannels() != this->channels * value_size))
+            throw std::invalid_argument("Frame pixels don't match the frame's size.");
+
+        Buffer& buffer = ownData(slot);
+        copyFrame(frame, view, &buffer.bytes[slot * getFrameSize()]);
+        buffer.stamps[slot] = ++last_stamp;
+        this->timestamps[slot] = frame.timestamp;
+    }
+
+    void FrameStack::copyFrame(const TimestampedVideoFrame& frame, const FrameView& view, unsigned char* destination)
+    {
+        const std::size_t num_pixels = static_cast<std::size_t>(this->width) * this->height;
+        const int value_size = this->float_pixels ? sizeof(float) : 1;
+        if (view.empty()) {
+            const std::vector<unsigned char>& pixels = frame.getPixels();
+            if (frame.channels_first || this->channels == 1)
+                std::memcpy(destination, &pixels[0], pixels.size());
+            else
+                splitChannels(&pixels[0], destination, num_pixels);
+        }
+        else if (this->channels == 1) {
+            view.copyTo(destination);
+        }
+        else if (view.isPacked()) {
+            splitChannels(view.pixel(0, 0), destination, num_pixels);
+        }
+        else if (view.getPixelStride() == view.getChannels()) {
+            // Whole rows, but apart or bottom to top - de-interleave a row at a time, and copy it into the planes:
+            const std::size_t row_size = static_cast<std::size_t>(this->width) * value_size;
+            this->row.resize(row_size * this->channels);
+            for (int y = 0; y < this->height; y++) {
+                splitChannels(view.pixel(0, y), &this->row[0], this->width);
+                for (int c = 0; c < this->channels; c++)
+                    std::memcpy(destination + c * num_pixels * value_size + y * row_size, &this->row[c * row_size], row_size);
+            }
+        }
+        else {
+            for (int y = 0; y < this->height; y++)
+                for (int x = 0; x < this->width; x++)
+                    for (int c = 0; c < this->channels; c++)
+                        std::memcpy(destination + (c * num_pixels + y * this->width + x) * value_size, view.pixel(x, y) + c * value_size, value_size);
+        }
+    }
+
+    // Splits num_pixels interleaved pixels into one plane per channel, each num_pixels values long.
+    void FrameStack::splitChannels(const unsigned char* source, unsigned char* destination, std::size_t num_pixels)
+    {
+        if (!this->float_pixels) {
+            deinterleaveChannels(source, destination, num_pixels, this->channels);
+        }
+        else {
+            // Float pixels - de-interleave four bytes at a time:
+            for (std::size_t i = 0; i < num_pixels; i++)
+                for (int c = 0; c < this->channels; c++)
+                    std::memcpy(destination + (c * num_pixels + i) * sizeof(float), source + (i * this->channels + c) * sizeof(float), sizeof(float));
+        }
+    }
+
+    void FrameStack::fitTo(const TimestampedVideoFrame& frame)
+    {
+        if (frame.width != this->width || frame.height != this->height || frame.channels != this->channels || frame.float_pixels != this->float_pixels) {
+            this->width = frame.width;
+            this->height = frame.height;
+            this->channels = frame.channels;
+            this->float_pixels = frame.float_pixels;
+            reset();
+        }
+    }
+
+    void FrameStack::reset()
+    {
+        this->spare.reset();
+        if (this->data && this->data.use_count() != 1)
+            this->data.reset();     // (no point copying contents we're about to clear)
+        if (!this->data)
+            this->data = boost::make_shared<Buffer>();
+        this->data->bytes.assign(getDepth() * getFrameSize(), 0);
+        this->data->stamps.assign(getDepth(), 0);
+        std::fill(this->timestamps.begin(), this->timestamps.end(), boost::posix_time::ptime());
+        this->next = 0;
+        this->count = 0;
+    }
+
+    FrameStack::Buffer& FrameStack::ownData(int slot)
+    {
+        if (!this->data) {
+            reset();
+        }
+        else if (this->data.use_count() != 1) {
+            // A copy of this stack may still be reading the current buffer - if so, write to another. The spare will do if nothing else
+            // is reading it either, once the slots that have changed since it was current are brought up to date (bar the one we're about to fill).
+            boost::shared_ptr<Buffer> next_data;
+            if (this->spare && this->spare.use_count() == 1 && this->spare->bytes.size() == this->data->bytes.size()) {
+                next_data.swap(this->spare);
+                const std::size_t frame_size = getFrameSize();
+                for (int i = 0; i < getDepth(); i++) {
+                    if (i != slot && next_data->stamps[i] != this->data->stamps[i]) {
+                        std::copy(this->data->bytes.begin() + i * frame_size, this->data->bytes.begin() + (i + 1) * frame_size, next_data->bytes.begin() + i * frame_size);
+                        next_data->stamps[i] = this->data->stamps[i];
+                    }
+                }
+            }
+            else {
+                next_data = boost::make_shared<Buffer>(*this->data);
+            }
+            this->spare = this->data;
+            this->data = next_data;
+        }
+        return *this->data;
+    }
+}
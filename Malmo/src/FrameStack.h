@@ -0,0 +1,131 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMESTACK_H_
+#define _FRAMESTACK_H_
+
+// Local:
+#include "TimestampedVideoFrame.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <cstdint>
+#include <vector>
+
+namespace malmo
+{
+    //! The last N frames of a video stream, held in one preallocated N x C x H x W array.
+    //! Each new frame overwrites the oldest slot and the newest index moves on, so nothing is shifted or concatenated.
+    //! Copies of a stack share their storage until the original is next written to. The original then writes to a second array instead,
+    //! copying across only the slots that have changed since it last wrote there - so taking a copy after every frame costs about a frame, not a stack.
+    class FrameStack
+    {
+        public:
+            //! Constructs a stack that holds no frames.
+            FrameStack();
+
+            //! Constructs an empty stack that will hold up to depth frames.
+            //! \param depth The number of frames to keep.
+            explicit FrameStack(int depth);
+
+            //! Constructs a copy of a stack, which shares its storage.
+            FrameStack(const FrameStack& other);
+
+            //! Makes this stack a copy of another, sharing its storage.
+            FrameStack& operator=(const FrameStack& other);
+
+            //! Returns the number of slots, N.
+            int getDepth() const { return static_cast<int>(this->timestamps.size()); }
+
+            //! Returns the number of slots that have been filled since the last reset, up to N.
+            int getCount() const { return this->count; }
+
+            //! Returns the width of each frame in pixels.
+            short getWidth() const { return this->width; }
+
+            //! Returns the height of each frame in pixels.
+            short getHeight() const { return this->height; }
+
+            //! Returns the number of channels in each frame.
+            short getChannels() const { return this->channels; }
+
+            //! Returns true if each value is a 32-bit float rather than a byte.
+            bool isFloat() const { return this->float_pixels; }
+
+            //! Returns the number of bytes in each slot.
+            std::size_t getFrameSize() const;
+
+            //! Returns the slot holding a frame, given how many frames ago it arrived.
+            //! \param age 0 for the newest frame, 1 for the one before it, and so on up to N - 1.
+            //! \returns The index of the slot in the data array.
+            int getSlot(int age) const;
+
+            //! Returns the slot holding the newest frame. Equivalent to getSlot(0).
+            int getNewestSlot() const { return getSlot(0); }
+
+            //! Returns the timestamp of the frame in a slot, or not_a_date_time if the slot hasn't been filled.
+            boost::posix_time::ptime getTimestamp(int slot) const;
+
+            //! Returns the N x C x H x W array of all the slots. Slots that haven't been filled are zero.
+            const std::vector<unsigned char>& getData() const;
+
+            //! Copies a frame into the oldest slot, planar (CHW) whatever the layout of the frame. The frame's pixels are read through its view,
+            //! so a frame that hasn't been packed (e.g. one that is still upside down) doesn't need to be.
+            //! If the frame's shape differs from the frames already held, the stack is reset first.
+            void push(const TimestampedVideoFrame& frame);
+
+            //! Copies a frame into a given slot, planar (CHW) as for push, but without moving on the newest index or the count - for keeping
+            //! the latest frame from each of several sources side by side. If the frame's shape differs from the frames already held, the stack is reset first.
+            //! \param slot The index of the slot in the data array.
+            //! \param frame The frame.
+            void put(int slot, const TimestampedVideoFrame& frame);
+
+            //! Empties the stack, zeroing every slot.
+            void reset();
+
+        private:
+            // The N x C x H x W array, and a stamp for each slot that changes whenever the slot is written to.
+            struct Buffer
+            {
+                std::vector<unsigned char> bytes;
+                std::vector<std::uint64_t> stamps;
+            };
+
+            void fitTo(const TimestampedVideoFrame& frame);
+            void copyFrame(const TimestampedVideoFrame& frame, const FrameView& view, unsigned char* destination);
+            void splitChannels(const unsigned char* source, unsigned char* destination, std::size_t num_pixels);
+            Buffer& ownData(int slot);
+
+            boost::shared_ptr<Buffer> data;
+            boost::shared_ptr<Buffer> spare;    // the buffer that was current before data, if a copy was still reading it - not shared with copies of the stack
+            std::vector<unsigned char> row;     // for de-interleaving a row at a time
+            std::vector<boost::posix_time::ptime> timestamps;
+            int next;
+            int count;
+            short width;
+            short height;
+            short channels;
+            bool float_pixels;
+    };
+}
+
+#endif
@@ -0,0 +1,344 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FrameTransforms.h"
+
+// STL:
+#include <atomic>
+#include <cstring>
+
+// Each kernel is compiled for its own instruction set and picked at runtime, so the library
+// itself can still be built for (and run on) a baseline CPU.
+#if ( defined(__GNUC__) || defined(__clang__) ) && ( defined(__x86_64__) || defined(__i386__) )
+    #define MALMO_SIMD_X86
+    #define MALMO_TARGET(isa) __attribute__((target(isa)))
+    #include <immintrin.h>
+#elif defined(_MSC_VER) && ( defined(_M_X64) || defined(_M_IX86) )
+    #define MALMO_SIMD_X86
+    #define MALMO_TARGET(isa)
+    #include <intrin.h>
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define MALMO_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace malmo
+{
+    namespace
+    {
+        SimdLevel detectSimdLevel()
+        {
+#if defined(MALMO_SIMD_X86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 0);
+            const int max_leaf = info[0];
+            __cpuid(info, 1);
+            const bool sse2 = (info[3] & (1 << 26)) != 0;
+            const bool ssse3 = (info[2] & (1 << 9)) != 0;
+            const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            bool avx2 = false;
+            if (max_leaf >= 7 && os_saves_ymm) {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+            return avx2 ? SIMD_AVX2 : ssse3 ? SIMD_SSSE3 : sse2 ? SIMD_SSE2 : SIMD_NONE;
+#elif defined(MALMO_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return SIMD_AVX2;
+            if (__builtin_cpu_supports("ssse3"))
+                return SIMD_SSSE3;
+            if (__builtin_cpu_supports("sse2"))
+                return SIMD_SSE2;
+            return SIMD_NONE;
+#elif defined(MALMO_SIMD_NEON)
+            return SIMD_NEON;
+#else
+            return SIMD_NONE;
+#endif
+        }
+
+        SimdLevel bestSimdLevel()
+        {
+            static const SimdLevel best = detectSimdLevel();
+            return best;
+        }
+
+        std::atomic<int>& currentSimdLevel()
+        {
+            static std::atomic<int> level(bestSimdLevel());
+            return level;
+        }
+
+        // ------------------------------------------ scalar ------------------------------------------
+
+        void swapRedBlueScalar(unsigned char* pixels, std::size_t num_pixels, int channels)
+        {
+            for (std::size_t i = 0; i < num_pixels; i++, pixels += channels) {
+                unsigned char t = pixels[0];
+                pixels[0] = pixels[2];
+                pixels[2] = t;
+            }
+        }
+
+#ifdef MALMO_SIMD_X86
+        // ------------------------------------------- x86 --------------------------------------------
+
+        // Four-byte pixels: keep bytes 1 and 3, exchange bytes 0 and 2 of every 32-bit lane.
+        MALMO_TARGET("sse2") std::size_t swapRedBlue4SSE2(unsigned char* pixels, std::size_t num_pixels)
+        {
+            const __m128i keep = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+            const __m128i low = _mm_set1_epi32(0x000000FF);
+            std::size_t i = 0;
+            for (; i + 4 <= num_pixels; i += 4, pixels += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+                __m128i r = _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), low), _mm_slli_epi32(_mm_and_si128(v, low), 16)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), r);
+            }
+            return i;
+        }
+
+        // Three-byte pixels: sixteen pixels (three 16-byte loads) at a time. Two of the pixels straddle the loads,
+        // so each output vector is shuffled together from its own load and its neighbours.
+        MALMO_TARGET("ssse3") std::size_t swapRedBlue3SSSE3(unsigned char* pixels, std::size_t num_pixels)
+        {
+            const __m128i m00 = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -1);
+            const __m128i m01 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1);
+            const __m128i m10 = _mm_setr_epi8(-1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i m11 = _mm_setr_epi8(0, -1, 4, 3, 2, 7, 6, 5, 10, 9, 8, 13, 12, 11, -1, 15);
+            const __m128i m12 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, -1);
+            const __m128i m21 = _mm_setr_epi8(14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i m22 = _mm_setr_epi8(-1, 3, 2, 1, 6, 5, 4, 9, 8, 7, 12, 11, 10, 15, 14, 13);
+            std::size_t i = 0;
+            for (; i + 16 <= num_pixels; i += 16, pixels += 48) {
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16));
+                __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 32));
+                __m128i b0 = _mm_or_si128(_mm_shuffle_epi8(a0, m00), _mm_shuffle_epi8(a1, m01));
+                __m128i b1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, m10), _mm_shuffle_epi8(a1, m11)), _mm_shuffle_epi8(a2, m12));
+                __m128i b2 = _mm_or_si128(_mm_shuffle_epi8(a1, m21), _mm_shuffle_epi8(a2, m22));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), b0);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 16), b1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + 32), b2);
+            }
+            return i;
+        }
+
+        MALMO_TARGET("avx2") std::size_t swapRedBlue4AVX2(unsigned char* pixels, std::size_t num_pixels)
+        {
+            const __m256i mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                                  2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+            std::size_t i = 0;
+            for (; i + 8 <= num_pixels; i += 8, pixels += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels), _mm256_shuffle_epi8(v, mask));
+            }
+            return i;
+        }
+
+        // Three channels: gather each plane's sixteen bytes out of three consecutive 16-byte loads.
+        MALMO_TARGET("ssse3") std::size_t deinterleave3SSSE3(const unsigned char* src, unsigned char* dst, std::size_t num_pixels)
+        {
+            const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+            const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+            const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+            const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+            const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+            const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+            std::size_t i = 0;
+            for (; i + 16 <= num_pixels; i += 16, src += 48) {
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+                __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, r0), _mm_shuffle_epi8(a1, r1)), _mm_shuffle_epi8(a2, r2));
+                __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, g0), _mm_shuffle_epi8(a1, g1)), _mm_shuffle_epi8(a2, g2));
+                __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, b0), _mm_shuffle_epi8(a1, b1)), _mm_shuffle_epi8(a2, b2));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), r);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + num_pixels + i), g);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * num_pixels + i), b);
+            }
+            return i;
+        }
+
+        // Four channels: a 16x4 byte transpose done with three rounds of unpacking.
+        MALMO_TARGET("sse2") std::size_t deinterleave4SSE2(const unsigned char* src, unsigned char* dst, std::size_t num_pixels)
+        {
+            std::size_t i = 0;
+            for (; i + 16 <= num_pixels; i += 16, src += 64) {
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+                __m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+                __m128i b0 = _mm_unpacklo_epi8(a0, a1);
+                __m128i b1 = _mm_unpackhi_epi8(a0, a1);
+                __m128i b2 = _mm_unpacklo_epi8(a2, a3);
+                __m128i b3 = _mm_unpackhi_epi8(a2, a3);
+                __m128i c0 = _mm_unpacklo_epi8(b0, b1);
+                __m128i c1 = _mm_unpackhi_epi8(b0, b1);
+                __m128i c2 = _mm_unpacklo_epi8(b2, b3);
+                __m128i c3 = _mm_unpackhi_epi8(b2, b3);
+                __m128i d0 = _mm_unpacklo_epi8(c0, c1);  // channels 0 and 1 of pixels 0-7
+                __m128i d1 = _mm_unpackhi_epi8(c0, c1);  // channels 2 and 3 of pixels 0-7
+                __m128i d2 = _mm_unpacklo_epi8(c2, c3);  // channels 0 and 1 of pixels 8-15
+                __m128i d3 = _mm_unpackhi_epi8(c2, c3);  // channels 2 and 3 of pixels 8-15
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi64(d0, d2));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + num_pixels + i), _mm_unpackhi_epi64(d0, d2));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * num_pixels + i), _mm_unpacklo_epi64(d1, d3));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * num_pixels + i), _mm_unpackhi_epi64(d1, d3));
+            }
+            return i;
+        }
+#endif
+
+#ifdef MALMO_SIMD_NEON
+        // ------------------------------------------- NEON -------------------------------------------
+
+        std::size_t swapRedBlueNEON(unsigned char* pixels, std::size_t num_pixels, int channels)
+        {
+            std::size_t i = 0;
+            if (channels == 3) {
+                for (; i + 16 <= num_pixels; i += 16, pixels += 48) {
+                    uint8x16x3_t v = vld3q_u8(pixels);
+                    uint8x16_t t = v.val[0]; v.val[0] = v.val[2]; v.val[2] = t;
+                    vst3q_u8(pixels, v);
+                }
+            }
+            else {
+                for (; i + 16 <= num_pixels; i += 16, pixels += 64) {
+                    uint8x16x4_t v = vld4q_u8(pixels);
+                    uint8x16_t t = v.val[0]; v.val[0] = v.val[2]; v.val[2] = t;
+                    vst4q_u8(pixels, v);
+                }
+            }
+            return i;
+        }
+
+        std::size_t deinterleaveNEON(const unsigned char* src, unsigned char* dst, std::size_t num_pixels, int channels)
+        {
+            std::size_t i = 0;
+            if (channels == 3) {
+                for (; i + 16 <= num_pixels; i += 16, src += 48) {
+                    uint8x16x3_t v = vld3q_u8(src);
+                    for (int c = 0; c < 3; c++)
+                        vst1q_u8(dst + c * num_pixels + i, v.val[c]);
+                }
+            }
+            else {
+                for (; i + 16 <= num_pixels; i += 16, src += 64) {
+                    uint8x16x4_t v = vld4q_u8(src);
+                    for (int c = 0; c < 4; c++)
+                        vst1q_u8(dst + c * num_pixels + i, v.val[c]);
+                }
+            }
+            return i;
+        }
+#endif
+    }
+
+    SimdLevel getSimdLevel()
+    {
+        return static_cast<SimdLevel>(currentSimdLevel().load());
+    }
+
+    bool setSimdLevel(SimdLevel level)
+    {
+        const SimdLevel best = bestSimdLevel();
+        const bool supported = level == SIMD_NONE || (best == SIMD_NEON ? level == SIMD_NEON : level != SIMD_NEON && level <= best);
+        if (supported)
+            currentSimdLevel().store(level);
+        return supported;
+    }
+
+    void flipScanlines(const unsigned char* src, unsigned char* dst, std::size_t row_bytes, std::size_t rows)
+    {
+        // Each row is a straight copy, and memcpy is already vectorised for the host - there is nothing to gain from our own kernels here.
+        src += rows * row_bytes;
+        for (std::size_t i = 0; i < rows; i++, dst += row_bytes) {
+            src -= row_bytes;
+            std::memcpy(dst, src, row_bytes);
+        }
+    }
+
+    void swapRedBlue(unsigned char* pixels, std::size_t num_pixels, int channels)
+    {
+        if (channels != 3 && channels != 4)
+            return;
+
+        std::size_t done = 0;
+        switch (getSimdLevel()) {
+#ifdef MALMO_SIMD_X86
+        case SIMD_AVX2:
+            // (Three-byte pixels don't divide evenly into AVX2's 128-bit lanes, so they stay with SSSE3.)
+            done = (channels == 3) ? swapRedBlue3SSSE3(pixels, num_pixels) : swapRedBlue4AVX2(pixels, num_pixels);
+            break;
+        case SIMD_SSSE3:
+            done = (channels == 3) ? swapRedBlue3SSSE3(pixels, num_pixels) : swapRedBlue4SSE2(pixels, num_pixels);
+            break;
+        case SIMD_SSE2:
+            done = (channels == 3) ? 0 : swapRedBlue4SSE2(pixels, num_pixels);
+            break;
+#endif
+#ifdef MALMO_SIMD_NEON
+        case SIMD_NEON:
+            done = swapRedBlueNEON(pixels, num_pixels, channels);
+            break;
+#endif
+        default:
+            break;
+        }
+        swapRedBlueScalar(pixels + done * channels, num_pixels - done, channels);
+    }
+
+    void deinterleaveChannels(const unsigned char* src, unsigned char* dst, std::size_t num_pixels, int channels)
+    {
+        if (channels == 1) {
+            std::memcpy(dst, src, num_pixels);
+            return;
+        }
+
+        std::size_t done = 0;
+        switch (getSimdLevel()) {
+#ifdef MALMO_SIMD_X86
+        case SIMD_AVX2:     // (wider registers don't help here - the 128-bit kernels already keep up with memory)
+        case SIMD_SSSE3:
+            done = (channels == 3) ? deinterleave3SSSE3(src, dst, num_pixels) : (channels == 4) ? deinterleave4SSE2(src, dst, num_pixels) : 0;
+            break;
+        case SIMD_SSE2:
+            done = (channels == 4) ? deinterleave4SSE2(src, dst, num_pixels) : 0;
+            break;
+#endif
+#ifdef MALMO_SIMD_NEON
+        case SIMD_NEON:
+            done = (channels == 3 || channels == 4) ? deinterleaveNEON(src, dst, num_pixels, channels) : 0;
+            break;
+#endif
+        default:
+            break;
+        }
+        // Whatever the vector kernel didn't cover (or everything, if there isn't one):
+        for (std::size_t i = done; i < num_pixels; i++)
+            for (int c = 0; c < channels; c++)
+                dst[c * num_pixels + i] = src[i * channels + c];
+    }
+}
@@ -0,0 +1,67 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMETRANSFORMS_H_
+#define _FRAMETRANSFORMS_H_
+
+// STL:
+#include <cstddef>
+
+namespace malmo
+{
+    //! The instruction sets that the pixel transforms below can be dispatched to.
+    enum SimdLevel {
+          SIMD_NONE                  //!< Plain scalar code.
+        , SIMD_SSE2                  //!< x86 SSE2.
+        , SIMD_SSSE3                 //!< x86 SSSE3 (byte shuffles).
+        , SIMD_AVX2                  //!< x86 AVX2.
+        , SIMD_NEON                  //!< ARM NEON.
+    };
+
+    //! Gets the instruction set that the pixel transforms are currently using.
+    //! By default this is the best one that the CPU we are running on supports.
+    SimdLevel getSimdLevel();
+
+    //! Forces the pixel transforms to use a particular instruction set - mainly for testing against the scalar path.
+    //! \param level The instruction set to use.
+    //! \returns False (and leaves the current level unchanged) if this CPU doesn't support the requested level.
+    bool setSimdLevel(SimdLevel level);
+
+    //! Copies an image, reversing the order of its rows.
+    //! \param src The source rows, row_bytes apart.
+    //! \param dst The destination, which must not overlap the source.
+    //! \param row_bytes The length of a row in bytes.
+    //! \param rows The number of rows.
+    void flipScanlines(const unsigned char* src, unsigned char* dst, std::size_t row_bytes, std::size_t rows);
+
+    //! Swaps the first and third bytes of every pixel in place, converting BGR to RGB (or BGRA to RGBA) and back.
+    //! \param pixels The interleaved pixel data.
+    //! \param num_pixels The number of pixels.
+    //! \param channels The number of bytes per pixel - 3 or 4. Anything else is left untouched.
+    void swapRedBlue(unsigned char* pixels, std::size_t num_pixels, int channels);
+
+    //! Splits interleaved pixels (e.g. RGBD) into one plane per channel.
+    //! \param src The interleaved pixel data.
+    //! \param dst The destination, which receives channels consecutive planes of num_pixels bytes each.
+    //! \param num_pixels The number of pixels.
+    //! \param channels The number of bytes per pixel.
+    void deinterleaveChannels(const unsigned char* src, unsigned char* dst, std::size_t num_pixels, int channels);
+}
+
+#endif
@@ -0,0 +1,117 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "FrameView.h"
+
+// STL:
+#include <cstring>
+#include <stdexcept>
+
+namespace malmo
+{
+    FrameView::FrameView()
+        : origin(0)
+        , width(0)
+        , height(0)
+        , channels(0)
+        , row_stride(0)
+        , pixel_stride(0)
+    {
+    }
+
+    FrameView::FrameView(boost::shared_ptr< const std::vector<unsigned char> > buffer, std::ptrdiff_t origin, short width, short height, short channels, std::ptrdiff_t row_stride, std::ptrdiff_t pixel_stride)
+        : buffer(buffer)
+        , origin(origin)
+        , width(width)
+        , height(height)
+        , channels(channels)
+        , row_stride(row_stride)
+        , pixel_stride(pixel_stride)
+    {
+        if (this->empty())
+            return;
+
+        // Check that all four corners lie within the buffer:
+        const std::ptrdiff_t size = buffer ? static_cast<std::ptrdiff_t>(buffer->size()) : 0;
+        const std::ptrdiff_t last_row = (height - 1) * row_stride;
+        const std::ptrdiff_t last_pixel = (width - 1) * pixel_stride;
+        const std::ptrdiff_t corners[] = { origin, origin + last_row, origin + last_pixel, origin + last_row + last_pixel };
+        for (std::ptrdiff_t corner : corners) {
+            if (corner < 0 || corner + channels > size)
+                throw std::out_of_range("Frame view lies outside its buffer.");
+        }
+    }
+
+    bool FrameView::isPacked() const
+    {
+        return this->pixel_stride == this->channels && this->row_stride == this->width * this->channels;
+    }
+
+    unsigned char FrameView::getValue(int x, int y, int channel) const
+    {
+        if (x < 0 || x >= this->width || y < 0 || y >= this->height || channel < 0 || channel >= this->channels)
+            throw std::out_of_range("Pixel coordinates lie outside the frame view.");
+        return this->pixel(x, y)[channel];
+    }
+
+    FrameView FrameView::crop(int x, int y, int width, int height) const
+    {
+        if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > this->width || y + height > this->height)
+            throw std::out_of_range("Crop rectangle lies outside the frame view.");
+        if (width == 0 || height == 0)
+            return FrameView();
+        return FrameView(this->buffer, this->origin + y * this->row_stride + x * this->pixel_stride, width, height, this->channels, this->row_stride, this->pixel_stride);
+    }
+
+    FrameView FrameView::subsample(int step) const
+    {
+        if (step < 1)
+            throw std::invalid_argument("Subsampling step must be at least one.");
+        if (this->empty())
+            return FrameView();
+        return FrameView(this->buffer, this->origin, (this->width + step - 1) / step, (this->height + step - 1) / step, this->channels, this->row_stride * step, this->pixel_stride * step);
+    }
+
+    void FrameView::copyTo(unsigned char* dst) const
+    {
+        if (this->empty())
+            return;
+
+        const std::size_t row_bytes = this->width * this->channels;
+        for (int y = 0; y < this->height; y++, dst += row_bytes) {
+            const unsigned char* src = this->pixel(0, y);
+            if (this->pixel_stride == this->channels) {
+                std::memcpy(dst, src, row_bytes);
+            }
+            else {
+                for (int x = 0; x < this->width; x++, src += this->pixel_stride)
+                    std::memcpy(dst + x * this->channels, src, this->channels);
+            }
+        }
+    }
+
+    std::vector<unsigned char> FrameView::packed() const
+    {
+        std::vector<unsigned char> result(static_cast<std::size_t>(this->width) * this->height * this->channels);
+        if (!result.empty())
+            this->copyTo(&result[0]);
+        return result;
+    }
+}
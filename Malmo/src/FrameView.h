@@ -0,0 +1,103 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _FRAMEVIEW_H_
+#define _FRAMEVIEW_H_
+
+// Boost:
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <cstddef>
+#include <vector>
+
+namespace malmo
+{
+    //! A read-only window onto an image held in a shared buffer, addressed by an origin and row/pixel strides.
+    //! Strides may be negative (e.g. for images stored bottom-to-top), and cropping or subsampling a view copies no pixels.
+    //! The view keeps its buffer alive for as long as it exists.
+    class FrameView
+    {
+        public:
+            //! Constructs an empty view.
+            FrameView();
+
+            //! Constructs a view onto part of a buffer.
+            //! \param buffer The buffer holding the image.
+            //! \param origin The offset in bytes of the first channel of the top-left pixel.
+            //! \param width The width of the image in pixels.
+            //! \param height The height of the image in pixels.
+            //! \param channels The number of bytes per pixel.
+            //! \param row_stride The number of bytes from a pixel to the one below it. Negative for bottom-to-top images.
+            //! \param pixel_stride The number of bytes from a pixel to the one on its right.
+            FrameView(boost::shared_ptr< const std::vector<unsigned char> > buffer, std::ptrdiff_t origin, short width, short height, short channels, std::ptrdiff_t row_stride, std::ptrdiff_t pixel_stride);
+
+            //! Returns the width of the view in pixels.
+            short getWidth() const { return this->width; }
+
+            //! Returns the height of the view in pixels.
+            short getHeight() const { return this->height; }
+
+            //! Returns the number of channels (bytes) per pixel.
+            short getChannels() const { return this->channels; }
+
+            //! Returns the number of bytes from a pixel to the one below it.
+            std::ptrdiff_t getRowStride() const { return this->row_stride; }
+
+            //! Returns the number of bytes from a pixel to the one on its right.
+            std::ptrdiff_t getPixelStride() const { return this->pixel_stride; }
+
+            //! Returns true if the view has no pixels.
+            bool empty() const { return this->width == 0 || this->height == 0; }
+
+            //! Returns true if the view is laid out top-to-bottom with no gaps, i.e. it is the same as its packed() copy.
+            bool isPacked() const;
+
+            //! Returns a pointer to the first channel of a pixel. No bounds checking.
+            const unsigned char* pixel(int x, int y) const { return this->base() + y * this->row_stride + x * this->pixel_stride; }
+
+            //! Returns the value of one channel of one pixel. Throws std::out_of_range for coordinates outside the view.
+            unsigned char getValue(int x, int y, int channel) const;
+
+            //! Returns a view onto a rectangle within this one. Throws std::out_of_range if the rectangle doesn't fit.
+            FrameView crop(int x, int y, int width, int height) const;
+
+            //! Returns a view onto every step'th pixel of every step'th row, starting from the top-left.
+            FrameView subsample(int step) const;
+
+            //! Copies the view into dst as packed rows, top to bottom, width * height * channels bytes in all.
+            void copyTo(unsigned char* dst) const;
+
+            //! Returns a packed copy of the view, laid out as for copyTo.
+            std::vector<unsigned char> packed() const;
+
+        private:
+            const unsigned char* base() const { return &(*this->buffer)[0] + this->origin; }
+
+            boost::shared_ptr< const std::vector<unsigned char> > buffer;
+            std::ptrdiff_t origin;
+            short width;
+            short height;
+            short channels;
+            std::ptrdiff_t row_stride;
+            std::ptrdiff_t pixel_stride;
+    };
+}
+
+#endif
@@ -17,12 +17,132 @@
 //  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // --------------------------------------------------------------------------------------------------
 
+// Local:
 #include "Init.h"
+#include "FindSchemaFile.h"
+
+// Xerces:
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/framework/MemBufInputSource.hpp>
+#include <xercesc/framework/Wrapper4InputSource.hpp>
+#include <xercesc/framework/XMLGrammarPoolImpl.hpp>
+#include <xercesc/util/XMLUni.hpp>
+#include <xercesc/validators/common/Grammar.hpp>
+
+// CodeSynthesis:
+#include <xsd/cxx/tree/error-handler.hxx>
+#include <xsd/cxx/xml/dom/bits/error-handler-proxy.hxx>
+#include <xsd/cxx/xml/string.hxx>
 
 namespace malmo
 {
     void initialiser::initXSD()
+    {
+        instance();
+    }
+
+    initialiser& initialiser::instance()
     {
         static initialiser init;
+        return init;
+    }
+
+    xercesc::XMLGrammarPool& initialiser::getGrammarPool()
+    {
+        initialiser& init = instance();
+        std::call_once(init.grammar_pool_flag, &initialiser::loadGrammarPool, &init);
+        return *init.grammar_pool;
+    }
+
+    namespace
+    {
+        std::unique_ptr<xercesc::DOMLSParser, XercesReleaser> createParser(xercesc::XMLGrammarPool* pool)
+        {
+            using namespace xercesc;
+
+            const XMLCh ls_id[] = { chLatin_L, chLatin_S, chNull };
+            DOMImplementation* impl = DOMImplementationRegistry::getDOMImplementation(ls_id);
+            std::unique_ptr<DOMLSParser, XercesReleaser> parser(impl->createLSParser(DOMImplementationLS::MODE_SYNCHRONOUS, 0, XMLPlatformUtils::fgMemoryManager, pool));
+
+            DOMConfiguration* config = parser->getDomConfig();
+            config->setParameter(XMLUni::fgDOMComments, false);
+            config->setParameter(XMLUni::fgDOMDatatypeNormalization, true);
+            config->setParameter(XMLUni::fgDOMEntities, false);
+            config->setParameter(XMLUni::fgDOMNamespaces, true);
+            config->setParameter(XMLUni::fgDOMElementContentWhitespace, false);
+            config->setParameter(XMLUni::fgXercesSchema, true);
+            config->setParameter(XMLUni::fgXercesSchemaFullChecking, false);
+            config->setParameter(XMLUni::fgXercesHandleMultipleImports, true);
+            config->setParameter(XMLUni::fgXercesUserAdoptsDOMDocument, true);
+            return parser;
+        }
+    }
+
+    void initialiser::loadGrammarPool()
+    {
+        using namespace xercesc;
+
+        // The schemas all share one target namespace, and a grammar pool holds one grammar per namespace, so they have to be
+        // compiled together: through a schema that includes MissionInit.xsd and MissionEnded.xsd, which between them include
+        // the rest. Its system id puts it beside the real schemas, so that the includes are resolved from there.
+        const std::string mission_init_path = FindSchemaFile("MissionInit.xsd");
+        const std::string schema_folder = mission_init_path.substr(0, mission_init_path.find_last_of("/\\") + 1);
+        const std::string system_id = schema_folder + "MalmoSchemas.xsd";
+        const std::string all_schemas = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+            "<xs:schema xmlns:xs=\"http://www.w3.org/2001/XMLSchema\" targetNamespace=\"" + xml_namespace + "\" elementFormDefault=\"qualified\">"
+            "<xs:include schemaLocation=\"MissionInit.xsd\"/>"
+            "<xs:include schemaLocation=\"MissionEnded.xsd\"/>"
+            "</xs:schema>";
+
+        std::unique_ptr<XMLGrammarPool> pool(new XMLGrammarPoolImpl(XMLPlatformUtils::fgMemoryManager));
+        {
+            std::unique_ptr<DOMLSParser, XercesReleaser> parser = createParser(pool.get());
+            xsd::cxx::tree::error_handler<char> handler;
+            xsd::cxx::xml::dom::bits::error_handler_proxy<char> handler_proxy(handler);
+            parser->getDomConfig()->setParameter(XMLUni::fgDOMErrorHandler, &handler_proxy);
+
+            MemBufInputSource source(reinterpret_cast<const XMLByte*>(all_schemas.data()), all_schemas.size(), xsd::cxx::xml::string(system_id).c_str());
+            Wrapper4InputSource wrapped_source(&source, false);
+            const bool cache = true;
+            if (!parser->loadGrammar(&wrapped_source, Grammar::SchemaGrammarType, cache) || handler_proxy.failed())
+            {
+                handler.throw_if_failed<xml_schema::parsing>();
+                throw xml_schema::parsing();
+            }
+        }
+
+        // Once locked the pool can't change, so any number of parsers can share it.
+        pool->lockPool();
+        this->grammar_pool = std::move(pool);
+    }
+
+    DOMDocumentPtr ParseXML(const std::string& xml, bool validate)
+    {
+        using namespace xercesc;
+
+        initialiser::initXSD();
+        std::unique_ptr<DOMLSParser, XercesReleaser> parser = createParser(validate ? &initialiser::getGrammarPool() : 0);
+        DOMConfiguration* config = parser->getDomConfig();
+        config->setParameter(XMLUni::fgDOMValidate, validate);
+        if (validate) {
+            // Only ever validate against the pool's grammar, never against whatever schemaLocation the document names.
+            config->setParameter(XMLUni::fgXercesUseCachedGrammarInParse, true);
+            config->setParameter(XMLUni::fgXercesLoadSchema, false);
+            config->setParameter(XMLUni::fgXercesValidationErrorAsFatal, true);
+        }
+
+        xsd::cxx::tree::error_handler<char> handler;
+        xsd::cxx::xml::dom::bits::error_handler_proxy<char> handler_proxy(handler);
+        config->setParameter(XMLUni::fgDOMErrorHandler, &handler_proxy);
+
+        MemBufInputSource source(reinterpret_cast<const XMLByte*>(xml.data()), xml.size(), "");
+        Wrapper4InputSource wrapped_source(&source, false);
+        DOMDocumentPtr doc(parser->parse(&wrapped_source));
+        if (!doc || handler_proxy.failed())
+        {
+            handler.throw_if_failed<xml_schema::parsing>();
+            throw xml_schema::parsing();
+        }
+        return doc;
     }
 }
@@ -22,6 +22,14 @@
 
 #include <MissionEnded.h>
 
+// Xerces:
+#include <xercesc/framework/XMLGrammarPool.hpp>
+
+// STL:
+#include <memory>
+#include <mutex>
+#include <string>
+
 namespace malmo
 {
     struct initialiser
@@ -32,10 +40,39 @@ namespace malmo
         }
         ~initialiser()
         {
+            this->grammar_pool.reset(); // (must go before Xerces does)
             xercesc::XMLPlatformUtils::Terminate();
         }
         static void initXSD();
+
+        //! Gets the grammar of the Malmo schemas, compiled from the .xsd files the first time it is asked for and then locked,
+        //! so that it can be shared by every validating parse, on any thread, for the life of the process.
+        //! Throws xml_schema::parsing if the schemas can't be compiled, or std::runtime_error if they can't be found.
+        static xercesc::XMLGrammarPool& getGrammarPool();
+
+    private:
+        static initialiser& instance();
+        void loadGrammarPool();
+
+        std::unique_ptr<xercesc::XMLGrammarPool> grammar_pool;
+        std::once_flag grammar_pool_flag;
     };
+
+    //! Releases a Xerces object when its owning pointer goes.
+    struct XercesReleaser
+    {
+        template<typename T> void operator()(T* p) const
+        {
+            if (p)
+                p->release();
+        }
+    };
+    typedef std::unique_ptr<xercesc::DOMDocument, XercesReleaser> DOMDocumentPtr;
+
+    //! Parses an XML string into a DOM document, ready for the generated schema types to be built from it.
+    //! If validate is true, validates it against the grammar of the Malmo schemas, which is compiled once per process.
+    //! Throws xml_schema::parsing if the string isn't well-formed, or if it is being validated and isn't valid.
+    DOMDocumentPtr ParseXML(const std::string& xml, bool validate);
 }
 
 #endif
\ No newline at end of file
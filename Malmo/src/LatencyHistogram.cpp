@@ -0,0 +1,152 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "LatencyHistogram.h"
+
+// STL:
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace malmo
+{
+    LatencyHistogram::LatencyHistogram()
+    {
+        reset();
+    }
+
+    LatencyHistogram::LatencyHistogram(const LatencyHistogram& other)
+    {
+        *this = other;
+    }
+
+    LatencyHistogram& LatencyHistogram::operator=(const LatencyHistogram& other)
+    {
+        for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            this->buckets[bucket] = other.buckets[bucket].load();
+        this->count = other.count.load();
+        this->total_microseconds = other.total_microseconds.load();
+        this->min_microseconds = other.min_microseconds.load();
+        this->max_microseconds = other.max_microseconds.load();
+        return *this;
+    }
+
+    void LatencyHistogram::add(boost::posix_time::time_duration latency)
+    {
+        const int64_t microseconds = std::max<int64_t>(0, latency.total_microseconds());
+        this->buckets[bucketFor(microseconds)]++;
+        this->total_microseconds += microseconds;
+
+        int64_t min = this->min_microseconds.load();
+        while (microseconds < min && !this->min_microseconds.compare_exchange_weak(min, microseconds)) {}
+        int64_t max = this->max_microseconds.load();
+        while (microseconds > max && !this->max_microseconds.compare_exchange_weak(max, microseconds)) {}
+
+        // (Counted last, so that a latency is never counted before its bucket is.)
+        this->count++;
+    }
+
+    void LatencyHistogram::reset()
+    {
+        for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            this->buckets[bucket] = 0;
+        this->count = 0;
+        this->total_microseconds = 0;
+        this->min_microseconds = std::numeric_limits<int64_t>::max();
+        this->max_microseconds = 0;
+    }
+
+    int LatencyHistogram::getCount() const
+    {
+        return this->count;
+    }
+
+    double LatencyHistogram::getMeanMs() const
+    {
+        const int count = this->count;
+        return count == 0 ? 0.0 : this->total_microseconds / (1000.0 * count);
+    }
+
+    double LatencyHistogram::getMinMs() const
+    {
+        return this->count == 0 ? 0.0 : this->min_microseconds / 1000.0;
+    }
+
+    double LatencyHistogram::getMaxMs() const
+    {
+        return this->max_microseconds / 1000.0;
+    }
+
+    double LatencyHistogram::getPercentileMs(double percentile) const
+    {
+        int total = 0;
+        for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            total += this->buckets[bucket];
+        if (total == 0)
+            return 0.0;
+
+        // The rank of the latency wanted, counting from 1.
+        const int rank = std::min(total, std::max(1, static_cast<int>(std::ceil(percentile / 100.0 * total))));
+        int so_far = 0;
+        for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+            so_far += this->buckets[bucket];
+            if (so_far >= rank)
+                return std::min(getBucketUpperBoundMs(bucket), getMaxMs());
+        }
+        return getMaxMs();
+    }
+
+    std::vector<int> LatencyHistogram::getBucketCounts() const
+    {
+        std::vector<int> counts(NUM_BUCKETS);
+        for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+            counts[bucket] = this->buckets[bucket];
+        return counts;
+    }
+
+    double LatencyHistogram::getBucketUpperBoundMs(int bucket)
+    {
+        return std::pow(2.0, (bucket + 1) / 4.0) / 1000.0;
+    }
+
+    int LatencyHistogram::bucketFor(int64_t microseconds)
+    {
+        // Bucket b holds latencies from 2^(b/4) up to 2^((b+1)/4) microseconds; bucket 0 also holds everything shorter.
+        if (microseconds <= 1)
+            return 0;
+        const int bucket = static_cast<int>(std::floor(4.0 * std::log2(static_cast<double>(microseconds))));
+        return std::min(bucket, NUM_BUCKETS - 1);
+    }
+
+    std::ostream& operator<<(std::ostream& os, const LatencyHistogram& histogram)
+    {
+        const LatencyHistogram snapshot(histogram);
+        os << "LatencyHistogram: " << snapshot.getCount() << " latencies";
+        if (snapshot.getCount() > 0) {
+            os << ", mean " << snapshot.getMeanMs() << "ms"
+               << ", min " << snapshot.getMinMs() << "ms"
+               << ", median " << snapshot.getPercentileMs(50) << "ms"
+               << ", 90% " << snapshot.getPercentileMs(90) << "ms"
+               << ", 99% " << snapshot.getPercentileMs(99) << "ms"
+               << ", max " << snapshot.getMaxMs() << "ms";
+        }
+        return os;
+    }
+}
@@ -0,0 +1,102 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _LATENCYHISTOGRAM_H_
+#define _LATENCYHISTOGRAM_H_
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+// STL:
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace malmo
+{
+    //! Counts latencies in buckets whose widths grow geometrically - four buckets per doubling, from one microsecond to about a minute -
+    //! so that percentiles can be read off to within 19% over the whole range without keeping every sample.
+    //! Latencies can be added from any thread without locking. A copy is a snapshot, and is what the queries should be asked of
+    //! while other threads are still adding.
+    class LatencyHistogram
+    {
+        public:
+
+            //! The number of buckets. Latencies longer than the last bucket's upper bound are counted in the last bucket.
+            static const int NUM_BUCKETS = 104;
+
+            //! Constructs an empty histogram.
+            LatencyHistogram();
+
+            LatencyHistogram(const LatencyHistogram& other);
+            LatencyHistogram& operator=(const LatencyHistogram& other);
+
+            //! Counts a latency. Negative latencies are counted as zero.
+            //! \param latency The latency.
+            void add(boost::posix_time::time_duration latency);
+
+            //! Empties the histogram.
+            void reset();
+
+            //! Gets the number of latencies counted.
+            //! \returns The number of latencies.
+            int getCount() const;
+
+            //! Gets the mean of the latencies counted.
+            //! \returns The mean latency in milliseconds, or 0 if none have been counted.
+            double getMeanMs() const;
+
+            //! Gets the shortest latency counted.
+            //! \returns The shortest latency in milliseconds, or 0 if none have been counted.
+            double getMinMs() const;
+
+            //! Gets the longest latency counted.
+            //! \returns The longest latency in milliseconds, or 0 if none have been counted.
+            double getMaxMs() const;
+
+            //! Gets a percentile of the latencies counted - at most the upper bound of the bucket it falls in.
+            //! \param percentile The percentile, from 0 to 100. e.g. 50 for the median.
+            //! \returns The latency in milliseconds, or 0 if none have been counted.
+            double getPercentileMs(double percentile) const;
+
+            //! Gets the number of latencies counted in each bucket.
+            //! \returns The counts, NUM_BUCKETS of them.
+            std::vector<int> getBucketCounts() const;
+
+            //! Gets the longest latency that goes in a bucket.
+            //! \param bucket The bucket, from 0 to NUM_BUCKETS - 1.
+            //! \returns The upper bound in milliseconds.
+            static double getBucketUpperBoundMs(int bucket);
+
+            friend std::ostream& operator<<(std::ostream& os, const LatencyHistogram& histogram);
+
+        private:
+
+            static int bucketFor(int64_t microseconds);
+
+            std::atomic<int> buckets[NUM_BUCKETS];
+            std::atomic<int> count;
+            std::atomic<int64_t> total_microseconds;
+            std::atomic<int64_t> min_microseconds;
+            std::atomic<int64_t> max_microseconds;
+    };
+}
+
+#endif
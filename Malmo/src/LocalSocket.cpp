@@ -0,0 +1,107 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "LocalSocket.h"
+
+// Boost:
+#include <boost/filesystem.hpp>
+
+// STL:
+#include <atomic>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace malmo
+{
+    bool IsLocalSocketSupported()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    std::string MakeLocalSocketPrefix()
+    {
+        static std::atomic<int> instance(0);
+#ifdef _WIN32
+        const long process = 0;
+#else
+        const long process = static_cast<long>(getpid());
+#endif
+        const std::string name = "malmo_" + std::to_string(process) + "_" + std::to_string(instance++);
+#ifdef __linux__
+        return "@" + name;
+#else
+        return (boost::filesystem::temp_directory_path() / name).string();
+#endif
+    }
+
+    std::string GetLocalSocketName(const std::string& prefix, int port)
+    {
+        return prefix + "_" + std::to_string(port);
+    }
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    boost::asio::local::stream_protocol::endpoint MakeLocalEndpoint(const std::string& name)
+    {
+        if (!name.empty() && name[0] == '@')
+            return boost::asio::local::stream_protocol::endpoint(std::string(1, '\0') + name.substr(1));
+        return boost::asio::local::stream_protocol::endpoint(name);
+    }
+#endif
+
+    std::string DescribeEndpoint(const boost::asio::generic::stream_protocol::endpoint& endpoint)
+    {
+        // Copy the raw address into an endpoint of the right protocol, which knows how to print it.
+        switch (endpoint.protocol().family())
+        {
+        case AF_INET:
+        case AF_INET6:
+        {
+            boost::asio::ip::tcp::endpoint tcp_endpoint;
+            if (endpoint.size() > tcp_endpoint.capacity())
+                break;
+            std::memcpy(tcp_endpoint.data(), endpoint.data(), endpoint.size());
+            tcp_endpoint.resize(endpoint.size());
+            return tcp_endpoint.address().to_string();
+        }
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        case AF_UNIX:
+        {
+            boost::asio::local::stream_protocol::endpoint local_endpoint;
+            if (endpoint.size() > local_endpoint.capacity())
+                break;
+            std::memcpy(local_endpoint.data(), endpoint.data(), endpoint.size());
+            local_endpoint.resize(endpoint.size());
+            const std::string path = local_endpoint.path();
+            return !path.empty() && path[0] == '\0' ? "@" + path.substr(1) : path;
+        }
+#endif
+        default:
+            break;
+        }
+        return "(unknown endpoint)";
+    }
+}
@@ -0,0 +1,55 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _LOCALSOCKET_H_
+#define _LOCALSOCKET_H_
+
+// Boost:
+#include <boost/asio.hpp>
+
+// STL:
+#include <string>
+
+namespace malmo
+{
+    //! A stream socket that can be connected over TCP or, where supported, through a UNIX-domain socket.
+    typedef boost::asio::generic::stream_protocol::socket StreamSocket;
+
+    //! Returns true if UNIX-domain sockets can be used on this platform.
+    bool IsLocalSocketSupported();
+
+    //! Makes a prefix for socket names that no other process on this machine will be using.
+    //! On Linux the sockets are in the abstract namespace (names starting with '@'), elsewhere they are files in the temp directory.
+    std::string MakeLocalSocketPrefix();
+
+    //! Gets the name of the UNIX-domain socket that stands in for a TCP port.
+    //! \param prefix The prefix shared by all the sockets of one process, e.g. from MakeLocalSocketPrefix().
+    //! \param port The TCP port.
+    std::string GetLocalSocketName(const std::string& prefix, int port);
+
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+    //! Gets the endpoint of a UNIX-domain socket. A name starting with '@' is in the abstract namespace (Linux only), anything else is a path.
+    boost::asio::local::stream_protocol::endpoint MakeLocalEndpoint(const std::string& name);
+#endif
+
+    //! Describes an endpoint for logging - the IP address for TCP, the name for a UNIX-domain socket.
+    std::string DescribeEndpoint(const boost::asio::generic::stream_protocol::endpoint& endpoint);
+}
+
+#endif
@@ -202,17 +202,38 @@ template<typename T> long getPosixTimeAsLong(T* obj)
     return dur.total_milliseconds();
 }
 
+// Frame stacks hold a timestamp per slot:
+long getFrameStackTimestampAsLong(const FrameStack* stack, int slot)
+{
+    boost::posix_time::time_duration dur = stack->getTimestamp(slot) - boost::posix_time::ptime(boost::gregorian::date(1970, 1, 1));
+    return dur.total_milliseconds();
+}
+
 void (AgentHost::*startMissionSimple)(const MissionSpec&, const MissionRecordSpec&) = &AgentHost::startMission;
 void (AgentHost::*startMissionComplex)(const MissionSpec&, const ClientPool&, const MissionRecordSpec&, int, std::string) = &AgentHost::startMission;
 
 void (AgentHost::*sendCommand)(std::string) = &AgentHost::sendCommand;
 void (AgentHost::*sendCommandWithKey)(std::string, std::string) = &AgentHost::sendCommand;
 
+// A Lua wrapper around AgentHost::sendCommands(), taking a table of commands indexed from 1.
+void sendCommandTable( AgentHost* agent_host, const luabind::object& commands )
+{
+    std::vector< std::string > strings;
+    for( int i = 1; luabind::type( commands[i] ) != LUA_TNIL; ++i )
+        strings.push_back( luabind::object_cast< std::string >( commands[i] ) );
+    agent_host->sendCommands( strings );
+}
+
 #ifdef WRAP_ALE
   void (ALEAgentHost::*startALEMissionSimple)(const MissionSpec&, const MissionRecordSpec&) = &ALEAgentHost::startMission;
   void (ALEAgentHost::*startALEMissionComplex)(const MissionSpec&, const ClientPool&, const MissionRecordSpec&, int, std::string) = &ALEAgentHost::startMission;
 #endif
 
+void (FramePreprocessor::*resizeWithArea)(short, short) = &FramePreprocessor::resize;
+void (FramePreprocessor::*resizeWithFilter)(short, short, FramePreprocessor::ResizeFilter) = &FramePreprocessor::resize;
+void (FramePreprocessor::*convertToUnitFloat)() = &FramePreprocessor::convertToFloat;
+void (FramePreprocessor::*convertToScaledFloat)(float, float) = &FramePreprocessor::convertToFloat;
+
 void recordMP4(MissionRecordSpec* mrs, int frames_per_second, long bitrate)
 {
     mrs->recordMP4(frames_per_second,static_cast<int64_t>(bitrate));
@@ -300,14 +321,20 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
             .def("getStringArgument", &ArgumentParser::getStringArgument)
         ,
         class_< WorldState >( "WorldState" )
+            .def(constructor<>())
             .def_readonly( "is_mission_running",                      &WorldState::is_mission_running )
             .def_readonly( "has_mission_begun",                       &WorldState::has_mission_begun )
             .def_readonly( "number_of_observations_since_last_state", &WorldState::number_of_observations_since_last_state )
             .def_readonly( "number_of_rewards_since_last_state",      &WorldState::number_of_rewards_since_last_state )
             .def_readonly( "number_of_video_frames_since_last_state", &WorldState::number_of_video_frames_since_last_state )
+            .def_readonly( "number_of_video_frames_dropped_since_last_state", &WorldState::number_of_video_frames_dropped_since_last_state )
+            .def_readonly( "number_of_rewards_dropped_since_last_state",      &WorldState::number_of_rewards_dropped_since_last_state )
+            .def_readonly( "number_of_observations_dropped_since_last_state", &WorldState::number_of_observations_dropped_since_last_state )
             .def_readonly( "observations",                            &WorldState::observations,               return_stl_iterator )
             .def_readonly( "rewards",                                 &WorldState::rewards,                    return_stl_iterator )
             .def_readonly( "video_frames",                            &WorldState::video_frames,               return_stl_iterator )
+            .def_readonly( "number_of_incomplete_video_bundles_since_last_state", &WorldState::number_of_incomplete_video_bundles_since_last_state )
+            .def_readonly( "video_bundles",                           &WorldState::video_bundles,              return_stl_iterator )
             .def_readonly( "mission_control_messages",                &WorldState::mission_control_messages,   return_stl_iterator )
             .def_readonly( "errors",                                  &WorldState::errors,                     return_stl_iterator )
             .def(tostring(const_self))
@@ -329,17 +356,40 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
                   value( "LATEST_OBSERVATION_ONLY",  AgentHost::LATEST_OBSERVATION_ONLY )
                 , value( "KEEP_ALL_OBSERVATIONS",    AgentHost::KEEP_ALL_OBSERVATIONS )
             ]
+            .enum_( "OverflowPolicy" )
+            [
+                  value( "DROP_OLDEST",  AgentHost::DROP_OLDEST )
+                , value( "DROP_NEWEST",  AgentHost::DROP_NEWEST )
+            ]
             .def(constructor<>())
             .def("startMission",                    startMissionSimple)
             .def("startMission",                    startMissionComplex)
             .def("killClient",                      &AgentHost::killClient)
             .def("peekWorldState",                  &AgentHost::peekWorldState)
             .def("getWorldState",                   &AgentHost::getWorldState)
+            .def("waitForWorldState",               &AgentHost::waitForWorldState)
+            .def("swapWorldState",                  &AgentHost::swapWorldState)
+            .def("step",                            &AgentHost::step)
+            .def("getCommandToObservationLatencies", &AgentHost::getCommandToObservationLatencies)
+            .def("getCommandToFrameLatencies",      &AgentHost::getCommandToFrameLatencies)
+            .def("resetLatencies",                  &AgentHost::resetLatencies)
+            .def("setNumberOfIoThreads",            &AgentHost::setNumberOfIoThreads)
+            .def("setClientTimeouts",               &AgentHost::setClientTimeouts)
             .def("setVideoPolicy",                  &AgentHost::setVideoPolicy)
             .def("setRewardsPolicy",                &AgentHost::setRewardsPolicy)
             .def("setObservationsPolicy",           &AgentHost::setObservationsPolicy)
+            .def("setVideoFramesLimit",             &AgentHost::setVideoFramesLimit)
+            .def("setRewardsLimit",                 &AgentHost::setRewardsLimit)
+            .def("setObservationsLimit",            &AgentHost::setObservationsLimit)
+            .def("setVideoPreprocessor",            &AgentHost::setVideoPreprocessor)
+            .def("setVideoAlignment",               &AgentHost::setVideoAlignment)
+            .def("setSharedMemoryVideo",            &AgentHost::setSharedMemoryVideo)
+            .def("setLocalSockets",                 &AgentHost::setLocalSockets)
+            .def("setFrameStackDepth",              &AgentHost::setFrameStackDepth)
+            .def("getFrameStack",                   &AgentHost::getFrameStack)
             .def("sendCommand",                     sendCommand)
             .def("sendCommand",                     sendCommandWithKey)
+            .def("sendCommands",                    &sendCommandTable)
             .def("getRecordingTemporaryDirectory",  &AgentHost::getRecordingTemporaryDirectory)
             .def("setDebugOutput",                  &AgentHost::setDebugOutput)
 
@@ -439,6 +489,46 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
             .def("setDestination",          &MissionRecordSpec::setDestination)
             .def(tostring(const_self))
         ,
+        class_< FramePreprocessor >("FramePreprocessor")
+            .enum_("ResizeFilter")
+                [
+                    value("AREA", FramePreprocessor::AREA),
+                    value("BILINEAR", FramePreprocessor::BILINEAR)
+                ]
+            .def(constructor<>())
+            .def("crop",                    &FramePreprocessor::crop)
+            .def("resize",                  resizeWithArea)
+            .def("resize",                  resizeWithFilter)
+            .def("convertToGrayscale",      &FramePreprocessor::convertToGrayscale)
+            .def("reorderToChannelsFirst",  &FramePreprocessor::reorderToChannelsFirst)
+            .def("convertToFloat",          convertToUnitFloat)
+            .def("convertToFloat",          convertToScaledFloat)
+        ,
+        class_< WorldStateCondition >("WorldStateCondition")
+            .enum_("Combination")
+                [
+                    value("ANY", WorldStateCondition::ANY),
+                    value("ALL", WorldStateCondition::ALL)
+                ]
+            .def(constructor<>())
+            .def(constructor< WorldStateCondition::Combination >())
+            .def("requireObservations",         &WorldStateCondition::requireObservations)
+            .def("requireRewards",              &WorldStateCondition::requireRewards)
+            .def("requireVideoFrames",          &WorldStateCondition::requireVideoFrames)
+            .def("requireVideoFramesOfType",    &WorldStateCondition::requireVideoFramesOfType)
+            .def("requireMissionBegun",         &WorldStateCondition::requireMissionBegun)
+            .def("requireMissionEnded",         &WorldStateCondition::requireMissionEnded)
+        ,
+        class_< LatencyHistogram >("LatencyHistogram")
+            .def(constructor<>())
+            .def("reset",                   &LatencyHistogram::reset)
+            .def("getCount",                &LatencyHistogram::getCount)
+            .def("getMeanMs",               &LatencyHistogram::getMeanMs)
+            .def("getMinMs",                &LatencyHistogram::getMinMs)
+            .def("getMaxMs",                &LatencyHistogram::getMaxMs)
+            .def("getPercentileMs",         &LatencyHistogram::getPercentileMs)
+            .def(tostring(const_self))
+        ,
         class_< ClientInfo >("ClientInfo")
             .def(constructor<>())
             .def(constructor<const std::string &>())
@@ -449,9 +539,26 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
             .def_readonly("command_port",           &ClientInfo::command_port)
             .def(tostring(const_self))
         ,
+        class_< ClientRecord >("ClientRecord")
+            .def(constructor<>())
+            .def_readonly("connects",               &ClientRecord::connects)
+            .def_readonly("connect_ms",             &ClientRecord::connect_ms)
+            .def_readonly("replies",                &ClientRecord::replies)
+            .def_readonly("reply_ms",               &ClientRecord::reply_ms)
+            .def_readonly("recent_busy",            &ClientRecord::recent_busy)
+            .def_readonly("recent_failures",        &ClientRecord::recent_failures)
+            .def_readonly("missions_completed",     &ClientRecord::missions_completed)
+            .def_readonly("mission_seconds",        &ClientRecord::mission_seconds)
+            .def("getExpectedDelayMs",      &ClientRecord::getExpectedDelayMs)
+            .def("getMissionsPerHour",      &ClientRecord::getMissionsPerHour)
+            .def(tostring(const_self))
+        ,
         class_< ClientPool >("ClientPool")
             .def(constructor<>())
             .def("add",                     &ClientPool::add)
+            .def("getClientRecord",         &ClientPool::getClientRecord)
+            .def("startHealthProbes",       &ClientPool::startHealthProbes)
+            .def("stopHealthProbes",        &ClientPool::stopHealthProbes)
             .def(tostring(const_self))
         ,
         class_<ParameterSet>("ParameterSet")
@@ -479,6 +586,45 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
             .def("getValue",              &TimestampedReward::getValue)
             .def(tostring(const_self))
         ,
+        class_< FrameView >("FrameView")
+            .property("width",            &FrameView::getWidth)
+            .property("height",           &FrameView::getHeight)
+            .property("channels",         &FrameView::getChannels)
+            .property("row_stride",       &FrameView::getRowStride)
+            .property("pixel_stride",     &FrameView::getPixelStride)
+            .def("isPacked",              &FrameView::isPacked)
+            .def("getValue",              &FrameView::getValue)
+            .def("crop",                  &FrameView::crop)
+            .def("subsample",             &FrameView::subsample)
+        ,
+        class_< FrameBundle, boost::shared_ptr< FrameBundle > >("FrameBundle")
+            .def("timestamp",             &getPosixTimeAsLong<FrameBundle>)
+            .def_readonly("xPos",         &FrameBundle::xPos)
+            .def_readonly("yPos",         &FrameBundle::yPos)
+            .def_readonly("zPos",         &FrameBundle::zPos)
+            .def_readonly("yaw",          &FrameBundle::yaw)
+            .def_readonly("pitch",        &FrameBundle::pitch)
+            .def_readonly("is_complete",  &FrameBundle::is_complete)
+            .def("hasFrame",              &FrameBundle::hasFrame)
+            .def("getFrame",              &FrameBundle::getFrame)
+            .def("getNumberOfFrames",     &FrameBundle::getNumberOfFrames)
+            .def(tostring(const_self))
+        ,
+        class_< FrameStack >("FrameStack")
+            .def(constructor<>())
+            .def(constructor<int>())
+            .property("depth",            &FrameStack::getDepth)
+            .property("count",            &FrameStack::getCount)
+            .property("width",            &FrameStack::getWidth)
+            .property("height",           &FrameStack::getHeight)
+            .property("channels",         &FrameStack::getChannels)
+            .property("frame_size",       &FrameStack::getFrameSize)
+            .property("data",             &FrameStack::getData,             return_stl_iterator )
+            .def("isFloat",               &FrameStack::isFloat)
+            .def("getSlot",               &FrameStack::getSlot)
+            .def("getNewestSlot",         &FrameStack::getNewestSlot)
+            .def("getTimestamp",          &getFrameStackTimestampAsLong)
+        ,
         class_< TimestampedVideoFrame, boost::shared_ptr< TimestampedVideoFrame > >("TimestampedVideoFrame")
             .enum_("FrameType")
                 [
@@ -497,7 +643,10 @@ MODULE_EXPORT int luaopen_libMalmoLua(lua_State* L)
             .def_readonly("yaw",          &TimestampedVideoFrame::yaw)
             .def_readonly("pitch",        &TimestampedVideoFrame::pitch)
             .def_readonly("frametype",    &TimestampedVideoFrame::frametype)
-            .def_readonly("pixels",       &TimestampedVideoFrame::pixels,               return_stl_iterator )
+            .def_readonly("channels_first", &TimestampedVideoFrame::channels_first)
+            .def_readonly("float_pixels", &TimestampedVideoFrame::float_pixels)
+            .property("pixels",           &TimestampedVideoFrame::getPixels,             return_stl_iterator )
+            .property("view",             &TimestampedVideoFrame::getView)
             .def(tostring(const_self))
       #ifdef TORCH
         ,
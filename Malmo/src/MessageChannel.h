@@ -0,0 +1,352 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _MESSAGECHANNEL_H_
+#define _MESSAGECHANNEL_H_
+
+// STL:
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace malmo
+{
+    //! A fixed number of preallocated slots that any number of threads can push into and pop from, in order, without locking.
+    //! Each slot carries a sequence stamp saying which lap of the ring it is ready for, so a push just claims a position and
+    //! copies its message into the slot, and a pop just claims the oldest position and moves the message out.
+    template< typename T >
+    class MessageRing
+    {
+        public:
+
+            enum PopResult { POPPED, EMPTY, BEING_WRITTEN };
+
+            explicit MessageRing(std::size_t capacity)
+                : capacity(capacity)
+                , slots(new Slot[capacity])
+                , push_position(0)
+                , pop_position(0)
+            {
+                for (std::size_t i = 0; i < capacity; i++)
+                    this->slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            std::size_t getCapacity() const
+            {
+                return this->capacity;
+            }
+
+            //! Adds a message, unless the ring is full.
+            bool tryPush(const T& message)
+            {
+                std::size_t position = this->push_position.load(std::memory_order_relaxed);
+                for (;;) {
+                    Slot& slot = this->slots[position % this->capacity];
+                    const std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - position);
+                    if (lap == 0) {
+                        if (this->push_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            slot.message = message;
+                            slot.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (lap < 0)
+                        return false;   // (the slot still holds the message from the last lap)
+                    else
+                        position = this->push_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            //! Takes the oldest message, if it is at a position before end.
+            //! \returns EMPTY if there is none, or BEING_WRITTEN if the oldest position has been claimed by a push that hasn't finished.
+            PopResult tryPop(T& message, std::size_t end = std::numeric_limits<std::size_t>::max())
+            {
+                std::size_t position = this->pop_position.load(std::memory_order_relaxed);
+                for (;;) {
+                    if (position >= end)
+                        return EMPTY;
+                    Slot& slot = this->slots[position % this->capacity];
+                    const std::ptrdiff_t lap = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - (position + 1));
+                    if (lap == 0) {
+                        if (this->pop_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            message = std::move(slot.message);
+                            slot.message = T();
+                            slot.sequence.store(position + this->capacity, std::memory_order_release);
+                            return POPPED;
+                        }
+                    }
+                    else if (lap < 0)
+                        return position < this->push_position.load(std::memory_order_relaxed) ? BEING_WRITTEN : EMPTY;
+                    else
+                        position = this->pop_position.load(std::memory_order_relaxed);
+                }
+            }
+
+            //! Gets the position the next push will claim: every message pushed before this was called is at an earlier position.
+            std::size_t getPushPosition() const
+            {
+                return this->push_position.load(std::memory_order_acquire);
+            }
+
+        private:
+
+            struct Slot
+            {
+                std::atomic< std::size_t > sequence;
+                T message;
+            };
+
+            MessageRing(const MessageRing&);
+            MessageRing& operator=(const MessageRing&);
+
+            const std::size_t capacity;
+            std::unique_ptr< Slot[] > slots;
+            std::atomic< std::size_t > push_position;
+            std::atomic< std::size_t > pop_position;
+    };
+
+    //! Carries messages of one kind (frames, rewards, ...) from any number of producer threads to a single consumer, without locking.
+    //! A push never waits for the consumer: an unbounded push links a node into the queue with one atomic exchange, and the nodes
+    //! are recycled through a preallocated ring of spares, so once the channel has warmed up pushing doesn't touch the heap.
+    //! Messages pushed with keep_all set are queued in order; others replace whichever such message hasn't been taken yet.
+    //! The queue can be bounded, in which case the queued messages wait in a MessageRing preallocated to the limit, and a push that finds
+    //! it full either drops its message or drops the oldest waiting to make room.
+    //! Only one thread at a time may call take() or setLimit().
+    template< typename T >
+    class MessageChannel
+    {
+        public:
+
+            MessageChannel()
+                : latest(0)
+                , count(0)
+                , spare_nodes(MAX_SPARE_NODES)
+                , bounded(0)
+                , bounded_epoch(0)
+                , dropped(0)
+            {
+                this->bounded_users[0].store(0, std::memory_order_relaxed);
+                this->bounded_users[1].store(0, std::memory_order_relaxed);
+                Node* stub = new Node();
+                this->head = stub;
+                this->tail = stub;
+            }
+
+            ~MessageChannel()
+            {
+                std::vector< T > discarded;
+                take(discarded);
+                delete this->tail;
+                delete this->bounded.load(std::memory_order_relaxed);
+                Node* spare = 0;
+                while (this->spare_nodes.tryPop(spare) == MessageRing< Node* >::POPPED)
+                    delete spare;
+            }
+
+            //! Limits the number of queued messages that may be waiting to be taken. Producers may carry on pushing meanwhile; this
+            //! waits for any push still using the old limit to finish with it. Messages already queued are discarded.
+            //! Only the thread that calls take() may call this.
+            //! \param limit The most messages that may be waiting, or 0 for no limit.
+            //! \param drop_oldest What to do with a message pushed when the queue is full: if true, the oldest message waiting is dropped
+            //! to make room for it (unless that message is still being pushed, in which case the new one is dropped instead); if false,
+            //! the new message is dropped.
+            void setLimit(std::size_t limit, bool drop_oldest)
+            {
+                std::vector< T > discarded;
+                take(discarded);
+                BoundedQueue* replaced = this->bounded.exchange(limit > 0 ? new BoundedQueue(limit, drop_oldest) : 0, std::memory_order_seq_cst);
+                // Pushes from now on count themselves under the other epoch, so only those that might still be using the replaced
+                // queue are left under this one.
+                const std::size_t epoch = this->bounded_epoch.fetch_add(1, std::memory_order_seq_cst);
+                while (this->bounded_users[epoch % 2].load(std::memory_order_seq_cst) != 0)
+                    std::this_thread::yield();
+                delete replaced;
+                this->dropped = 0;
+            }
+
+            //! Adds a message. Can be called from any thread.
+            //! \param message The message.
+            //! \param keep_all If true, the message is queued behind any others. If false, it replaces the latest message that wasn't queued.
+            void push(const T& message, bool keep_all)
+            {
+                if (keep_all) {
+                    if (!pushBounded(message)) {
+                        Node* node = newNode(message);
+                        Node* previous = this->head.exchange(node, std::memory_order_acq_rel);
+                        previous->next.store(node, std::memory_order_release);   // (until this happens, the consumer sees the queue end at previous)
+                    }
+                }
+                else {
+                    Node* replaced = this->latest.exchange(newNode(message), std::memory_order_acq_rel);
+                    if (replaced)
+                        recycle(replaced);
+                }
+                this->count.fetch_add(1, std::memory_order_release);
+            }
+
+            //! Moves the messages out of the channel, oldest first, followed by the latest unqueued message if there is one.
+            //! Only one thread at a time may call this.
+            //! \param messages The messages are appended to this.
+            //! \returns The number of messages pushed since the last call, including any that were replaced. (A message pushed during
+            //! the call may be taken now but only counted next time - never the other way round.)
+            std::size_t take(std::vector< T >& messages)
+            {
+                const std::size_t pushed = this->count.exchange(0, std::memory_order_acq_rel);
+                // Everything counted so far has been linked in up to here, or is about to be: a producer links its node straight after claiming it.
+                Node* const last_counted = this->head.load(std::memory_order_acquire);
+                // The node at the tail has already been taken; each taken node becomes the new tail.
+                while (this->tail != last_counted) {
+                    Node* next = this->tail->next.load(std::memory_order_acquire);
+                    if (!next) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    messages.push_back(std::move(next->message));
+                    next->message = T();
+                    recycle(this->tail);
+                    this->tail = next;
+                }
+                // (Only setLimit replaces this, on our thread.)
+                BoundedQueue* const queue = this->bounded.load(std::memory_order_relaxed);
+                if (queue) {
+                    // Take up to the last position claimed so far, waiting for any push still writing before it, so that a producer's
+                    // messages can't overtake each other from one take to the next. (Later positions wait for the next take.)
+                    const std::size_t end = queue->ring.getPushPosition();
+                    T message;
+                    for (;;) {
+                        const typename MessageRing< T >::PopResult result = queue->ring.tryPop(message, end);
+                        if (result == MessageRing< T >::POPPED)
+                            messages.push_back(std::move(message));
+                        else if (result == MessageRing< T >::BEING_WRITTEN)
+                            std::this_thread::yield();
+                        else
+                            break;
+                    }
+                }
+                Node* last = this->latest.exchange(0, std::memory_order_acq_rel);
+                if (last) {
+                    messages.push_back(std::move(last->message));
+                    recycle(last);
+                }
+                return pushed;
+            }
+
+            //! Gets the number of messages dropped because the queue was full, since this was last called. Only the thread that calls take() may call this.
+            std::size_t takeDroppedCount()
+            {
+                return this->dropped.exchange(0, std::memory_order_relaxed);
+            }
+
+        private:
+
+            struct Node
+            {
+                Node() : next(0) {}
+                T message;
+                std::atomic< Node* > next;
+            };
+
+            // Enough for the messages of every kind that pile up between two takes at a normal rate; beyond that, nodes are allocated as needed.
+            static const std::size_t MAX_SPARE_NODES = 1024;
+
+            Node* newNode(const T& message)
+            {
+                Node* node = 0;
+                if (this->spare_nodes.tryPop(node) != MessageRing< Node* >::POPPED)
+                    node = new Node();
+                node->message = message;
+                node->next.store(0, std::memory_order_relaxed);
+                return node;
+            }
+
+            void recycle(Node* node)
+            {
+                node->message = T();
+                if (!this->spare_nodes.tryPush(node))
+                    delete node;
+            }
+
+            struct BoundedQueue
+            {
+                BoundedQueue(std::size_t limit, bool drop_oldest) : ring(limit), drop_oldest(drop_oldest) {}
+                MessageRing< T > ring;
+                const bool drop_oldest;
+            };
+
+            //! Pushes the message into the bounded queue, if there is one.
+            //! \returns False if the queue isn't bounded.
+            bool pushBounded(const T& message)
+            {
+                // (If setLimit bounds the queue after this, the message is just queued in a node, to be taken ahead of the bounded ones.)
+                if (!this->bounded.load(std::memory_order_relaxed))
+                    return false;
+                // Count ourselves as a user of the queue under the current epoch, so that setLimit can't delete it under us. (If the
+                // epoch moves on before we're counted, setLimit might not have waited for us, so count again under the new one.)
+                std::size_t epoch = this->bounded_epoch.load(std::memory_order_seq_cst);
+                for (;;) {
+                    this->bounded_users[epoch % 2].fetch_add(1, std::memory_order_seq_cst);
+                    const std::size_t now = this->bounded_epoch.load(std::memory_order_seq_cst);
+                    if (now == epoch)
+                        break;
+                    this->bounded_users[epoch % 2].fetch_sub(1, std::memory_order_release);
+                    epoch = now;
+                }
+                BoundedQueue* const queue = this->bounded.load(std::memory_order_seq_cst);
+                if (queue) {
+                    while (!queue->ring.tryPush(message)) {
+                        T oldest;
+                        const typename MessageRing< T >::PopResult result = queue->drop_oldest ? queue->ring.tryPop(oldest) : MessageRing< T >::BEING_WRITTEN;
+                        if (result == MessageRing< T >::POPPED) {
+                            this->dropped.fetch_add(1, std::memory_order_relaxed);
+                            continue;
+                        }
+                        if (result == MessageRing< T >::BEING_WRITTEN) {
+                            // (Rather than wait for another producer to finish writing the oldest.)
+                            this->dropped.fetch_add(1, std::memory_order_relaxed);
+                            break;
+                        }
+                        // (Emptied in the meantime, so there's room now.)
+                    }
+                }
+                this->bounded_users[epoch % 2].fetch_sub(1, std::memory_order_release);
+                return queue != 0;
+            }
+
+            MessageChannel(const MessageChannel&);
+            MessageChannel& operator=(const MessageChannel&);
+
+            std::atomic< Node* > head;      // the most recently pushed node - written by the producers
+            Node* tail;                     // the most recently taken node - only touched by the consumer
+            std::atomic< Node* > latest;
+            std::atomic< std::size_t > count;
+            MessageRing< Node* > spare_nodes;
+
+            // Bounding the queue:
+            std::atomic< BoundedQueue* > bounded;           // holds the queued messages instead of the nodes, when there is a limit
+            std::atomic< std::size_t > bounded_epoch;       // moved on by each setLimit
+            std::atomic< std::size_t > bounded_users[2];    // pushes that may be using the bounded queue, by the parity of the epoch they saw
+            std::atomic< std::size_t > dropped;
+    };
+}
+
+#endif
@@ -74,17 +74,8 @@ namespace malmo
 
     MissionInitSpec::MissionInitSpec(const std::string& xml, bool validate)
     {
-        initialiser::initXSD();
-
-        xml_schema::properties props;
-        props.schema_location(xml_namespace, FindSchemaFile("MissionInit.xsd"));
-
-        xml_schema::flags flags = xml_schema::flags::dont_initialize;
-        if( !validate )
-            flags = flags | xml_schema::flags::dont_validate;
-
-        istringstream iss(xml);
-        this->mission_init = MissionInit_(iss, flags, props);
+        DOMDocumentPtr doc = ParseXML(xml, validate);
+        this->mission_init = MissionInit_(*doc, xml_schema::flags::dont_initialize);
     }
 
     std::string MissionInitSpec::getAsXML( bool prettyPrint ) const
@@ -199,6 +190,40 @@ namespace malmo
         this->mission_init->ClientAgentConnection().AgentColourMapPort() = port;
     }
 
+    std::string MissionInitSpec::getAgentSharedMemoryPrefix() const
+    {
+        const auto& prefix = this->mission_init->ClientAgentConnection().AgentSharedMemoryPrefix();
+        return prefix.present() ? std::string(prefix.get()) : std::string();
+    }
+
+    void MissionInitSpec::setAgentSharedMemoryPrefix(const std::string& prefix)
+    {
+        if (prefix.empty())
+            this->mission_init->ClientAgentConnection().AgentSharedMemoryPrefix().reset();
+        else
+            this->mission_init->ClientAgentConnection().AgentSharedMemoryPrefix() = prefix;
+    }
+
+    std::string MissionInitSpec::getAgentLocalSocketPrefix() const
+    {
+        const auto& prefix = this->mission_init->ClientAgentConnection().AgentLocalSocketPrefix();
+        return prefix.present() ? std::string(prefix.get()) : std::string();
+    }
+
+    void MissionInitSpec::setAgentLocalSocketPrefix(const std::string& prefix)
+    {
+        if (prefix.empty())
+            this->mission_init->ClientAgentConnection().AgentLocalSocketPrefix().reset();
+        else
+            this->mission_init->ClientAgentConnection().AgentLocalSocketPrefix() = prefix;
+    }
+
+    std::string MissionInitSpec::getClientCommandsLocalSocket() const
+    {
+        const auto& name = this->mission_init->ClientAgentConnection().ClientCommandsLocalSocket();
+        return name.present() ? std::string(name.get()) : std::string();
+    }
+
     int MissionInitSpec::getAgentObservationsPort() const
     {
         return this->mission_init->ClientAgentConnection().AgentObservationsPort();
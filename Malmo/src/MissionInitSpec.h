@@ -137,6 +137,28 @@ namespace malmo
             //! \param port The port that the agent listens to colourmap video frames on.
             void setAgentColourMapPort(int port);
 
+            //! Gets the prefix of the names of the shared-memory segments the agent will accept video frames through.
+            //! \returns The prefix, or an empty string if the agent only accepts video frames on its ports.
+            std::string getAgentSharedMemoryPrefix() const;
+
+            //! Sets the prefix of the names of the shared-memory segments the agent will accept video frames through.
+            //! Optional. The default behavior is to accept video frames only on the ports.
+            //! \param prefix The prefix, or an empty string to accept video frames only on the ports.
+            void setAgentSharedMemoryPrefix(const std::string& prefix);
+
+            //! Gets the prefix of the names of the UNIX-domain sockets the agent's ports can also be reached through.
+            //! \returns The prefix, or an empty string if the agent can only be reached over TCP.
+            std::string getAgentLocalSocketPrefix() const;
+
+            //! Sets the prefix of the names of the UNIX-domain sockets the agent's ports can also be reached through.
+            //! Optional. The default behavior is to be reachable only over TCP.
+            //! \param prefix The prefix, or an empty string to be reachable only over TCP.
+            void setAgentLocalSocketPrefix(const std::string& prefix);
+
+            //! Gets the name of the UNIX-domain socket the client's commands port can also be reached through.
+            //! \returns The name of the socket, or an empty string if the client didn't provide one.
+            std::string getClientCommandsLocalSocket() const;
+
             //! Gets the observations port of the agent.
             //! \returns The port that the agent listens to observations on.
             int getAgentObservationsPort() const;
@@ -0,0 +1,114 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "MissionInitTemplate.h"
+
+// STL:
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace malmo
+{
+    static std::string escapeXML(const std::string& text)
+    {
+        std::string escaped;
+        escaped.reserve(text.size());
+        for (char c : text)
+        {
+            switch (c)
+            {
+                case '&': escaped += "&amp;"; break;
+                case '<': escaped += "&lt;"; break;
+                case '>': escaped += "&gt;"; break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+
+    MissionInitTemplate::MissionInitTemplate(const MissionInitSpec& mission_init)
+    {
+        const bool prettyPrint = false;
+        this->xml = mission_init.getAsXML(prettyPrint);
+
+        try {
+            const bool validate = true;
+            MissionInitSpec test_output(this->xml, validate);
+        }
+        catch (xml_schema::exception& e)
+        {
+            std::ostringstream oss;
+            oss << "Internal error: the XML we generate does not validate: " << e.what() << "\n" << e << "\n" << this->xml << std::endl;
+            throw std::runtime_error(oss.str());
+        }
+
+        // The element names can't occur anywhere else in the XML: markup from the mission has its own element names, and text has its '<'s escaped.
+        findSplice(ClientAddress, "ClientIPAddress", false);
+        findSplice(ClientMissionControlPort, "ClientMissionControlPort", false);
+        findSplice(ClientCommandsPort, "ClientCommandsPort", false);
+        if (!mission_init.getAgentSharedMemoryPrefix().empty())
+            findSplice(SharedMemoryPrefix, "AgentSharedMemoryPrefix", true);
+        if (!mission_init.getAgentLocalSocketPrefix().empty())
+            findSplice(LocalSocketPrefix, "AgentLocalSocketPrefix", true);
+        std::sort(this->splices.begin(), this->splices.end(), [](const Splice& a, const Splice& b) { return a.begin < b.begin; });
+    }
+
+    void MissionInitTemplate::findSplice(Field field, const std::string& element, bool whole_element)
+    {
+        const std::string start_tag = "<" + element + ">";
+        const std::string end_tag = "</" + element + ">";
+        const size_t start = this->xml.find(start_tag);
+        const size_t end = start == std::string::npos ? std::string::npos : this->xml.find(end_tag, start);
+        if (end == std::string::npos)
+            throw std::runtime_error("Internal error: the XML we generate has no " + element + " element:\n" + this->xml);
+
+        Splice splice;
+        splice.field = field;
+        splice.begin = whole_element ? start : start + start_tag.size();
+        splice.end = whole_element ? end + end_tag.size() : end;
+        this->splices.push_back(splice);
+    }
+
+    std::string MissionInitTemplate::getXML(const std::string& client_address, int client_mission_control_port, int client_commands_port, bool offer_prefixes) const
+    {
+        std::string result;
+        result.reserve(this->xml.size() + client_address.size());
+        size_t copied = 0;
+        for (const Splice& splice : this->splices)
+        {
+            result.append(this->xml, copied, splice.begin - copied);
+            switch (splice.field)
+            {
+                case ClientAddress: result += escapeXML(client_address); break;
+                case ClientMissionControlPort: result += std::to_string(client_mission_control_port); break;
+                case ClientCommandsPort: result += std::to_string(client_commands_port); break;
+                case SharedMemoryPrefix:
+                case LocalSocketPrefix:
+                    if (offer_prefixes)
+                        result.append(this->xml, splice.begin, splice.end - splice.begin);
+                    break;
+            }
+            copied = splice.end;
+        }
+        result.append(this->xml, copied, std::string::npos);
+        return result;
+    }
+}
@@ -0,0 +1,73 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _MISSIONINITTEMPLATE_H_
+#define _MISSIONINITTEMPLATE_H_
+
+// Local:
+#include "MissionInitSpec.h"
+
+// STL:
+#include <string>
+#include <vector>
+
+namespace malmo
+{
+    //! The XML of a mission init, serialised and validated once, that can then be offered to one client after another
+    //! by splicing in the fields that differ between clients: the client's address and ports, and whether the agent's
+    //! shared-memory and local-socket prefixes are offered to it.
+    class MissionInitTemplate
+    {
+        public:
+
+            //! Serialises the mission init and checks that the XML validates.
+            //! The prefixes it has are the ones that will be offered to clients on the same machine.
+            //! Throws std::runtime_error if the XML doesn't validate.
+            //! \param mission_init The mission init to offer, with any client's fields.
+            explicit MissionInitTemplate(const MissionInitSpec& mission_init);
+
+            //! Gets the XML of the mission init for one client. Since the fields spliced in are plain strings and ints, and the
+            //! prefixes are optional, the result is as valid as the XML that was checked.
+            //! \param client_address The IP address of the client.
+            //! \param client_mission_control_port The port the client listens to mission control messages on.
+            //! \param client_commands_port The port the client listens to commands on.
+            //! \param offer_prefixes If false, the shared-memory and local-socket prefixes are left out.
+            //! \returns The XML, as MissionInitSpec::getAsXML(false) would give it with those fields set.
+            std::string getXML(const std::string& client_address, int client_mission_control_port, int client_commands_port, bool offer_prefixes) const;
+
+        private:
+
+            enum Field { ClientAddress, ClientMissionControlPort, ClientCommandsPort, SharedMemoryPrefix, LocalSocketPrefix };
+
+            // A range of the XML that differs between clients: the content of an element, or a whole optional element.
+            struct Splice
+            {
+                Field field;
+                size_t begin;
+                size_t end;
+            };
+
+            void findSplice(Field field, const std::string& element, bool whole_element);
+
+            std::string xml;
+            std::vector<Splice> splices;    // (in order of position)
+    };
+}
+
+#endif
@@ -67,17 +67,8 @@ namespace malmo
 
     MissionSpec::MissionSpec(const std::string& xml, bool validate)
     {
-        initialiser::initXSD();
-
-        xml_schema::properties props;
-        props.schema_location(xml_namespace, FindSchemaFile("Mission.xsd"));
-        
-        xml_schema::flags flags = xml_schema::flags::dont_initialize;
-        if( !validate )
-            flags = flags | xml_schema::flags::dont_validate;
-
-        istringstream iss(xml);
-        this->mission = Mission_(iss, flags, props);
+        DOMDocumentPtr doc = ParseXML(xml, validate);
+        this->mission = Mission_(*doc, xml_schema::flags::dont_initialize);
     }
 
     std::string MissionSpec::getAsXML( bool prettyPrint ) const
@@ -0,0 +1,60 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "MissionStartFuture.h"
+
+// STL:
+#include <chrono>
+
+namespace malmo
+{
+    MissionStartFuture::MissionStartFuture()
+    {
+    }
+
+    MissionStartFuture::MissionStartFuture(std::shared_future< boost::shared_ptr<MissionInitSpec> > future)
+        : future(future)
+    {
+    }
+
+    bool MissionStartFuture::isValid() const
+    {
+        return this->future.valid();
+    }
+
+    bool MissionStartFuture::isReady() const
+    {
+        return waitFor(0);
+    }
+
+    bool MissionStartFuture::waitFor(int timeout_ms) const
+    {
+        if (!this->future.valid())
+            throw std::future_error(std::future_errc::no_state);
+        return this->future.wait_for(std::chrono::milliseconds(timeout_ms)) == std::future_status::ready;
+    }
+
+    boost::shared_ptr<MissionInitSpec> MissionStartFuture::get() const
+    {
+        if (!this->future.valid())
+            throw std::future_error(std::future_errc::no_state);
+        return this->future.get();
+    }
+}
@@ -0,0 +1,72 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _MISSIONSTARTFUTURE_H_
+#define _MISSIONSTARTFUTURE_H_
+
+// Local:
+#include "MissionInitSpec.h"
+
+// Boost:
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <future>
+
+namespace malmo
+{
+    //! The outcome of AgentHost::startMissionAsync, for when it is ready: the MissionInit that the mission was started with,
+    //! or the exception that startMission would have thrown. Copies share the same outcome, and can be waited on from any thread.
+    class MissionStartFuture
+    {
+        public:
+
+            //! Constructs a future that no mission start will ever complete. isValid() returns false.
+            MissionStartFuture();
+
+            //! Whether this future belongs to a call to startMissionAsync.
+            //! \returns True if a mission start will complete this future.
+            bool isValid() const;
+
+            //! Whether the mission start has finished, successfully or not. Doesn't wait.
+            //! \returns True if get() will return or throw straight away.
+            bool isReady() const;
+
+            //! Waits for the mission start to finish, successfully or not.
+            //! \param timeout_ms The longest to wait, in milliseconds.
+            //! \returns True if the mission start has finished, false if the time ran out first.
+            bool waitFor(int timeout_ms) const;
+
+            //! Waits for the mission start to finish and gets its outcome.
+            //! Throws whatever startMission threw - usually a MissionException - if the mission could not be started,
+            //! or std::future_error if this future is not valid or the agent host was destroyed before the start was attempted.
+            //! \returns The MissionInit that the mission was started with.
+            boost::shared_ptr<MissionInitSpec> get() const;
+
+        private:
+
+            friend class AgentHost;
+
+            explicit MissionStartFuture(std::shared_future< boost::shared_ptr<MissionInitSpec> > future);
+
+            std::shared_future< boost::shared_ptr<MissionInitSpec> > future;
+    };
+}
+
+#endif
@@ -33,6 +33,7 @@
 #include <ClientPool.h>
 #include <MissionSpec.h>
 #include <ParameterSet.h>
+#include <VectorAgentHost.h>
 using namespace malmo;
 
 // STL:
@@ -88,15 +89,213 @@ void translateMissionException(MissionException const& e)
     PyErr_SetString(missionExceptionType, e.what());
 }
 
+// Lets other Python threads run while we block in C++.
+class ScopedGILRelease
+{
+    public:
+        ScopedGILRelease() : thread_state( PyEval_SaveThread() ) {}
+        ~ScopedGILRelease() { PyEval_RestoreThread( this->thread_state ); }
+    private:
+        PyThreadState* thread_state;
+};
+
+// A Python wrapper around AgentHost::waitForWorldState(), which doesn't hold the GIL while waiting.
+WorldState waitForWorldState( AgentHost& agent_host, int timeout_ms, const WorldStateCondition& condition )
+{
+    ScopedGILRelease release;
+    return agent_host.waitForWorldState( timeout_ms, condition );
+}
+
+// A Python wrapper around AgentHost::step(), which doesn't hold the GIL while waiting.
+WorldState step( AgentHost& agent_host, const std::string& command, const WorldStateCondition& condition, int timeout_ms )
+{
+    ScopedGILRelease release;
+    return agent_host.step( command, condition, timeout_ms );
+}
+
+// Python wrappers around MissionStartFuture, which don't hold the GIL while waiting. MissionInitSpec isn't exposed, so get() gives its XML.
+bool waitForMissionStart( const MissionStartFuture& future, int timeout_ms )
+{
+    ScopedGILRelease release;
+    return future.waitFor( timeout_ms );
+}
+
+std::string getMissionStart( const MissionStartFuture& future )
+{
+    boost::shared_ptr< MissionInitSpec > mission_init;
+    {
+        ScopedGILRelease release;
+        mission_init = future.get();
+    }
+    return mission_init->getAsXML( false );
+}
+
+// Python wrappers around the VectorAgentHost steps, which take a list of commands and don't hold the GIL while waiting.
+BatchedWorldState stepAll( VectorAgentHost& vector_agent_host, const boost::python::list& commands, const WorldStateCondition& condition, int timeout_ms )
+{
+    const std::vector< std::string > command_strings = listToStrings( commands );
+    ScopedGILRelease release;
+    return vector_agent_host.step( command_strings, condition, timeout_ms );
+}
+
+void stepAllAsync( VectorAgentHost& vector_agent_host, const boost::python::list& commands, const WorldStateCondition& condition )
+{
+    const std::vector< std::string > command_strings = listToStrings( commands );
+    ScopedGILRelease release;
+    vector_agent_host.stepAsync( command_strings, condition );
+}
+
+// Returns a tuple of the environment (or -1) and its world state.
+boost::python::tuple waitForAnyStep( VectorAgentHost& vector_agent_host, int timeout_ms )
+{
+    WorldState world_state;
+    int index;
+    {
+        ScopedGILRelease release;
+        index = vector_agent_host.waitForAnyStep( timeout_ms, world_state );
+    }
+    return boost::python::make_tuple( index, world_state );
+}
+
+BatchedWorldState waitForSteps( VectorAgentHost& vector_agent_host, int timeout_ms )
+{
+    ScopedGILRelease release;
+    return vector_agent_host.waitForSteps( timeout_ms );
+}
+
+// WorldState has no ==, which the vector indexing suite needs, so the world states are handed over as a list.
+boost::python::list getBatchedWorldStates( const BatchedWorldState& batch )
+{
+    boost::python::list world_states;
+    for( const auto& world_state : batch.world_states )
+        world_states.append( world_state );
+    return world_states;
+}
+
+// The per-environment flags of a BatchedWorldState, as lists of bools.
+boost::python::list toList( const std::vector< bool >& flags )
+{
+    boost::python::list list;
+    for( bool flag : flags )
+        list.append( flag );
+    return list;
+}
+
+boost::python::list getStepsCompleted( const BatchedWorldState& batch )
+{
+    return toList( batch.steps_completed );
+}
+
+boost::python::list getFramesUpdated( const BatchedWorldState& batch )
+{
+    return toList( batch.frames_updated );
+}
+
+// Calls a Python callable from one of the callback threads, taking the GIL. Copies can be made without the GIL;
+// the callable itself is only released while holding it.
+template< typename Message >
+class PythonCallback
+{
+    public:
+        PythonCallback( const boost::python::object& callable ) : callable( new boost::python::object( callable ), releaseWithGIL ) {}
+
+        void operator()( Message message ) const
+        {
+            PyGILState_STATE gil_state = PyGILState_Ensure();
+            try {
+                ( *this->callable )( message );
+            }
+            catch( const boost::python::error_already_set& ) {
+                PyErr_Print();
+            }
+            PyGILState_Release( gil_state );
+        }
+
+    private:
+        static void releaseWithGIL( boost::python::object* callable )
+        {
+            PyGILState_STATE gil_state = PyGILState_Ensure();
+            delete callable;
+            PyGILState_Release( gil_state );
+        }
+
+        boost::shared_ptr< boost::python::object > callable;
+};
+
+// A Python wrapper around AgentHost::setCallbackThreads(). The old threads may be waiting for the GIL to run a callback, so let them have it.
+void setCallbackThreads( AgentHost& agent_host, int num_threads, int max_queued_callbacks )
+{
+    ScopedGILRelease release;
+    agent_host.setCallbackThreads( num_threads, max_queued_callbacks );
+}
+
+// Agent hosts wait for their callbacks to finish when they are destroyed, so they mustn't be destroyed holding the GIL.
+template< typename T >
+void deleteWithoutGIL( T* object )
+{
+    ScopedGILRelease release;
+    delete object;
+}
+
+boost::shared_ptr< AgentHost > createAgentHost()
+{
+    return boost::shared_ptr< AgentHost >( new AgentHost(), deleteWithoutGIL< AgentHost > );
+}
+
+boost::shared_ptr< VectorAgentHost > createVectorAgentHost( int num_environments, int num_io_threads, bool pin_to_cores )
+{
+    return boost::shared_ptr< VectorAgentHost >( new VectorAgentHost( num_environments, num_io_threads, pin_to_cores ), deleteWithoutGIL< VectorAgentHost > );
+}
+
+// Python wrappers around the AgentHost callback setters. Passing None stops the calls.
+template< typename Message >
+boost::function< void( Message ) > toCallback( const boost::python::object& callable )
+{
+    if( callable.is_none() )
+        return boost::function< void( Message ) >();
+    return PythonCallback< Message >( callable );
+}
+
+void setFrameCallback( AgentHost& agent_host, const boost::python::object& callable )
+{
+    agent_host.setFrameCallback( toCallback< boost::shared_ptr< TimestampedVideoFrame > >( callable ) );
+}
+
+void setObservationCallback( AgentHost& agent_host, const boost::python::object& callable )
+{
+    agent_host.setObservationCallback( toCallback< boost::shared_ptr< TimestampedString > >( callable ) );
+}
+
+void setRewardCallback( AgentHost& agent_host, const boost::python::object& callable )
+{
+    agent_host.setRewardCallback( toCallback< boost::shared_ptr< TimestampedReward > >( callable ) );
+}
+
+void setMissionEndedCallback( AgentHost& agent_host, const boost::python::object& callable )
+{
+    agent_host.setMissionEndedCallback( toCallback< boost::shared_ptr< TimestampedString > >( callable ) );
+}
+
 void (AgentHost::*startMissionSimple)(const MissionSpec&, const MissionRecordSpec&) = &AgentHost::startMission;
 void (AgentHost::*startMissionComplex)(const MissionSpec&, const ClientPool&, const MissionRecordSpec&, int, std::string) = &AgentHost::startMission;
 
 void (AgentHost::*sendCommand)(std::string) = &AgentHost::sendCommand;
 void (AgentHost::*sendCommandWithKey)(std::string, std::string) = &AgentHost::sendCommand;
 
+// A Python wrapper around AgentHost::sendCommands(), taking a list of commands.
+void sendCommandList( AgentHost& agent_host, const boost::python::list& commands )
+{
+    agent_host.sendCommands( listToStrings( commands ) );
+}
+
 void (MissionRecordSpec::*recordMP4General)(int, int64_t bit_rate) = &MissionRecordSpec::recordMP4;
 void (MissionRecordSpec::*recordMP4Specific)(TimestampedVideoFrame::FrameType, int, int64_t, bool) = &MissionRecordSpec::recordMP4;
 
+void (FramePreprocessor::*resizeWithArea)(short, short) = &FramePreprocessor::resize;
+void (FramePreprocessor::*resizeWithFilter)(short, short, FramePreprocessor::ResizeFilter) = &FramePreprocessor::resize;
+void (FramePreprocessor::*convertToUnitFloat)() = &FramePreprocessor::convertToFloat;
+void (FramePreprocessor::*convertToScaledFloat)(float, float) = &FramePreprocessor::convertToFloat;
+
 #ifdef WRAP_ALE
 void (ALEAgentHost::*startALEMissionSimple)(const MissionSpec&, const MissionRecordSpec&) = &ALEAgentHost::startMission;
 void (ALEAgentHost::*startALEMissionComplex)(const MissionSpec&, const ClientPool&, const MissionRecordSpec&, int, std::string) = &ALEAgentHost::startMission;
@@ -106,6 +305,10 @@ struct ptime_to_python_datetime
 {
     static PyObject* convert(boost::posix_time::ptime const& pt)
     {
+        // Unset times (e.g. an empty frame stack slot) become None:
+        if (pt.is_special())
+            Py_RETURN_NONE;
+
         // Convert posix_time into python DateTime object:
         boost::gregorian::date date = pt.date();
         boost::posix_time::time_duration td = pt.time_of_day();
@@ -130,6 +333,10 @@ struct unsigned_char_vec_to_python_array
 BOOST_PYTHON_MODULE(MalmoPython)
 {
     using namespace boost::python;
+#if PY_VERSION_HEX < 0x03070000
+    // Make sure the GIL exists: the callback threads take it, and until this is called Python 2 runs without one.
+    PyEval_InitThreads();
+#endif
     missionExceptionType = createExceptionClass("MissionException", PyExc_RuntimeError);
 
     // Bind the converter for posix_time to python DateTime
@@ -189,15 +396,20 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .def( "getFloatArgument",          &ArgumentParser::getFloatArgument )
         .def( "getStringArgument",         &ArgumentParser::getStringArgument )
     ;
-    class_< WorldState >( "WorldState", no_init )
+    class_< WorldState >( "WorldState", init<>() )
         .def_readonly( "is_mission_running",                      &WorldState::is_mission_running )
         .def_readonly( "has_mission_begun",                       &WorldState::has_mission_begun )
         .def_readonly( "number_of_observations_since_last_state", &WorldState::number_of_observations_since_last_state )
         .def_readonly( "number_of_rewards_since_last_state",      &WorldState::number_of_rewards_since_last_state )
         .def_readonly( "number_of_video_frames_since_last_state", &WorldState::number_of_video_frames_since_last_state )
+        .def_readonly( "number_of_video_frames_dropped_since_last_state", &WorldState::number_of_video_frames_dropped_since_last_state )
+        .def_readonly( "number_of_rewards_dropped_since_last_state",      &WorldState::number_of_rewards_dropped_since_last_state )
+        .def_readonly( "number_of_observations_dropped_since_last_state", &WorldState::number_of_observations_dropped_since_last_state )
         .def_readonly( "observations",                            &WorldState::observations )
         .def_readonly( "rewards",                                 &WorldState::rewards )
         .def_readonly( "video_frames",                            &WorldState::video_frames )
+        .def_readonly( "number_of_incomplete_video_bundles_since_last_state", &WorldState::number_of_incomplete_video_bundles_since_last_state )
+        .def_readonly( "video_bundles",                           &WorldState::video_bundles )
         .def_readonly( "mission_control_messages",                &WorldState::mission_control_messages )
         .def_readonly( "errors",                                  &WorldState::errors )
         .def(self_ns::str(self_ns::self))
@@ -215,22 +427,67 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .value( "LATEST_OBSERVATION_ONLY",  AgentHost::LATEST_OBSERVATION_ONLY )
         .value( "KEEP_ALL_OBSERVATIONS",    AgentHost::KEEP_ALL_OBSERVATIONS )
     ;
+    enum_< AgentHost::OverflowPolicy >( "OverflowPolicy" )
+        .value( "DROP_OLDEST",  AgentHost::DROP_OLDEST )
+        .value( "DROP_NEWEST",  AgentHost::DROP_NEWEST )
+    ;
 
-    class_< AgentHost, bases< ArgumentParser >, boost::noncopyable >("AgentHost", init<>())
+    class_< AgentHost, bases< ArgumentParser >, boost::shared_ptr< AgentHost >, boost::noncopyable >("AgentHost", no_init)
+        .def( "__init__",                       make_constructor( createAgentHost ) )
         .def( "startMission",                   startMissionSimple )
         .def( "startMission",                   startMissionComplex )
+        .def( "startMissionAsync",              &AgentHost::startMissionAsync )
         .def( "killClient",                     &AgentHost::killClient )
         .def( "peekWorldState",                 &AgentHost::peekWorldState )
         .def( "getWorldState",                  &AgentHost::getWorldState )
+        .def( "waitForWorldState",              waitForWorldState )
+        .def( "swapWorldState",                 &AgentHost::swapWorldState )
+        .def( "step",                           step )
+        .def( "getCommandToObservationLatencies", &AgentHost::getCommandToObservationLatencies )
+        .def( "getCommandToFrameLatencies",     &AgentHost::getCommandToFrameLatencies )
+        .def( "resetLatencies",                 &AgentHost::resetLatencies )
+        .def( "setCallbackThreads",             setCallbackThreads )
+        .def( "setFrameCallback",               setFrameCallback )
+        .def( "setObservationCallback",         setObservationCallback )
+        .def( "setRewardCallback",              setRewardCallback )
+        .def( "setMissionEndedCallback",        setMissionEndedCallback )
+        .def( "setNumberOfIoThreads",           &AgentHost::setNumberOfIoThreads )
+        .def( "setClientTimeouts",              &AgentHost::setClientTimeouts )
         .def( "setVideoPolicy",                 &AgentHost::setVideoPolicy )
         .def( "setRewardsPolicy",               &AgentHost::setRewardsPolicy )
         .def( "setObservationsPolicy",          &AgentHost::setObservationsPolicy )
+        .def( "setVideoFramesLimit",            &AgentHost::setVideoFramesLimit )
+        .def( "setRewardsLimit",                &AgentHost::setRewardsLimit )
+        .def( "setObservationsLimit",           &AgentHost::setObservationsLimit )
+        .def( "setVideoPreprocessor",           &AgentHost::setVideoPreprocessor )
+        .def( "setVideoAlignment",              &AgentHost::setVideoAlignment )
+        .def( "setSharedMemoryVideo",           &AgentHost::setSharedMemoryVideo )
+        .def( "setLocalSockets",                &AgentHost::setLocalSockets )
+        .def( "setFrameStackDepth",             &AgentHost::setFrameStackDepth )
+        .def( "getFrameStack",                  &AgentHost::getFrameStack )
         .def( "sendCommand",                    sendCommand )
         .def( "sendCommand",                    sendCommandWithKey )
+        .def( "sendCommands",                   sendCommandList )
         .def("getRecordingTemporaryDirectory",  &AgentHost::getRecordingTemporaryDirectory)
         .def( "setDebugOutput",                 &AgentHost::setDebugOutput )
         .def(self_ns::str(self_ns::self))
     ;
+    class_< BatchedWorldState >( "BatchedWorldState", init<>() )
+        .add_property( "world_states",          getBatchedWorldStates )
+        .def_readonly( "frames",                &BatchedWorldState::frames )
+        .add_property( "steps_completed",       getStepsCompleted )
+        .add_property( "frames_updated",        getFramesUpdated )
+    ;
+    class_< VectorAgentHost, boost::shared_ptr< VectorAgentHost >, boost::noncopyable >( "VectorAgentHost", no_init )
+        .def( "__init__",                       make_constructor( createVectorAgentHost ) )
+        .def( "getNumberOfEnvironments",        &VectorAgentHost::getNumberOfEnvironments )
+        .def( "getAgentHost",                   &VectorAgentHost::getAgentHost, return_internal_reference<>() )
+        .def( "setBatchedFrameType",            &VectorAgentHost::setBatchedFrameType )
+        .def( "step",                           stepAll )
+        .def( "stepAsync",                      stepAllAsync )
+        .def( "waitForAnyStep",                 waitForAnyStep )
+        .def( "waitForSteps",                   waitForSteps )
+    ;
 #ifdef WRAP_ALE
     class_< ALEAgentHost, bases< ArgumentParser >, boost::noncopyable >("ALEAgentHost", init<>())
         .def("startMission",                    startALEMissionSimple)
@@ -306,6 +563,49 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .def("setDestination",          &MissionRecordSpec::setDestination)
         .def(self_ns::str(self_ns::self))
     ;
+    enum_< FramePreprocessor::ResizeFilter >("ResizeFilter")
+        .value("AREA", FramePreprocessor::AREA)
+        .value("BILINEAR", FramePreprocessor::BILINEAR)
+    ;
+    class_< FramePreprocessor >("FramePreprocessor", init<>())
+        .def("crop",                    &FramePreprocessor::crop)
+        .def("resize",                  resizeWithArea)
+        .def("resize",                  resizeWithFilter)
+        .def("convertToGrayscale",      &FramePreprocessor::convertToGrayscale)
+        .def("reorderToChannelsFirst",  &FramePreprocessor::reorderToChannelsFirst)
+        .def("convertToFloat",          convertToUnitFloat)
+        .def("convertToFloat",          convertToScaledFloat)
+    ;
+    enum_< WorldStateCondition::Combination >("WorldStateConditionCombination")
+        .value("ANY", WorldStateCondition::ANY)
+        .value("ALL", WorldStateCondition::ALL)
+    ;
+    class_< WorldStateCondition >("WorldStateCondition", init<>())
+        .def(init< WorldStateCondition::Combination >())
+        .def("requireObservations",         &WorldStateCondition::requireObservations)
+        .def("requireRewards",              &WorldStateCondition::requireRewards)
+        .def("requireVideoFrames",          &WorldStateCondition::requireVideoFrames)
+        .def("requireVideoFramesOfType",    &WorldStateCondition::requireVideoFramesOfType)
+        .def("requireMissionBegun",         &WorldStateCondition::requireMissionBegun)
+        .def("requireMissionEnded",         &WorldStateCondition::requireMissionEnded)
+    ;
+    class_< MissionStartFuture >("MissionStartFuture", init<>())
+        .def("isValid",                 &MissionStartFuture::isValid)
+        .def("isReady",                 &MissionStartFuture::isReady)
+        .def("waitFor",                 waitForMissionStart)
+        .def("get",                     getMissionStart)
+    ;
+    class_< LatencyHistogram >("LatencyHistogram", init<>())
+        .def("reset",                   &LatencyHistogram::reset)
+        .def("getCount",                &LatencyHistogram::getCount)
+        .def("getMeanMs",               &LatencyHistogram::getMeanMs)
+        .def("getMinMs",                &LatencyHistogram::getMinMs)
+        .def("getMaxMs",                &LatencyHistogram::getMaxMs)
+        .def("getPercentileMs",         &LatencyHistogram::getPercentileMs)
+        .def("getBucketUpperBoundMs",   &LatencyHistogram::getBucketUpperBoundMs)
+        .staticmethod("getBucketUpperBoundMs")
+        .def(self_ns::str(self_ns::self))
+    ;
     class_< ClientInfo >("ClientInfo", init<>())
         .def(init<const std::string &>())
         .def(init<const std::string &, int>()) // address & control_port
@@ -315,8 +615,24 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .def_readonly("command_port",           &ClientInfo::command_port)
         .def(self_ns::str(self_ns::self))
     ;
+    class_< ClientRecord >("ClientRecord", init<>())
+        .def_readonly("connects",               &ClientRecord::connects)
+        .def_readonly("connect_ms",             &ClientRecord::connect_ms)
+        .def_readonly("replies",                &ClientRecord::replies)
+        .def_readonly("reply_ms",               &ClientRecord::reply_ms)
+        .def_readonly("recent_busy",            &ClientRecord::recent_busy)
+        .def_readonly("recent_failures",        &ClientRecord::recent_failures)
+        .def_readonly("missions_completed",     &ClientRecord::missions_completed)
+        .def_readonly("mission_seconds",        &ClientRecord::mission_seconds)
+        .def("getExpectedDelayMs",      &ClientRecord::getExpectedDelayMs)
+        .def("getMissionsPerHour",      &ClientRecord::getMissionsPerHour)
+        .def(self_ns::str(self_ns::self))
+    ;
     class_< ClientPool >("ClientPool", init<>())
         .def("add",                     &ClientPool::add)
+        .def("getClientRecord",         &ClientPool::getClientRecord)
+        .def("startHealthProbes",       &ClientPool::startHealthProbes)
+        .def("stopHealthProbes",        &ClientPool::stopHealthProbes)
         .def(self_ns::str(self_ns::self))
     ;
     class_<ParameterSet>("ParameterSet", init<>())
@@ -352,6 +668,34 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .value("LUMINANCE", TimestampedVideoFrame::LUMINANCE)
         .value("COLOUR_MAP", TimestampedVideoFrame::COLOUR_MAP);
 
+    class_< FrameView >( "FrameView" )
+        .add_property( "width",        &FrameView::getWidth )
+        .add_property( "height",       &FrameView::getHeight )
+        .add_property( "channels",     &FrameView::getChannels )
+        .add_property( "row_stride",   &FrameView::getRowStride )
+        .add_property( "pixel_stride", &FrameView::getPixelStride )
+        .def( "isPacked",              &FrameView::isPacked )
+        .def( "getValue",              &FrameView::getValue )
+        .def( "crop",                  &FrameView::crop )
+        .def( "subsample",             &FrameView::subsample )
+        .def( "packed",                &FrameView::packed )
+    ;
+
+    class_< FrameStack >( "FrameStack", init<>() )
+        .def(init<int>())
+        .add_property( "depth",        &FrameStack::getDepth )
+        .add_property( "count",        &FrameStack::getCount )
+        .add_property( "width",        &FrameStack::getWidth )
+        .add_property( "height",       &FrameStack::getHeight )
+        .add_property( "channels",     &FrameStack::getChannels )
+        .add_property( "frame_size",   &FrameStack::getFrameSize )
+        .add_property( "data",         make_function(&FrameStack::getData, return_value_policy<copy_const_reference>()))
+        .def( "isFloat",               &FrameStack::isFloat )
+        .def( "getSlot",               &FrameStack::getSlot )
+        .def( "getNewestSlot",         &FrameStack::getNewestSlot )
+        .def( "getTimestamp",          &FrameStack::getTimestamp )
+    ;
+
     register_ptr_to_python< boost::shared_ptr< TimestampedVideoFrame > >();
     class_< TimestampedVideoFrame >( "TimestampedVideoFrame", no_init )
         .add_property( "timestamp",   make_getter(&TimestampedVideoFrame::timestamp, return_value_policy<return_by_value>()))
@@ -364,7 +708,24 @@ BOOST_PYTHON_MODULE(MalmoPython)
         .def_readonly( "yaw",         &TimestampedVideoFrame::yaw)
         .def_readonly( "pitch",       &TimestampedVideoFrame::pitch)
         .def_readonly( "frametype",   &TimestampedVideoFrame::frametype)
-        .add_property( "pixels",      make_getter(&TimestampedVideoFrame::pixels, return_value_policy<return_by_value>()))
+        .def_readonly( "channels_first", &TimestampedVideoFrame::channels_first)
+        .def_readonly( "float_pixels", &TimestampedVideoFrame::float_pixels)
+        .add_property( "pixels",      make_function(&TimestampedVideoFrame::getPixels, return_value_policy<copy_const_reference>()))
+        .add_property( "view",        &TimestampedVideoFrame::getView )
+        .def(self_ns::str(self_ns::self))
+    ;
+    register_ptr_to_python< boost::shared_ptr< FrameBundle > >();
+    class_< FrameBundle >( "FrameBundle", no_init )
+        .add_property( "timestamp",   make_getter(&FrameBundle::timestamp, return_value_policy<return_by_value>()))
+        .def_readonly( "xPos",        &FrameBundle::xPos)
+        .def_readonly( "yPos",        &FrameBundle::yPos)
+        .def_readonly( "zPos",        &FrameBundle::zPos)
+        .def_readonly( "yaw",         &FrameBundle::yaw)
+        .def_readonly( "pitch",       &FrameBundle::pitch)
+        .def_readonly( "is_complete", &FrameBundle::is_complete)
+        .def( "hasFrame",             &FrameBundle::hasFrame)
+        .def( "getFrame",             &FrameBundle::getFrame)
+        .def( "getNumberOfFrames",    &FrameBundle::getNumberOfFrames)
         .def(self_ns::str(self_ns::self))
     ;
     class_< std::vector< boost::shared_ptr< TimestampedString > > >( "TimestampedStringVector" )
@@ -376,6 +737,9 @@ BOOST_PYTHON_MODULE(MalmoPython)
     class_< std::vector< boost::shared_ptr< TimestampedVideoFrame > > >( "TimestampedVideoFrameVector" )
         .def( vector_indexing_suite< std::vector< boost::shared_ptr< TimestampedVideoFrame > >, true >() )
     ;
+    class_< std::vector< boost::shared_ptr< FrameBundle > > >( "FrameBundleVector" )
+        .def( vector_indexing_suite< std::vector< boost::shared_ptr< FrameBundle > >, true >() )
+    ;
     class_< std::vector< std::string > >( "StringVector" )
         .def( vector_indexing_suite< std::vector< std::string >, true >() )
     ;
@@ -0,0 +1,73 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef _RECYCLINGPOOL_H_
+#define _RECYCLINGPOOL_H_
+
+// Boost:
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <vector>
+
+namespace malmo
+{
+    //! A pool of shared objects that are handed out again once nobody outside the pool holds a reference to them.
+    //! Lets the per-message paths (received buffers, video frames) run without allocating once the pool has warmed up.
+    //! Callers must treat an acquired object as theirs to fill in, and as read-only once it has been passed on.
+    template< typename T >
+    class RecyclingPool
+    {
+        public:
+
+            //! Constructs an empty pool.
+            //! \param max_pooled The most objects the pool will hold on to. Beyond this, acquire() returns objects that are simply freed after use.
+            RecyclingPool(std::size_t max_pooled)
+                : max_pooled(max_pooled)
+            {
+            }
+
+            //! Gets an object that nobody else is using, reusing a released one (with whatever capacity it had) if possible.
+            //! \returns A shared pointer to the object.
+            boost::shared_ptr< T > acquire()
+            {
+                boost::lock_guard<boost::mutex> scope_guard(this->pool_mutex);
+
+                // Only the pool holds a reference, so no other thread can be reading the object or can gain a new reference to it.
+                for (const auto& item : this->items) {
+                    if (item.use_count() == 1)
+                        return item;
+                }
+
+                boost::shared_ptr< T > item = boost::make_shared< T >();
+                if (this->items.size() < this->max_pooled)
+                    this->items.push_back(item);
+                return item;
+            }
+
+        private:
+
+            std::size_t max_pooled;
+            std::vector< boost::shared_ptr< T > > items;
+            boost::mutex pool_mutex;
+    };
+}
+
+#endif
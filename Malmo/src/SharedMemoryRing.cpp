@@ -0,0 +1,313 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "SharedMemoryRing.h"
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace malmo
+{
+    // The segment starts with this header, followed by the slots. Each slot is the message size (8 bytes) then the message.
+    // Producer and consumer may be different builds, so only fixed-size types and address-free atomics are used.
+    struct SharedMemoryRing::Header
+    {
+        std::atomic<std::uint32_t> magic;               // set last, once the rest of the header is valid
+        std::uint32_t version;
+        std::uint64_t slot_count;
+        std::uint64_t slot_size;
+        std::uint64_t slot_stride;
+        alignas(64) std::atomic<std::uint64_t> write_count;     // written by the producer
+        std::atomic<std::uint64_t> dropped_count;
+        std::atomic<std::uint32_t> doorbell;                    // futex word, bumped by the producer after each message
+        alignas(64) std::atomic<std::uint64_t> read_count;      // written by the consumer
+        std::atomic<std::uint32_t> consumer_waiting;
+    };
+
+    static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "Shared-memory rings need lock-free atomics.");
+
+    const std::uint32_t RING_MAGIC = 0x524d4c4d;   // "MLMR"
+    const std::uint32_t RING_VERSION = 1;
+    const std::size_t SLOT_SIZE_HEADER = sizeof(std::uint64_t);
+    const std::size_t SLOT_ALIGNMENT = 64;
+
+    bool SharedMemoryRing::isSupported()
+    {
+#ifdef _WIN32
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    std::string SharedMemoryRing::makeUniquePrefix()
+    {
+        static std::atomic<int> instance(0);
+#ifdef _WIN32
+        const long process = 0;
+#else
+        const long process = static_cast<long>(getpid());
+#endif
+        return "/malmo_" + std::to_string(process) + "_" + std::to_string(instance++);
+    }
+
+    std::string SharedMemoryRing::getSegmentName(const std::string& prefix, int stream)
+    {
+        return prefix + "_" + std::to_string(stream);
+    }
+
+    SharedMemoryRing::SharedMemoryRing(const std::string& name, bool owner)
+        : name(name)
+        , owner(owner)
+        , fd(-1)
+        , mapping(0)
+        , mapping_size(0)
+        , header(0)
+        , slot_count(0)
+        , slot_size(0)
+        , slot_stride(0)
+        , interrupted(false)
+    {
+    }
+
+    boost::shared_ptr<SharedMemoryRing> SharedMemoryRing::create(const std::string& name, std::size_t slot_count, std::size_t slot_size)
+    {
+        if (slot_count == 0 || slot_size == 0)
+            throw std::invalid_argument("Shared-memory ring needs at least one slot of at least one byte.");
+#ifdef _WIN32
+        throw std::runtime_error("Shared-memory rings are not supported on this platform.");
+#else
+        boost::shared_ptr<SharedMemoryRing> ring(new SharedMemoryRing(name, true));
+
+        const std::size_t stride = (SLOT_SIZE_HEADER + slot_size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+        const std::size_t header_size = (sizeof(Header) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+        ring->mapping_size = header_size + slot_count * stride;
+
+        shm_unlink(name.c_str());   // (left over from a process that didn't clean up)
+        ring->fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+        if (ring->fd < 0)
+            throw std::runtime_error("Failed to create shared memory " + name + ": " + std::strerror(errno));
+        if (ftruncate(ring->fd, static_cast<off_t>(ring->mapping_size)) != 0)
+            throw std::runtime_error("Failed to size shared memory " + name + ": " + std::strerror(errno));
+        ring->mapping = mmap(0, ring->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+        if (ring->mapping == MAP_FAILED) {
+            ring->mapping = 0;
+            throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(errno));
+        }
+
+        ring->header = new (ring->mapping) Header();
+        ring->header->version = RING_VERSION;
+        ring->header->slot_count = slot_count;
+        ring->header->slot_size = slot_size;
+        ring->header->slot_stride = stride;
+        ring->header->write_count = 0;
+        ring->header->dropped_count = 0;
+        ring->header->doorbell = 0;
+        ring->header->read_count = 0;
+        ring->header->consumer_waiting = 0;
+        ring->header->magic.store(RING_MAGIC, std::memory_order_release);
+        ring->slot_count = slot_count;
+        ring->slot_size = slot_size;
+        ring->slot_stride = stride;
+        return ring;
+#endif
+    }
+
+    boost::shared_ptr<SharedMemoryRing> SharedMemoryRing::open(const std::string& name)
+    {
+#ifdef _WIN32
+        throw std::runtime_error("Shared-memory rings are not supported on this platform.");
+#else
+        boost::shared_ptr<SharedMemoryRing> ring(new SharedMemoryRing(name, false));
+
+        ring->fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (ring->fd < 0)
+            throw std::runtime_error("Failed to open shared memory " + name + ": " + std::strerror(errno));
+        struct stat info;
+        if (fstat(ring->fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(Header))
+            throw std::runtime_error("Shared memory " + name + " is too small to be a ring.");
+        ring->mapping_size = static_cast<std::size_t>(info.st_size);
+        ring->mapping = mmap(0, ring->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+        if (ring->mapping == MAP_FAILED) {
+            ring->mapping = 0;
+            throw std::runtime_error("Failed to map shared memory " + name + ": " + std::strerror(errno));
+        }
+
+        ring->header = static_cast<Header*>(ring->mapping);
+        if (ring->header->magic.load(std::memory_order_acquire) != RING_MAGIC || ring->header->version != RING_VERSION)
+            throw std::runtime_error("Shared memory " + name + " is not a ring this version understands.");
+        const std::size_t header_size = (sizeof(Header) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+        const std::uint64_t slot_count = ring->header->slot_count;
+        const std::uint64_t slot_size = ring->header->slot_size;
+        const std::uint64_t slot_stride = ring->header->slot_stride;
+        if (slot_count == 0 || slot_stride < SLOT_SIZE_HEADER + slot_size || slot_stride > ring->mapping_size || slot_count > (ring->mapping_size - header_size) / slot_stride)
+            throw std::runtime_error("Shared memory " + name + " doesn't hold the ring its header describes.");
+        ring->slot_count = static_cast<std::size_t>(slot_count);
+        ring->slot_size = static_cast<std::size_t>(slot_size);
+        ring->slot_stride = static_cast<std::size_t>(slot_stride);
+        return ring;
+#endif
+    }
+
+    SharedMemoryRing::~SharedMemoryRing()
+    {
+#ifndef _WIN32
+        if (this->mapping)
+            munmap(this->mapping, this->mapping_size);
+        if (this->owner && this->fd >= 0) {
+            // Only remove the name if it is still ours - a replacement ring may have been created under it since.
+            struct stat ours, current;
+            const int current_fd = shm_open(this->name.c_str(), O_RDONLY, 0);
+            if (current_fd >= 0) {
+                if (fstat(this->fd, &ours) == 0 && fstat(current_fd, &current) == 0 && ours.st_dev == current.st_dev && ours.st_ino == current.st_ino)
+                    shm_unlink(this->name.c_str());
+                close(current_fd);
+            }
+        }
+        if (this->fd >= 0)
+            close(this->fd);
+#endif
+    }
+
+    std::size_t SharedMemoryRing::getSlotCount() const
+    {
+        return this->slot_count;
+    }
+
+    std::size_t SharedMemoryRing::getSlotSize() const
+    {
+        return this->slot_size;
+    }
+
+    std::uint64_t SharedMemoryRing::getWrittenCount() const
+    {
+        return this->header->write_count.load();
+    }
+
+    std::uint64_t SharedMemoryRing::getDroppedCount() const
+    {
+        return this->header->dropped_count.load();
+    }
+
+    unsigned char* SharedMemoryRing::getSlot(std::uint64_t index) const
+    {
+        const std::size_t header_size = (sizeof(Header) + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+        return static_cast<unsigned char*>(this->mapping) + header_size + (index % this->slot_count) * this->slot_stride;
+    }
+
+    bool SharedMemoryRing::write(const unsigned char* data, std::size_t size)
+    {
+        const std::uint64_t written = this->header->write_count.load(std::memory_order_relaxed);
+        if (size > this->slot_size || written - this->header->read_count.load(std::memory_order_acquire) >= this->slot_count) {
+            this->header->dropped_count++;
+            return false;
+        }
+
+        unsigned char* slot = getSlot(written);
+        const std::uint64_t message_size = size;
+        std::memcpy(slot, &message_size, SLOT_SIZE_HEADER);
+        std::memcpy(slot + SLOT_SIZE_HEADER, data, size);
+
+        // Publish, then wake the consumer if it might be asleep. (Both sides use sequentially consistent operations on
+        // write_count and consumer_waiting, so either we see that it is waiting or it sees the new message before sleeping.)
+        this->header->write_count.store(written + 1);
+        if (this->header->consumer_waiting.load())
+            ringDoorbell();
+        return true;
+    }
+
+    bool SharedMemoryRing::read(std::vector<unsigned char>& buffer, boost::posix_time::time_duration timeout)
+    {
+        const boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + timeout;
+        std::uint64_t read = this->header->read_count.load(std::memory_order_relaxed);
+        while (!this->interrupted) {
+            if (this->header->write_count.load(std::memory_order_acquire) != read) {
+                const unsigned char* slot = getSlot(read);
+                std::uint64_t message_size;
+                std::memcpy(&message_size, slot, SLOT_SIZE_HEADER);
+                const bool fits = message_size <= this->slot_size;
+                if (fits)
+                    buffer.assign(slot + SLOT_SIZE_HEADER, slot + SLOT_SIZE_HEADER + static_cast<std::size_t>(message_size));
+                this->header->read_count.store(++read, std::memory_order_release);
+                if (fits)
+                    return true;
+                // (Would run past the slot - the producer isn't writing the ring the way we laid it out.)
+                this->header->dropped_count++;
+                continue;
+            }
+
+            const boost::posix_time::time_duration remaining = deadline - boost::posix_time::microsec_clock::universal_time();
+            if (remaining.is_negative())
+                return false;
+
+            this->header->consumer_waiting.store(1);
+            const std::uint32_t seen = this->header->doorbell.load();
+            if (this->header->write_count.load() == read && !this->interrupted)
+                waitForDoorbell(seen, remaining);
+            this->header->consumer_waiting.store(0);
+        }
+        return false;
+    }
+
+    void SharedMemoryRing::interrupt()
+    {
+        this->interrupted = true;
+        ringDoorbell();
+    }
+
+    void SharedMemoryRing::ringDoorbell()
+    {
+        this->header->doorbell++;
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&this->header->doorbell), FUTEX_WAKE, INT_MAX, 0, 0, 0);
+#endif
+    }
+
+    void SharedMemoryRing::waitForDoorbell(std::uint32_t seen, boost::posix_time::time_duration timeout)
+    {
+#ifdef __linux__
+        // Returns straight away if the doorbell has already been rung since we looked at it.
+        struct timespec wait_time;
+        wait_time.tv_sec = static_cast<time_t>(timeout.total_seconds());
+        wait_time.tv_nsec = static_cast<long>((timeout.total_microseconds() % 1000000) * 1000);
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&this->header->doorbell), FUTEX_WAIT, seen, &wait_time, 0, 0);
+#else
+        boost::this_thread::sleep(std::min(timeout, boost::posix_time::time_duration(boost::posix_time::microseconds(100))));
+#endif
+    }
+}
@@ -0,0 +1,121 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _SHAREDMEMORYRING_H_
+#define _SHAREDMEMORYRING_H_
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+
+// STL:
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace malmo
+{
+    //! A ring of fixed-size message slots in a named shared-memory segment, for passing messages (e.g. video frames)
+    //! from one process to another on the same machine without going through the network stack.
+    //! There must be exactly one producer and one consumer. The consumer creates the segment and the producer opens it by name.
+    //! Each slot holds one message exactly as it would have been sent over TCP, minus the size header.
+    //! On Linux the producer rings a futex doorbell after each message; elsewhere the consumer polls.
+    //! Not available on Windows - see isSupported().
+    class SharedMemoryRing
+    {
+        public:
+
+            //! Returns true if shared-memory rings can be used on this platform.
+            static bool isSupported();
+
+            //! Makes a prefix for segment names that no other process on this machine will be using.
+            static std::string makeUniquePrefix();
+
+            //! Gets the name of the segment for one of a set of streams.
+            //! \param prefix The prefix shared by the set, e.g. from makeUniquePrefix().
+            //! \param stream The index of the stream within the set.
+            static std::string getSegmentName(const std::string& prefix, int stream);
+
+            //! Creates a segment, as the consumer. Any stale segment with the same name is replaced. The segment is removed when the ring is destroyed.
+            //! Throws std::runtime_error if the segment can't be created.
+            //! \param name The name of the segment.
+            //! \param slot_count The number of messages the ring can hold.
+            //! \param slot_size The largest message, in bytes.
+            static boost::shared_ptr<SharedMemoryRing> create(const std::string& name, std::size_t slot_count, std::size_t slot_size);
+
+            //! Opens an existing segment, as the producer. Throws std::runtime_error if there is no such segment, or it isn't a ring.
+            //! \param name The name of the segment.
+            static boost::shared_ptr<SharedMemoryRing> open(const std::string& name);
+
+            ~SharedMemoryRing();
+
+            //! Gets the name of the segment.
+            const std::string& getName() const { return this->name; }
+
+            //! Gets the number of messages the ring can hold.
+            std::size_t getSlotCount() const;
+
+            //! Gets the size in bytes of the largest message.
+            std::size_t getSlotSize() const;
+
+            //! Copies a message into the ring, as the producer. If the ring is full or the message is too big, the message is dropped.
+            //! \returns True if the message was written.
+            bool write(const unsigned char* data, std::size_t size);
+
+            //! Copies the oldest message out of the ring, as the consumer, waiting for one to arrive if necessary.
+            //! A message whose size doesn't fit its slot (written by a mismatched or broken producer) is skipped and counted as dropped.
+            //! \param buffer Filled with the message.
+            //! \param timeout How long to wait.
+            //! \returns True if there was a message; false if the wait timed out or was interrupted.
+            bool read(std::vector<unsigned char>& buffer, boost::posix_time::time_duration timeout);
+
+            //! Wakes up a consumer that is waiting in read(), and makes any later read() return immediately.
+            void interrupt();
+
+            //! Gets the number of messages the producer has written since the segment was created.
+            std::uint64_t getWrittenCount() const;
+
+            //! Gets the number of messages the producer has had to drop since the segment was created.
+            std::uint64_t getDroppedCount() const;
+
+        private:
+
+            struct Header;
+
+            SharedMemoryRing(const std::string& name, bool owner);
+            unsigned char* getSlot(std::uint64_t index) const;
+            void waitForDoorbell(std::uint32_t seen, boost::posix_time::time_duration timeout);
+            void ringDoorbell();
+
+            std::string name;
+            bool owner;
+            int fd;
+            void* mapping;
+            std::size_t mapping_size;
+            Header* header;
+            // The geometry, as checked when the ring was created or opened. (The copy in the header can be overwritten by the other side.)
+            std::size_t slot_count;
+            std::size_t slot_size;
+            std::size_t slot_stride;
+            std::atomic<bool> interrupted;
+    };
+}
+
+#endif
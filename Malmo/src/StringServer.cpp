@@ -83,6 +83,17 @@ namespace malmo {
         return this->server.getPort();
     }
 
+    StringServer& StringServer::listenOnLocalSocket(const std::string& name)
+    {
+        this->server.listenOnLocalSocket(name);
+        return *this;
+    }
+
+    std::string StringServer::getLocalSocket() const
+    {
+        return this->server.getLocalSocket();
+    }
+
     void StringServer::recordMessage(const TimestampedString string_message)
     {
         if (this->writer.is_open())
@@ -51,6 +51,12 @@ namespace malmo
 
             int getPort() const;
 
+            //! Also listen on a UNIX-domain socket, for clients on the same machine. See TCPServer::listenOnLocalSocket.
+            StringServer& listenOnLocalSocket(const std::string& name);
+
+            //! Gets the name of the UNIX-domain socket this server is listening on, or an empty string if there isn't one.
+            std::string getLocalSocket() const;
+
             //! Stop recording the data being received by the server.
             void stopRecording();
 
@@ -19,11 +19,15 @@
 
 // Local:
 #include "TCPClient.h"
+#include "ControlConnectionPool.h"
 #include "Logger.h"
 
 // Boost:
 #include <boost/asio.hpp>
 #include <boost/lexical_cast.hpp>
+
+// STL:
+#include <stdexcept>
 using boost::asio::ip::tcp;
 
 #define LOG_COMPONENT Logger::LOG_TCP
@@ -93,65 +97,22 @@ namespace malmo
         SendOverTCP(io_service,address, port, std::vector<unsigned char>(message.begin(), message.end()), withSizeHeader);
     }
     
-    std::string SendStringAndGetShortReply(boost::asio::io_service& io_service, const std::string& ip_address, int port, const std::string& message, bool withSizeHeader)
+    std::string SendStringAndGetShortReply(const std::string& ip_address, int port, const std::string& message, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms)
     {
-        const int MAX_PACKET_LENGTH = 1024;
-        unsigned char data[MAX_PACKET_LENGTH + 1];
-        
-        std::vector<unsigned char> message_vector(message.begin(), message.end());
-        
-        tcp::resolver resolver(io_service);
-        tcp::resolver::query query(ip_address, boost::lexical_cast<std::string>(port));
-        boost::system::error_code ec;
-        tcp::resolver::iterator endpoint_iterator = resolver.resolve(query, ec);
-
-        if (ec)
-            LOGERROR(LT("Failed to resolve "), ip_address, LT(":"), port, LT(" - "), ec.message());
-
-        tcp::socket socket(io_service);
-        boost::asio::connect(socket, endpoint_iterator, ec);
-        if (ec)
-            LOGERROR(LT("Failed to connect to "), ip_address, LT(":"), port, LT(" - "), ec.message());
-
-        const int SIZE_HEADER_LENGTH = 4;
-        u_long size_header;
-
-        if (withSizeHeader)
-        {
-            // the size header is 4 bytes containing the size of the body of the message as a network byte order integer
-            const int SIZE_HEADER_LENGTH = 4;
-            u_long size_header = htonl((u_long)message.size());
-            boost::asio::write(socket, boost::asio::buffer(&size_header, SIZE_HEADER_LENGTH), ec);
-            if (ec)
-                LOGERROR(LT("Failed to write header to "), ip_address, LT(":"), port, LT(" - "), ec.message());
-        }
-
-        size_t bytes_transferred = boost::asio::write(socket, boost::asio::buffer(message_vector), ec);
-        if (ec)
-            LOGERROR(LT("Failed to write message to "), ip_address, LT(":"), port, LT(" - "), ec.message(), LT(" ("), bytes_transferred, LT(" bytes written) - was trying to send: "), message);
-        else
-            LOGFINE(LT("Sent "), bytes_transferred, LT(" bytes to "), ip_address, LT(":"), port, LT(" -"), message);
-
-        boost::asio::read(socket, boost::asio::buffer(&size_header, SIZE_HEADER_LENGTH), boost::asio::transfer_exactly(SIZE_HEADER_LENGTH), ec);
-        if (ec)
-            LOGERROR(LT("Failed to read response header from "), ip_address, LT(":"), port, LT(" - "), ec.message());
-
-        size_header = ntohl(size_header);
-        
-        if (size_header > MAX_PACKET_LENGTH)
+        const ShortReply result = SendStringsAndGetShortReplies(std::vector< std::pair<std::string, int> >(1, std::make_pair(ip_address, port)), std::vector<std::string>(1, message), withSizeHeader, connect_timeout_ms, reply_timeout_ms).front();
+        if (!result.ok)
         {
-            LOGERROR(LT("Packet length of "), size_header, LT(" received from "), ip_address, LT(":"), port, LT(" exceeds maximum allowed. Throwing."));
-            throw std::runtime_error("Packet length exceeds maximum allowed.");
+            LOGERROR(LT("Failed to get a reply from "), ip_address, LT(":"), port, LT(" - "), result.error);
+            throw std::runtime_error("Failed to get a reply from " + ip_address + ":" + std::to_string(port) + " - " + result.error);
         }
+        return result.reply;
+    }
 
-        bytes_transferred = boost::asio::read(socket, boost::asio::buffer(data, size_header), boost::asio::transfer_exactly(size_header), ec );
-        if (ec)
-            LOGERROR(LT("Failed to read response body from "), ip_address, LT(":"), port, LT(" - "), ec.message(), LT(" (read "), bytes_transferred, LT(" bytes)"));
-
-        std::string reply(data, data + size_header);
-        if (!ec)
-            LOGFINE(LT("Received reply from  "), ip_address, LT(":"), port, LT(" - "), reply);
-        return reply;
+    std::vector<ShortReply> SendStringsAndGetShortReplies(const std::vector< std::pair<std::string, int> >& endpoints, const std::vector<std::string>& messages, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms)
+    {
+        // (the connections close when the pool goes)
+        ControlConnectionPool connections;
+        return connections.exchange(endpoints, messages, withSizeHeader, connect_timeout_ms, reply_timeout_ms);
     }
 }
 
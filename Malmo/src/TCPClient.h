@@ -17,11 +17,15 @@
 //  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 // --------------------------------------------------------------------------------------------------
 
+#ifndef _TCPCLIENT_H_
+#define _TCPCLIENT_H_
+
 // Boost:
 #include <boost/asio/io_service.hpp>
 
 // STL:
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace malmo
@@ -51,11 +55,49 @@ namespace malmo
     
     //! Sends a string over TCP and reads a reply. Creates and closes a connection in the process.
     //! If sending many messages to the same place, use ClientConnection instead
+    //! Throws std::runtime_error if the endpoint can't be reached or doesn't reply in time; a refused connection fails at once.
     //! \param address The IP address of the remote endpoint.
     //! \param port The port of the remote endpoint.
     //! \param message The message to send.
     //! \param withSizeHeader If true, prepends a 4-byte integer containing the size of the message.
+    //! \param connect_timeout_ms The longest resolving the address and connecting may take.
+    //! \param reply_timeout_ms The longest sending the message and reading the reply may take, once connected.
     //! \returns The reply as a string.
     //! \ref ClientConnection
-    std::string SendStringAndGetShortReply(boost::asio::io_service& io_service, const std::string& ip_address, int port, const std::string& message, bool withSizeHeader);
+    std::string SendStringAndGetShortReply(const std::string& ip_address, int port, const std::string& message, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms);
+
+    //! The outcome of one of the exchanges made by SendStringsAndGetShortReplies.
+    struct ShortReply
+    {
+        ShortReply() : ok(false), timed_out(false), elapsed_ms(0) {}
+
+        //! True if the exchange completed in time.
+        bool ok;
+
+        //! True if the exchange failed because a deadline passed, rather than because the endpoint refused or dropped the connection.
+        bool timed_out;
+
+        //! How long, in milliseconds, the reply took to arrive (or the connection to be made, if that was all that was asked), from the start of the exchange.
+        double elapsed_ms;
+
+        //! The reply. Empty if the exchange failed or only connected.
+        std::string reply;
+
+        //! What went wrong, if the exchange failed.
+        std::string error;
+    };
+
+    //! Sends a string to each of several endpoints over TCP and reads a short reply from each, as SendStringAndGetShortReply does - but all at once,
+    //! so that endpoints that are down cost one timeout between them rather than one each. Each exchange has its own deadline.
+    //! Messages for the same endpoint share a connection. To keep the connections open for next time, use a ControlConnectionPool.
+    //! Runs on a private io_service on the calling thread, and returns once every exchange has completed, failed or run out of time.
+    //! \param endpoints The IP address and port of each endpoint.
+    //! \param messages The message for each endpoint. An empty message only checks that the endpoint can be connected to.
+    //! \param withSizeHeader If true, prepends a 4-byte integer containing the size of each message.
+    //! \param connect_timeout_ms The longest resolving the address and connecting may take, for each exchange.
+    //! \param reply_timeout_ms The longest sending the message and reading the reply may take, for each exchange, once connected.
+    //! \returns The outcome of each exchange, in the order of the endpoints.
+    std::vector<ShortReply> SendStringsAndGetShortReplies(const std::vector< std::pair<std::string, int> >& endpoints, const std::vector<std::string>& messages, bool withSizeHeader, int connect_timeout_ms, int reply_timeout_ms);
 }
+
+#endif
@@ -23,18 +23,25 @@
 
 // Boost:
 #include <boost/bind.hpp>
-using boost::asio::ip::tcp;
+
+// STL:
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #define LOG_COMPONENT Logger::LOG_TCP
 
 namespace malmo
 {
-    boost::shared_ptr<TCPConnection> TCPConnection::create(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name)
+    // Big enough for a burst of observations or rewards; anything bigger (like a video frame) is read straight into its own buffer.
+    const size_t READ_AHEAD_SIZE = 64 * 1024;
+
+    boost::shared_ptr<TCPConnection> TCPConnection::create(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name, boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool, boost::shared_ptr< boost::asio::io_service::strand > strand)
     {
-        return boost::shared_ptr<TCPConnection>(new TCPConnection(io_service, callback, expect_size_header, log_name) );
+        return boost::shared_ptr<TCPConnection>(new TCPConnection(io_service, callback, expect_size_header, log_name, buffer_pool, strand) );
     }
 
-    tcp::socket& TCPConnection::getSocket()
+    StreamSocket& TCPConnection::getSocket()
     {
         return this->socket;
     }
@@ -47,70 +54,113 @@ namespace malmo
 
     void TCPConnection::read()
     {
-        if( this->expect_size_header )
-        {
-            this->header_buffer.resize( SIZE_HEADER_LENGTH );
-            boost::asio::async_read(
-                this->socket,
-                boost::asio::buffer( this->header_buffer ),
-                boost::bind(
-                    &TCPConnection::handle_read_header,
-                    shared_from_this(),
-                    boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred
-                )
-            );
+        if (this->read_buffer.empty())
+            this->read_buffer.resize(READ_AHEAD_SIZE);
+
+        // Hand on every complete message we already have.
+        while (processBufferedMessage()) {}
+
+        if (this->read_start == this->read_end)
+            this->read_start = this->read_end = 0;
+
+        if (this->expect_size_header && this->read_end - this->read_start >= SIZE_HEADER_LENGTH) {
+            const size_t body_size = getSizeFromHeader(&this->read_buffer[this->read_start]);
+            if (SIZE_HEADER_LENGTH + body_size > this->read_buffer.size()) {
+                // Too big for the read-ahead buffer - move what we have of the body into its own buffer and read the rest straight in.
+                const size_t body_start = this->read_start + SIZE_HEADER_LENGTH;
+                const size_t have = this->read_end - body_start;
+                this->body_buffer = this->buffer_pool->acquire();
+                this->body_buffer->resize(body_size);
+                std::copy(this->read_buffer.begin() + body_start, this->read_buffer.begin() + this->read_end, this->body_buffer->begin());
+                this->read_start = this->read_end = 0;
+                boost::asio::async_read(
+                    this->socket,
+                    boost::asio::buffer(&(*this->body_buffer)[have], body_size - have),
+                    this->strand->wrap(boost::bind(
+                        &TCPConnection::handle_read_body,
+                        shared_from_this(),
+                        boost::asio::placeholders::error,
+                        boost::asio::placeholders::bytes_transferred
+                    ))
+                );
+                return;
+            }
+        }
+
+        // Move any partial message to the front, to make room to read as much as the socket has.
+        if (this->read_start > 0) {
+            std::copy(this->read_buffer.begin() + this->read_start, this->read_buffer.begin() + this->read_end, this->read_buffer.begin());
+            this->read_end -= this->read_start;
+            this->read_start = 0;
+        }
+        if (this->read_end == this->read_buffer.size())
+            this->read_buffer.resize(2 * this->read_buffer.size());  // (a line longer than the buffer)
+
+        this->socket.async_read_some(
+            boost::asio::buffer(&this->read_buffer[this->read_end], this->read_buffer.size() - this->read_end),
+            this->strand->wrap(boost::bind(
+                &TCPConnection::handle_read_some,
+                shared_from_this(),
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred
+            ))
+        );
+    }
+
+    bool TCPConnection::processBufferedMessage()
+    {
+        const unsigned char* begin = this->read_buffer.data() + this->read_start;
+        const size_t available = this->read_end - this->read_start;
+        size_t message_size;
+        if (this->expect_size_header) {
+            if (available < SIZE_HEADER_LENGTH)
+                return false;
+            const size_t body_size = getSizeFromHeader(begin);
+            if (available - SIZE_HEADER_LENGTH < body_size)
+                return false;
+            this->body_buffer = this->buffer_pool->acquire();
+            this->body_buffer->assign(begin + SIZE_HEADER_LENGTH, begin + SIZE_HEADER_LENGTH + body_size);
+            message_size = SIZE_HEADER_LENGTH + body_size;
         }
         else {
-            boost::asio::async_read_until(
-                this->socket,
-                this->delimited_buffer,
-                '\n',
-                boost::bind(
-                    &TCPConnection::handle_read_line,
-                    shared_from_this(),
-                    boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred
-                )
-            );
+            const unsigned char* newline = std::find(begin, begin + available, '\n');
+            if (newline == begin + available)
+                return false;
+            message_size = newline + 1 - begin;
+            this->body_buffer = this->buffer_pool->acquire();
+            this->body_buffer->assign(begin, begin + message_size);
         }
+        this->read_start += message_size;
+        LOGTRACE(LT("TCPConnection("), this->log_name, LT(")::processBufferedMessage("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - message size: "), message_size);
+        this->processMessage();
+        return true;
     }
 
-    void TCPConnection::handle_read_header(
+    void TCPConnection::handle_read_some(
         const boost::system::error_code& error,
         size_t bytes_transferred)
     {
-        if( !error ) {
-            LOGTRACE(LT("TCPConnection("), this->log_name, LT(")::handle_read_header("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred);
-            const size_t body_size = getSizeFromHeader();
-            this->body_buffer.resize( body_size );
-            boost::asio::async_read(
-                this->socket,
-                boost::asio::buffer( this->body_buffer ),
-                boost::bind(
-                    &TCPConnection::handle_read_body,
-                    shared_from_this(),
-                    boost::asio::placeholders::error,
-                    boost::asio::placeholders::bytes_transferred
-                )
-            );
+        if (!error) {
+            LOGTRACE(LT("TCPConnection("), this->log_name, LT(")::handle_read_some("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred);
+            this->read_end += bytes_transferred;
+            this->read();
         }
         else
-            LOGERROR(LT("TCPConnection("), this->log_name, LT(")::handle_read_header("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred, LT(" - ERROR: "), error.message());
+            LOGERROR(LT("TCPConnection("), this->log_name, LT(")::handle_read_some("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred, LT(" - ERROR: "), error.message());
     }
 
     std::string TCPConnection::safe_remote_endpoint() const
     {
         boost::system::error_code ec;
-        auto rep = this->socket.remote_endpoint(ec).address();
-        return ec ? ec.message() : rep.to_string();
+        auto rep = this->socket.remote_endpoint(ec);
+        return ec ? ec.message() : DescribeEndpoint(rep);
     }
 
     std::string TCPConnection::safe_local_endpoint() const
     {
         boost::system::error_code ec;
-        auto rep = this->socket.local_endpoint(ec).address();
-        return ec ? ec.message() : rep.to_string();
+        auto rep = this->socket.local_endpoint(ec);
+        return ec ? ec.message() : DescribeEndpoint(rep);
     }
 
     void TCPConnection::handle_read_body(
@@ -121,36 +171,24 @@ namespace malmo
         {
             LOGTRACE(LT("TCPConnection("), this->log_name, LT(")::handle_read_body("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred);
             this->processMessage();
+            this->read();
         }
         else
             LOGERROR(LT("TCPConnection("), this->log_name, LT(")::handle_read_body("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred, LT(" - ERROR: "), error.message());
     }
-
-    void TCPConnection::handle_read_line(
-        const boost::system::error_code& error,
-        size_t bytes_transferred)
-    {
-        if (!error) {
-            this->body_buffer.assign(
-                boost::asio::buffers_begin(this->delimited_buffer.data()),
-                boost::asio::buffers_begin(this->delimited_buffer.data()) + bytes_transferred
-                );
-            this->delimited_buffer.consume(bytes_transferred);
-            this->processMessage();
-        }
-        else
-            LOGERROR(LT("TCPConnection("), this->log_name, LT(")::handle_read_line("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes_transferred: "), bytes_transferred, LT(" - ERROR: "), error.message());
-    }
     
     void TCPConnection::processMessage()
     {
-        LOGFINE(LT("TCPConnection("), this->log_name, LT(")::processMessage("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes received: "), this->body_buffer.size());
+        LOGFINE(LT("TCPConnection("), this->log_name, LT(")::processMessage("), safe_local_endpoint(), LT("/"), safe_remote_endpoint(), LT(") - bytes received: "), this->body_buffer->size());
 
         if( this->confirm_with_fixed_reply )
             sendReply();
+
+        // Hand our reference to the buffer over to the message - the pool will recycle it once the receivers have finished with it.
+        boost::shared_ptr< std::vector<unsigned char> > message_data;
+        message_data.swap( this->body_buffer );
         this->onMessageReceived( TimestampedUnsignedCharVector( boost::posix_time::microsec_clock::universal_time(), 
-                                                                this->body_buffer ) );
-        this->read();
+                                                                message_data ) );
     }
 
     void TCPConnection::sendReply() 
@@ -169,8 +207,12 @@ namespace malmo
             LOGFINE(LT("TCPConnection("), this->log_name, LT(")::sendReply sent "), bytes_written, LT(" bytes"));
     }
 
-    TCPConnection::TCPConnection(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name)
+    TCPConnection::TCPConnection(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name, boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool, boost::shared_ptr< boost::asio::io_service::strand > strand)
         : socket(io_service)
+        , read_start(0)
+        , read_end(0)
+        , buffer_pool(buffer_pool)
+        , strand(strand)
         , onMessageReceived(callback)
         , confirm_with_fixed_reply(false)
         , expect_size_header(expect_size_header)
@@ -178,11 +220,11 @@ namespace malmo
     {
     }
 
-    size_t TCPConnection::getSizeFromHeader()
+    size_t TCPConnection::getSizeFromHeader(const unsigned char* header)
     {
-        u_long size_in_network_byte_order = *reinterpret_cast<u_long*>(&(this->header_buffer[0]));
-        u_long size_in_host_byte_order = ntohl(size_in_network_byte_order);
-        return size_in_host_byte_order;
+        uint32_t size_in_network_byte_order;
+        std::memcpy(&size_in_network_byte_order, header, SIZE_HEADER_LENGTH);
+        return ntohl(size_in_network_byte_order);
     }
 }
 
@@ -21,6 +21,8 @@
 #define _TCPCONNECTION_H_
 
 // Local:
+#include "LocalSocket.h"
+#include "RecyclingPool.h"
 #include "TimestampedUnsignedCharVector.h"
 
 // Boost:
@@ -33,7 +35,7 @@
 
 namespace malmo
 {
-    //! Handles an individual TCP connection.
+    //! Handles an individual connection, over TCP or a UNIX-domain socket.
     class TCPConnection : public boost::enable_shared_from_this< TCPConnection >
     {
         public:
@@ -42,9 +44,11 @@ namespace malmo
                 boost::asio::io_service& io_service, 
                 boost::function<void(const TimestampedUnsignedCharVector message) > callback,
                 bool expect_size_header,
-                const std::string& log_name);
+                const std::string& log_name,
+                boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool,
+                boost::shared_ptr< boost::asio::io_service::strand > strand);
 
-            boost::asio::ip::tcp::socket& getSocket();
+            StreamSocket& getSocket();
 
             void read();
             
@@ -52,31 +56,34 @@ namespace malmo
 
         private:
 
-            TCPConnection(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name);
+            TCPConnection(boost::asio::io_service& io_service, boost::function<void(const TimestampedUnsignedCharVector) > callback, bool expect_size_header, const std::string& log_name, boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool, boost::shared_ptr< boost::asio::io_service::strand > strand);
 
-            // called when we have successfully read the size header
-            void handle_read_header( const boost::system::error_code& error, size_t bytes_transferred );
+            // called when we have read some more bytes into the read-ahead buffer
+            void handle_read_some( const boost::system::error_code& error, size_t bytes_transferred );
 
-            // called when we have successfully read the body of the message, of known length
+            // called when we have read the rest of a message too big for the read-ahead buffer straight into its own buffer
             void handle_read_body( const boost::system::error_code& error, size_t bytes_transferred );
 
-            // called when we have successfully read the body of the message terminated by a newline
-            void handle_read_line( const boost::system::error_code& error, size_t bytes_transferred );
-
-            size_t getSizeFromHeader();
+            bool processBufferedMessage();
+            static size_t getSizeFromHeader(const unsigned char* header);
             void processMessage();
             void sendReply();
 
         private:
 
-            boost::asio::ip::tcp::socket socket;
+            StreamSocket socket;
             std::string safe_local_endpoint() const;
             std::string safe_remote_endpoint() const;
 
             static const int SIZE_HEADER_LENGTH = 4;
-            boost::asio::streambuf delimited_buffer;
-            std::vector<unsigned char> header_buffer;
-            std::vector<unsigned char> body_buffer;
+            // Bytes read from the socket but not yet handed on, from read_start to read_end. Reused for the life of the connection,
+            // so that one read can pick up several small messages.
+            std::vector<unsigned char> read_buffer;
+            size_t read_start;
+            size_t read_end;
+            boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool;
+            boost::shared_ptr< std::vector<unsigned char> > body_buffer; // each message is put in a pooled buffer, which is then handed on with the message
+            boost::shared_ptr< boost::asio::io_service::strand > strand; // shared with the server, so its messages are handled in order whichever thread runs them
 
             boost::function<void(const TimestampedUnsignedCharVector message) > onMessageReceived;
             
@@ -23,6 +23,7 @@
 
 // Boost:
 #include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/iterator/counting_iterator.hpp>
 #include <boost/make_shared.hpp>
 using boost::asio::ip::tcp;
@@ -31,16 +32,23 @@ using boost::asio::ip::tcp;
 #include <algorithm>
 #include <chrono>
 #include <random>
+#include <stdexcept>
 
 #define LOG_COMPONENT Logger::LOG_TCP
 
 namespace malmo
 {
+    // Enough for every connection a server normally has, with some left over for receivers that hang on to a message.
+    const std::size_t MAX_POOLED_BUFFERS = 16;
+
     TCPServer::TCPServer( boost::asio::io_service& io_service, int port, boost::function<void(const TimestampedUnsignedCharVector) > callback, const std::string& log_name )
         : onMessageReceived(callback)
+        , buffer_pool(boost::make_shared< RecyclingPool< std::vector<unsigned char> > >(MAX_POOLED_BUFFERS))
+        , strand(boost::make_shared< boost::asio::io_service::strand >(boost::ref(io_service)))
         , confirm_with_fixed_reply(false)
         , expect_size_header(true)
         , log_name(log_name)
+        , started(false)
     {
         if (port == 0) {
             // attempt to assign a port from a predefined range
@@ -54,9 +62,57 @@ namespace malmo
         }
     }
 
+    TCPServer::~TCPServer()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        // Sockets in the abstract namespace vanish with the last descriptor; those in the filesystem have to be removed.
+        if (this->local_acceptor && this->local_socket[0] != '@') {
+            boost::system::error_code ec;
+            boost::filesystem::remove(this->local_socket, ec);
+        }
+#endif
+    }
+
     void TCPServer::start()
     {
+        this->started = true;
         this->startAccept();
+        if (!this->local_socket.empty())
+            this->startLocalAccept();
+    }
+
+    void TCPServer::listenOnLocalSocket(const std::string& name)
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        if (!this->local_socket.empty())
+            throw std::runtime_error(this->log_name + " is already listening on " + this->local_socket);
+        if (name.empty())
+            throw std::invalid_argument("Local socket needs a name.");
+        if (name[0] != '@') {
+            boost::system::error_code ec;
+            boost::filesystem::remove(name, ec);  // (left over from a process that didn't clean up)
+        }
+        try
+        {
+            this->local_acceptor = boost::make_shared< boost::asio::local::stream_protocol::acceptor >(this->acceptor->get_io_service(), MakeLocalEndpoint(name));
+        }
+        catch (boost::system::system_error e)
+        {
+            LOGERROR(this->log_name, LT(" couldn't bind to local socket "), name, LT(" - "), e.code().message());
+            throw e;
+        }
+        LOGFINE(this->log_name, LT(" bound local socket "), name);
+        this->local_socket = name;
+        if (this->started)
+            this->startLocalAccept();
+#else
+        throw std::runtime_error("UNIX-domain sockets are not supported on this platform.");
+#endif
+    }
+
+    std::string TCPServer::getLocalSocket() const
+    {
+        return this->local_socket;
     }
     
     void TCPServer::confirmWithFixedReply(std::string reply)
@@ -70,33 +126,61 @@ namespace malmo
         this->expect_size_header = expect_size_header;
     }
 
-    void TCPServer::startAccept()
+    boost::shared_ptr<TCPConnection> TCPServer::createConnection()
     {
         boost::shared_ptr<TCPConnection> new_connection = TCPConnection::create(
             this->acceptor->get_io_service(),
             this->onMessageReceived,
             this->expect_size_header,
-            this->log_name
+            this->log_name,
+            this->buffer_pool,
+            this->strand
         );
             
         if( this->confirm_with_fixed_reply )
             new_connection->confirmWithFixedReply( this->fixed_reply );
 
+        return new_connection;
+    }
+
+    void TCPServer::startAccept()
+    {
+        boost::shared_ptr<TCPConnection> new_connection = createConnection();
+
         this->acceptor->async_accept(new_connection->getSocket(),
-            boost::bind(&TCPServer::handleAccept,
+            this->strand->wrap(boost::bind(&TCPServer::handleAccept,
+            this,
+            new_connection,
+            false,
+            boost::asio::placeholders::error)));
+    }
+
+    void TCPServer::startLocalAccept()
+    {
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+        boost::shared_ptr<TCPConnection> new_connection = createConnection();
+
+        this->local_acceptor->async_accept(new_connection->getSocket(),
+            this->strand->wrap(boost::bind(&TCPServer::handleAccept,
             this,
             new_connection,
-            boost::asio::placeholders::error));
+            true,
+            boost::asio::placeholders::error)));
+#endif
     }
     
     void TCPServer::handleAccept( 
         boost::shared_ptr<TCPConnection> new_connection,
+        bool local,
         const boost::system::error_code& error)
     {
         if (!error)
         {
             new_connection->read();
-            this->startAccept();
+            if (local)
+                this->startLocalAccept();
+            else
+                this->startAccept();
         }
         else
             LOGERROR(LT("TCPServer::handleAccept("), this->log_name, LT(") - "), error.message());
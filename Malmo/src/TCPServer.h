@@ -26,6 +26,9 @@
 // Boost:
 #include <boost/function.hpp>
 
+// STL:
+#include <string>
+
 namespace malmo
 {
     //! A TCP server that calls a function you provide when a message is received.
@@ -34,9 +37,12 @@ namespace malmo
         public:
 
             //! Constructs a TCP server but doesn't start it.
+            //! Messages are handled one at a time, in the order they arrive, however many threads are running the io_service.
             //! \param port The number of the port to connect to.
             //! \param callback The function to call when a message arrives.
             TCPServer(boost::asio::io_service& io_service, int port, boost::function<void(const TimestampedUnsignedCharVector) > callback, const std::string& log_name);
+
+            ~TCPServer();
             
             void confirmWithFixedReply(std::string reply);
             void expectSizeHeader(bool expect_size_header);
@@ -48,12 +54,24 @@ namespace malmo
             //! \returns The port this server is listening on.
             int getPort() const;
 
+            //! Also listens on a UNIX-domain socket, for clients on the same machine. Can be called before or after start().
+            //! Throws std::runtime_error if UNIX-domain sockets aren't supported here, or boost::system::system_error if the socket can't be bound.
+            //! \param name The name of the socket. A name starting with '@' is in the abstract namespace (Linux only), anything else is a path.
+            void listenOnLocalSocket(const std::string& name);
+
+            //! Gets the name of the UNIX-domain socket this server is listening on.
+            //! \returns The name of the socket, or an empty string if the server is only listening on its port.
+            std::string getLocalSocket() const;
+
         private:
 
+            boost::shared_ptr<TCPConnection> createConnection();
             virtual void startAccept();
+            void startLocalAccept();
 
             void handleAccept(
                 boost::shared_ptr<TCPConnection> new_connection,
+                bool local,
                 const boost::system::error_code& error
             );
 
@@ -61,13 +79,22 @@ namespace malmo
             void bindToRandomPortInRange(boost::asio::io_service& io_service, int port_min, int port_max);
             
             boost::shared_ptr< boost::asio::ip::tcp::acceptor > acceptor;
+#ifdef BOOST_ASIO_HAS_LOCAL_SOCKETS
+            boost::shared_ptr< boost::asio::local::stream_protocol::acceptor > local_acceptor;
+#endif
+            std::string local_socket;
             
             boost::function<void(const TimestampedUnsignedCharVector) > onMessageReceived;
+
+            // shared by all our connections, and kept alive by them if they outlast us:
+            boost::shared_ptr< RecyclingPool< std::vector<unsigned char> > > buffer_pool;
+            boost::shared_ptr< boost::asio::io_service::strand > strand;
             
             bool confirm_with_fixed_reply;
             std::string fixed_reply;
             bool expect_size_header;
             std::string log_name;
+            bool started;
     };
 }
 
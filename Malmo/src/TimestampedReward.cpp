@@ -22,6 +22,7 @@
 
 // Local:
 #include "FindSchemaFile.h"
+#include "Init.h"
 
 // Boost:
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -46,16 +47,8 @@ namespace malmo
         this->timestamp = timestamp;
 
         const bool validate = true;
-        
-        xml_schema::properties props;
-        props.schema_location(xml_namespace, FindSchemaFile("MissionEnded.xsd"));
-
-        xml_schema::flags flags = xml_schema::flags::dont_initialize;
-        if( !validate )
-            flags = flags | xml_schema::flags::dont_validate;
-
-        std::istringstream iss(xml_string);
-        std::unique_ptr<malmo::schemas::Reward> reward = malmo::schemas::Reward_(iss, flags, props);
+        DOMDocumentPtr doc = ParseXML(xml_string, validate);
+        std::unique_ptr<malmo::schemas::Reward> reward = malmo::schemas::Reward_(*doc, xml_schema::flags::dont_initialize);
         setValuesFromRewardStructure(*reward);
         return *this;
     }
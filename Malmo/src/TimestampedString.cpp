@@ -26,7 +26,7 @@ namespace malmo
 {
     TimestampedString::TimestampedString(const TimestampedUnsignedCharVector& message)
         : timestamp(message.timestamp)
-        , text(std::string(message.data.begin(), message.data.end()))
+        , text(std::string(message.data->begin(), message.data->end()))
     {
     }
 
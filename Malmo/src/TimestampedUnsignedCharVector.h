@@ -22,6 +22,8 @@
 
 // Boost:
 #include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
 
 // STL:
 #include <vector>
@@ -34,16 +36,23 @@ namespace malmo
         //! The timestamp.
         boost::posix_time::ptime timestamp;
         
-        //! The array of unsigned char values.
-        std::vector<unsigned char> data;
+        //! The array of unsigned char values. Shared rather than copied as the message is passed on, so treat it as read-only.
+        boost::shared_ptr< const std::vector<unsigned char> > data;
 
         TimestampedUnsignedCharVector(boost::posix_time::ptime timestamp, std::vector<unsigned char> data)
+            : timestamp(timestamp)
+            , data(boost::make_shared< const std::vector<unsigned char> >(std::move(data)))
+        {
+        }
+
+        TimestampedUnsignedCharVector(boost::posix_time::ptime timestamp, boost::shared_ptr< const std::vector<unsigned char> > data)
             : timestamp(timestamp)
             , data(data)
         {
         }
 
         TimestampedUnsignedCharVector()
+            : data(boost::make_shared< const std::vector<unsigned char> >())
         {
         }
     };
@@ -19,11 +19,13 @@
 
 // Local:
 #include "TimestampedVideoFrame.h"
+#include "FrameTransforms.h"
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/date_time/posix_time/posix_time_io.hpp>
 
 // Boost:
 #include <boost/asio.hpp>
+#include <boost/make_shared.hpp>
 
 namespace malmo
 {
@@ -37,55 +39,108 @@ namespace malmo
         , yaw(0)
         , pitch(0)
         , frametype(VIDEO)
+        , channels_first(false)
+        , float_pixels(false)
+        , pixels_packed(false)
     {
 
     }
 
-    TimestampedVideoFrame::TimestampedVideoFrame(short width, short height, short channels, TimestampedUnsignedCharVector& message, Transform transform, FrameType frametype)
-        : timestamp(message.timestamp)
-        , width(width)
-        , height(height)
-        , channels(channels)
-        , frametype(frametype)
-        , xPos(0)
-        , yPos(0)
-        , zPos(0)
-        , yaw(0)
-        , pitch(0)
+    TimestampedVideoFrame::TimestampedVideoFrame(short width, short height, short channels, const TimestampedUnsignedCharVector& message, Transform transform, FrameType frametype)
+        : pixels_packed(false)
+    {
+        assign(width, height, channels, message, transform, frametype);
+    }
+
+    TimestampedVideoFrame::TimestampedVideoFrame(const TimestampedVideoFrame& other)
+        : pixels_packed(false)
+    {
+        *this = other;
+    }
+
+    TimestampedVideoFrame& TimestampedVideoFrame::operator=(const TimestampedVideoFrame& other)
+    {
+        if (this == &other)
+            return *this;
+
+        FrameView other_view;
+        boost::shared_ptr< std::vector<unsigned char> > other_pixels;
+        {
+            boost::lock_guard<boost::mutex> scope_guard(other.pixels_mutex);
+            other_view = other.view;
+            // Once packed, the pixels never change again, so the copies can share them:
+            if (other.pixels_packed)
+                other_pixels = other.pixels;
+        }
+
+        this->timestamp = other.timestamp;
+        this->width = other.width;
+        this->height = other.height;
+        this->channels = other.channels;
+        this->frametype = other.frametype;
+        this->channels_first = other.channels_first;
+        this->float_pixels = other.float_pixels;
+        this->pitch = other.pitch;
+        this->yaw = other.yaw;
+        this->xPos = other.xPos;
+        this->yPos = other.yPos;
+        this->zPos = other.zPos;
+
+        boost::lock_guard<boost::mutex> scope_guard(this->pixels_mutex);
+        this->view = other_view;
+        this->pixels_packed = false;
+        if (other_pixels){
+            this->pixels = other_pixels;
+            this->pixels_packed = true;
+        }
+        return *this;
+    }
+
+    void TimestampedVideoFrame::assign(short width, short height, short channels, const TimestampedUnsignedCharVector& message, Transform transform, FrameType frametype)
     {
+        this->timestamp = message.timestamp;
+        this->width = width;
+        this->height = height;
+        this->channels = channels;
+        this->frametype = frametype;
+        this->channels_first = false;
+        this->float_pixels = false;
+
         // First extract the positional information from the header:
-        uint32_t * pInt = reinterpret_cast<uint32_t*>(&(message.data[0]));
+        const std::vector<unsigned char>& data = *message.data;
+        const uint32_t * pInt = reinterpret_cast<const uint32_t*>(&(data[0]));
         this->xPos = ntoh_float(*pInt); pInt++;
         this->yPos = ntoh_float(*pInt); pInt++;
         this->zPos = ntoh_float(*pInt); pInt++;
         this->yaw = ntoh_float(*pInt); pInt++;
         this->pitch = ntoh_float(*pInt);
 
+        boost::lock_guard<boost::mutex> scope_guard(this->pixels_mutex);
+        this->view = FrameView();   // (let go of our own pixels first, so that we can tell whether anyone else still holds them)
+        this->pixels_packed = false;
+
         const int stride = width * channels;
         switch (transform){
         case IDENTITY:
-            this->pixels = std::vector<unsigned char>(message.data.begin() + FRAME_HEADER_SIZE, message.data.end());
+            this->view = FrameView(message.data, FRAME_HEADER_SIZE, width, height, channels, stride, channels);
             break;
 
         case RAW_BMP:
-            this->pixels = std::vector<unsigned char>(message.data.begin() + FRAME_HEADER_SIZE, message.data.end());
-            if (channels == 3){
-                // Swap BGR -> RGB:
-                for (int i = 0; i < this->pixels.size(); i += 3){
-                    char t = this->pixels[i];
-                    this->pixels[i] = this->pixels[i + 2];
-                    this->pixels[i + 2] = t;
+            {
+                std::vector<unsigned char>& packed = ownPixels();
+                packed.assign(data.begin() + FRAME_HEADER_SIZE, data.end());
+                if (channels == 3 && !packed.empty()){
+                    // Swap BGR -> RGB:
+                    swapRedBlue(&packed[0], packed.size() / 3, 3);
                 }
+                this->view = FrameView(this->pixels, 0, width, height, channels, stride, channels);
+                this->pixels_packed = true;
             }
             break;
 
         case REVERSE_SCANLINE:
-            this->pixels = std::vector<unsigned char>();
-            for (int i = 0, offset = (height - 1)*stride; i < height; i++, offset -= stride){
-                auto it = message.data.begin() + offset + FRAME_HEADER_SIZE;
-                this->pixels.insert(this->pixels.end(), it, it + stride);
-            }
-
+            // Start from the last row and walk backwards - the flip only happens if someone asks for the packed pixels.
+            this->view = FrameView(message.data, FRAME_HEADER_SIZE + (height - 1) * stride, width, height, channels, -stride, channels);
             break;
 
         default:
@@ -93,9 +148,48 @@ namespace malmo
         }
     }
 
+    const std::vector<unsigned char>& TimestampedVideoFrame::getPixels() const
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->pixels_mutex);
+        if (!this->pixels_packed){
+            std::vector<unsigned char>& packed = ownPixels();
+            packed.resize(static_cast<size_t>(this->view.getWidth()) * this->view.getHeight() * this->view.getChannels());
+            if (!packed.empty())
+                this->view.copyTo(&packed[0]);
+            this->pixels_packed = true;
+        }
+        return *this->pixels;
+    }
+
+    void TimestampedVideoFrame::setPixels(std::vector<unsigned char> pixels)
+    {
+        swapPixels(pixels);
+    }
+
+    void TimestampedVideoFrame::swapPixels(std::vector<unsigned char>& pixels)
+    {
+        boost::lock_guard<boost::mutex> scope_guard(this->pixels_mutex);
+        this->view = FrameView();
+        ownPixels().swap(pixels);
+        this->pixels_packed = true;
+
+        // Planar pixels can't be described by a view; nor can a buffer that isn't a whole image (e.g. one that is being refilled).
+        const int bytes_per_pixel = this->channels * (this->float_pixels ? sizeof(float) : 1);
+        if (!this->channels_first && this->pixels->size() == static_cast<size_t>(this->width) * this->height * bytes_per_pixel && !this->pixels->empty())
+            this->view = FrameView(this->pixels, 0, this->width, this->height, bytes_per_pixel, this->width * bytes_per_pixel, bytes_per_pixel);
+    }
+
+    std::vector<unsigned char>& TimestampedVideoFrame::ownPixels() const
+    {
+        // Reuse our storage unless a copy of this frame, or a view, is still looking at it:
+        if (!this->pixels || this->pixels.use_count() != 1)
+            this->pixels = boost::make_shared< std::vector<unsigned char> >();
+        return *this->pixels;
+    }
+
     bool TimestampedVideoFrame::operator==(const TimestampedVideoFrame& other) const
     {
-        return this->frametype == other.frametype && this->width == other.width && this->height == other.height && this->channels == other.channels && this->timestamp == other.timestamp && this->pixels == other.pixels;
+        return this->frametype == other.frametype && this->width == other.width && this->height == other.height && this->channels == other.channels && this->timestamp == other.timestamp && this->getPixels() == other.getPixels();
         // Not much point in comparing pos, pitch and yaw - covered by the pixel comparison.
     }
 
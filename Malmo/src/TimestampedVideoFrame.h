@@ -21,10 +21,13 @@
 #define _TIMESTAMPEDVIDEOFRAME_H_
 
 // Local:
+#include "FrameView.h"
 #include "TimestampedUnsignedCharVector.h"
 
 // Boost:
 #include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 // STL:
 #include <vector>
@@ -64,6 +67,12 @@ namespace malmo
         //! The type of video data - eg 24bpp RGB, or 32bpp float depth
         FrameType frametype;
 
+        //! True if the pixels are stored one channel plane after another (CHW) rather than interleaved. Only set by preprocessing.
+        bool channels_first;
+
+        //! True if each value in the pixels is a 32-bit float rather than a byte. Only set by preprocessing.
+        bool float_pixels;
+
         //! The pitch of the player at render time
         float pitch;
 
@@ -79,16 +88,40 @@ namespace malmo
         //! The z pos of the player at render time
         float zPos;
 
-        //! The pixels, stored as channels then columns then rows. Length should be width*height*channels.
-        std::vector<unsigned char> pixels;
-
         TimestampedVideoFrame();
-        TimestampedVideoFrame(short width, short height, short channels, TimestampedUnsignedCharVector& message, Transform transform = IDENTITY, FrameType frametype = VIDEO);
+        TimestampedVideoFrame(short width, short height, short channels, const TimestampedUnsignedCharVector& message, Transform transform = IDENTITY, FrameType frametype = VIDEO);
+        TimestampedVideoFrame(const TimestampedVideoFrame& other);
+        TimestampedVideoFrame& operator=(const TimestampedVideoFrame& other);
+
+        //! Refills this frame from a received message, reusing the existing pixel storage where possible.
+        //! No pixels are copied unless the transform requires it - the frame keeps a view onto the message instead.
+        void assign(short width, short height, short channels, const TimestampedUnsignedCharVector& message, Transform transform = IDENTITY, FrameType frametype = VIDEO);
+
+        //! Gets the pixels, stored as channels then columns then rows, top row first. Length is width*height*channels.
+        //! The packed copy is made from the view the first time it is asked for, so frames that are never looked at cost nothing.
+        const std::vector<unsigned char>& getPixels() const;
+
+        //! Gets a strided view of the image, which can be read, cropped or subsampled without packing the pixels.
+        FrameView getView() const { return this->view; }
+
+        //! Replaces the image with pixels that are already packed as for getPixels(). Set width, height and channels first.
+        void setPixels(std::vector<unsigned char> pixels);
+
+        //! As setPixels(), but hands the frame's previous storage back in pixels, so that the caller can reuse it.
+        void swapPixels(std::vector<unsigned char>& pixels);
         
         bool operator==(const TimestampedVideoFrame& other) const;
         friend std::ostream& operator<<(std::ostream& os, const TimestampedVideoFrame& tsvidframe);
         friend std::ostream& operator<<(std::ostream& os, const TimestampedVideoFrame::FrameType& frametype);
         float ntoh_float(uint32_t value) const;
+
+    private:
+        std::vector<unsigned char>& ownPixels() const;
+
+        FrameView view;
+        mutable boost::shared_ptr< std::vector<unsigned char> > pixels;
+        mutable bool pixels_packed;
+        mutable boost::mutex pixels_mutex;
     };
 }
 
@@ -19,6 +19,7 @@
 
 // Local:
 #include "TorchTensorFromPixels.h"
+#include "FrameTransforms.h"
 
 // Torch:
 #include <THStorage.h>
@@ -39,17 +40,14 @@ namespace malmo
                 || tensor->size[2] != image.width )
             throw std::runtime_error( "Tensor size doesn't match frame size" );
         
-        int i = 0;
-        for( size_t rgb = 0; rgb < image.channels; rgb++ )
-        {
-            for( size_t y = 0; y < image.height; y++ )
-            {
-                for( size_t x = 0; x < image.width; x++ )
-                {
-                    tensor->storage->data[i] = static_cast<float>( image.pixels[ ((y*image.width) + x)*image.channels + rgb ] );
-                    i++;
-                }
-            }
-        }
+        // Split into channel planes first, so that the conversion to float is a straight run:
+        const size_t num_pixels = static_cast<size_t>( image.width ) * image.height;
+        const size_t num_values = num_pixels * image.channels;
+        std::vector<unsigned char> planes( num_values );
+        if( num_values > 0 )
+            deinterleaveChannels( &image.getPixels()[0], &planes[0], num_pixels, image.channels );
+
+        for( size_t i = 0; i < num_values; i++ )
+            tensor->storage->data[i] = static_cast<float>( planes[i] );
     }
 }
@@ -0,0 +1,204 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "VectorAgentHost.h"
+#include "Logger.h"
+
+// Boost:
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/utility/in_place_factory.hpp>
+
+// STL:
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#define LOG_COMPONENT Logger::LOG_AGENTHOST
+
+namespace malmo
+{
+    VectorAgentHost::VectorAgentHost(int num_environments, int num_io_threads, bool pin_to_cores)
+        : io_service(boost::make_shared<boost::asio::io_service>())
+        , world_state_signal(boost::make_shared<AgentHost::WorldStateSignal>())
+        , pending_steps(std::max(num_environments, 0))
+        , batched_frametype(TimestampedVideoFrame::VIDEO)
+        , latest_frames(std::max(num_environments, 0))
+    {
+        if (num_environments < 1)
+            throw std::invalid_argument("Need at least one environment.");
+        if (num_io_threads < 1)
+            throw std::invalid_argument("Need at least one io thread.");
+
+        for (int i = 0; i < num_environments; i++)
+            this->agent_hosts.push_back(boost::shared_ptr<AgentHost>(new AgentHost(this->io_service, this->world_state_signal)));
+
+        this->work = boost::in_place(boost::ref(*this->io_service));
+        const unsigned int num_cores = std::max(1u, boost::thread::hardware_concurrency());
+        for (int i = 0; i < num_io_threads; i++) {
+            this->io_threads.push_back(boost::make_shared<boost::thread>(boost::bind(&boost::asio::io_service::run, this->io_service.get())));
+            if (pin_to_cores && !AgentHost::pinThreadToCore(*this->io_threads.back(), i % num_cores))
+                LOGWARNING(LT("Failed to pin io thread "), i, LT(" to a core - carrying on unpinned."));
+        }
+    }
+
+    VectorAgentHost::~VectorAgentHost()
+    {
+        // The agent hosts' servers call back into them, so the threads must be stopped before the agent hosts go.
+        LOGSIMPLE(LOG_FINE, "Destroying VectorAgentHost - waiting for io_service to stop...");
+        this->work = boost::none;
+        this->io_service->stop();
+        for (auto& t : this->io_threads)
+            t->join();
+        LOGSIMPLE(LOG_FINE, "Destroying VectorAgentHost - io_service stopped.");
+        this->agent_hosts.clear();
+    }
+
+    int VectorAgentHost::getNumberOfEnvironments() const
+    {
+        return static_cast<int>(this->agent_hosts.size());
+    }
+
+    AgentHost& VectorAgentHost::getAgentHost(int index)
+    {
+        return *this->agent_hosts.at(index);
+    }
+
+    void VectorAgentHost::setBatchedFrameType(TimestampedVideoFrame::FrameType frametype)
+    {
+        this->batched_frametype = frametype;
+    }
+
+    // Waits until is_done() returns true or the time runs out. Any of the agent hosts receiving a message wakes us to check again.
+    template< typename Predicate >
+    bool VectorAgentHost::waitUntil(int timeout_ms, Predicate is_done)
+    {
+        const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+
+        AgentHost::WorldStateSignal& signal = *this->world_state_signal;
+        signal.waiters++;
+        // (Pairs with the fence in AgentHost::notifyWorldStateChanged.)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (bool timed_out = false;; ) {
+            // (Scanning the environments without the signal's mutex, so none of their io threads wait on us meanwhile.)
+            const unsigned int seen = signal.sequence.load(std::memory_order_acquire);
+            if (is_done()) {
+                signal.waiters--;
+                return true;
+            }
+            if (timed_out) {
+                signal.waiters--;
+                return false;
+            }
+            timed_out = !signal.waitForChange(seen, deadline);
+        }
+    }
+
+    BatchedWorldState VectorAgentHost::step(const std::vector<std::string>& commands, const WorldStateCondition& condition, int timeout_ms)
+    {
+        stepAsync(commands, condition);
+        return waitForSteps(timeout_ms);
+    }
+
+    void VectorAgentHost::stepAsync(const std::vector<std::string>& commands, const WorldStateCondition& condition)
+    {
+        if (commands.size() != this->agent_hosts.size())
+            throw std::invalid_argument("Need one command for each environment.");
+
+        this->step_condition = condition;
+        for (size_t i = 0; i < commands.size(); i++) {
+            if (!commands[i].empty())
+                this->pending_steps[i] = this->agent_hosts[i]->sendStepCommand(commands[i]);
+        }
+    }
+
+    int VectorAgentHost::waitForAnyStep(int timeout_ms, WorldState& world_state)
+    {
+        int completed = -1;
+        bool any_pending = false;
+        waitUntil(timeout_ms, [&]() {
+            any_pending = false;
+            for (size_t i = 0; i < this->pending_steps.size(); i++) {
+                if (!this->pending_steps[i])
+                    continue;
+                any_pending = true;
+                if (isStepComplete(static_cast<int>(i))) {
+                    completed = static_cast<int>(i);
+                    return true;
+                }
+            }
+            return !any_pending;
+        });
+        if (completed < 0)
+            return -1;
+
+        this->pending_steps[completed] = boost::none;
+        world_state = this->agent_hosts[completed]->getWorldState();
+        return completed;
+    }
+
+    BatchedWorldState VectorAgentHost::waitForSteps(int timeout_ms)
+    {
+        waitUntil(timeout_ms, [&]() {
+            for (size_t i = 0; i < this->pending_steps.size(); i++) {
+                if (this->pending_steps[i] && !isStepComplete(static_cast<int>(i)))
+                    return false;
+            }
+            return true;
+        });
+
+        BatchedWorldState batch;
+        batch.world_states.reserve(this->agent_hosts.size());
+        batch.steps_completed.assign(this->agent_hosts.size(), false);
+        batch.frames_updated.assign(this->agent_hosts.size(), false);
+        for (size_t i = 0; i < this->agent_hosts.size(); i++) {
+            // (If the wait timed out, some may have finished since it last looked - but not all, or it wouldn't have.)
+            if (this->pending_steps[i])
+                batch.steps_completed[i] = isStepComplete(static_cast<int>(i));
+            this->pending_steps[i] = boost::none;
+            batch.world_states.push_back(this->agent_hosts[i]->getWorldState());
+
+            const std::vector< boost::shared_ptr<TimestampedVideoFrame> >& frames = batch.world_states.back().video_frames;
+            for (auto frame = frames.rbegin(); frame != frames.rend(); ++frame) {
+                if ((*frame)->frametype == this->batched_frametype) {
+                    const TimestampedVideoFrame& latest = **frame;
+                    if (latest.width != this->latest_frames.getWidth() || latest.height != this->latest_frames.getHeight() || latest.channels != this->latest_frames.getChannels() || latest.float_pixels != this->latest_frames.isFloat())
+                        std::fill(batch.frames_updated.begin(), batch.frames_updated.end(), false);     // (the stack is about to be emptied)
+                    this->latest_frames.put(static_cast<int>(i), latest);
+                    batch.frames_updated[i] = true;
+                    break;
+                }
+            }
+        }
+        // (Shares the storage until the next frame is put, which then goes to the stack's other buffer if the caller still holds this batch.)
+        batch.frames = this->latest_frames;
+        return batch;
+    }
+
+    bool VectorAgentHost::isStepComplete(int index)
+    {
+        AgentHost& agent_host = *this->agent_hosts[index];
+        boost::lock_guard<boost::mutex> scope_guard(agent_host.world_state_mutex);
+        agent_host.collectWorldState();
+        return agent_host.isStepComplete(*this->pending_steps[index], this->step_condition);
+    }
+}
+
+#undef LOG_COMPONENT
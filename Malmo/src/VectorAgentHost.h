@@ -0,0 +1,139 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _VECTORAGENTHOST_H_
+#define _VECTORAGENTHOST_H_
+
+// Local:
+#include "AgentHost.h"
+#include "FrameStack.h"
+#include "TimestampedVideoFrame.h"
+#include "WorldState.h"
+#include "WorldStateCondition.h"
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <string>
+#include <vector>
+
+namespace malmo
+{
+    //! The world states of all the environments of a VectorAgentHost, with the latest video frame from each stacked into one array.
+    struct BatchedWorldState
+    {
+        //! The world state of each environment, in order.
+        std::vector<WorldState> world_states;
+
+        //! An N x C x H x W array holding the latest frame of the batched type from each environment: slot i is environment i.
+        //! A slot is zero, with no timestamp, until its environment has sent a frame. Frames from a step that brought none are kept from before:
+        //! see frames_updated.
+        FrameStack frames;
+
+        //! For each environment, whether its step was complete - its condition met, or its mission over - when the wait ended.
+        //! False if the wait timed out first, or if the environment wasn't waiting for a step (it was sent no command, or waitForAnyStep has already returned it).
+        std::vector<bool> steps_completed;
+
+        //! For each environment, whether its slot in frames holds a frame that arrived with this world state. If false, the slot still holds
+        //! the frame from an earlier step, or none.
+        std::vector<bool> frames_updated;
+    };
+
+    //! Runs several environments - a mission each, usually on separate Minecraft instances - from one agent, stepping them together.
+    //! The environments' agent hosts share one pool of network threads, and a step sends a command to each environment and waits for them all.
+    //! Each environment is set up and its mission started through its own AgentHost, from getAgentHost.
+    //! The steps aren't thread-safe: step the environments from one thread at a time.
+    class VectorAgentHost
+    {
+        public:
+
+            //! Creates the environments.
+            //! \param num_environments The number of environments, N. Must be at least one.
+            //! \param num_io_threads The number of threads handling the network traffic of all of the environments. Must be at least one.
+            //! \param pin_to_cores If true, restricts thread i to CPU core i (wrapping around if there are more threads than cores). Ignored on platforms that don't support it.
+            VectorAgentHost(int num_environments, int num_io_threads, bool pin_to_cores);
+
+            //! Stops the network threads, then destroys the environments.
+            ~VectorAgentHost();
+
+            //! Gets the number of environments.
+            //! \returns The number of environments, N.
+            int getNumberOfEnvironments() const;
+
+            //! Gets the agent host of an environment, for setting it up and starting its mission.
+            //! \param index The environment, from 0 to N - 1.
+            //! \returns The agent host, which lives as long as this VectorAgentHost does.
+            AgentHost& getAgentHost(int index);
+
+            //! Specifies which video stream to stack in BatchedWorldState::frames. The default is the colour video.
+            //! All the environments must send frames of the same size: a frame of a different size empties the stack.
+            //! \param frametype The video stream.
+            void setBatchedFrameType(TimestampedVideoFrame::FrameType frametype);
+
+            //! Sends a command to each environment and waits until what has arrived since meets the condition in all of them (or their missions end),
+            //! or the time runs out. Then gets the world states of all of the environments, as getWorldState does. BatchedWorldState::steps_completed
+            //! says which environments finished their steps in time.
+            //! \param commands The command for each environment, in order. An empty command sends nothing, and the environment isn't waited for.
+            //! \param condition What to wait for in each environment. e.g. an observation, a frame and a reward, with WorldStateCondition::ALL.
+            //! \param timeout_ms The longest time to wait, in milliseconds.
+            //! \returns The world states and frames.
+            BatchedWorldState step(const std::vector<std::string>& commands, const WorldStateCondition& condition, int timeout_ms);
+
+            //! Sends a command to each environment without waiting: follow with waitForAnyStep, to handle the environments as they finish, and/or waitForSteps.
+            //! \param commands The command for each environment, in order. An empty command sends nothing, and the environment isn't waited for.
+            //! \param condition What to wait for in each environment.
+            void stepAsync(const std::vector<std::string>& commands, const WorldStateCondition& condition);
+
+            //! Waits until the step of any environment sent a command by stepAsync is complete, then gets its world state, as getWorldState does.
+            //! Each environment is only returned once per command.
+            //! \param timeout_ms The longest time to wait, in milliseconds.
+            //! \param world_state Receives the world state of the environment.
+            //! \returns The environment, or -1 if none finished in time or none were waiting to.
+            int waitForAnyStep(int timeout_ms, WorldState& world_state);
+
+            //! Waits until the steps of all the environments sent a command by stepAsync are complete, or the time runs out.
+            //! Then gets the world states of all of the environments, as getWorldState does. BatchedWorldState::steps_completed
+            //! says which environments finished their steps in time.
+            //! \param timeout_ms The longest time to wait, in milliseconds.
+            //! \returns The world states and frames.
+            BatchedWorldState waitForSteps(int timeout_ms);
+
+        private:
+
+            template< typename Predicate > bool waitUntil(int timeout_ms, Predicate is_done);
+            bool isStepComplete(int index);
+
+            boost::shared_ptr<boost::asio::io_service> io_service;
+            boost::optional<boost::asio::io_service::work> work;
+            std::vector< boost::shared_ptr<boost::thread> > io_threads;
+            boost::shared_ptr<AgentHost::WorldStateSignal> world_state_signal;
+            std::vector< boost::shared_ptr<AgentHost> > agent_hosts;
+
+            WorldStateCondition step_condition;
+            std::vector< boost::optional<AgentHost::StepBaseline> > pending_steps;     // indexed by environment; empty if not waiting for it
+            TimestampedVideoFrame::FrameType batched_frametype;
+            FrameStack latest_frames;
+    };
+}
+
+#endif
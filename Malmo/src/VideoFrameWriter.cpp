@@ -129,7 +129,7 @@ namespace malmo
             }
 
             while (true) {
-                TimestampedVideoFrame frame;
+                boost::shared_ptr<TimestampedVideoFrame> frame;
                 {
                     boost::lock_guard<boost::mutex> buffer_guard(this->frame_buffer_mutex);
 
@@ -139,7 +139,7 @@ namespace malmo
                     }
                 }
 
-                if (frame.width == 0) {
+                if (!frame) {
                     boost::lock_guard<boost::mutex> frames_available_guard(this->frames_available_mutex);
 
                     this->frames_available = false;
@@ -148,7 +148,7 @@ namespace malmo
 
                 try
                 {
-                    writeSingleFrame(frame, this->frames_actually_written);
+                    writeSingleFrame(*frame, this->frames_actually_written);
                     this->frames_actually_written++;
                 }
                 catch (std::exception& e)
@@ -162,6 +162,7 @@ namespace malmo
     void VideoFrameWriter::writeSingleFrame(const TimestampedVideoFrame& frame, int count)
     {
         LOGTRACE(LT("Writing frame "), count + 1, LT(", "), frame.width, LT("x"), frame.height, LT("x"), frame.channels);
+        const std::vector<unsigned char>& pixels = frame.getPixels(); // (packs the frame on our thread, if nobody has yet)
         if (frame.channels == 4)
         {
             if (frame.frametype == TimestampedVideoFrame::DEPTH_MAP)
@@ -170,7 +171,7 @@ namespace malmo
                 // We could reduce to greyscale, but that way we loose a lot of precision.
                 // Instead, convert to an HSV colour cone, which hopefully gives a greater range
                 // of colour values to map to.
-                const float* fPixels = reinterpret_cast<const float*>(&(frame.pixels[0]));
+                const float* fPixels = reinterpret_cast<const float*>(&(pixels[0]));
                 char *out_pixels = new char[frame.width * frame.height * 3];
                 for (int i = 0; i < frame.width*frame.height; i++)
                 {
@@ -222,7 +223,7 @@ namespace malmo
                 char *out_pixels = new char[frame.width * frame.height * 3];
                 for (int i = 0; i < frame.width*frame.height; i++)
                 {
-                    out_pixels[i * 3] = out_pixels[i * 3 + 1] = out_pixels[i * 3 + 2] = frame.pixels[i * 4 + 3];
+                    out_pixels[i * 3] = out_pixels[i * 3 + 1] = out_pixels[i * 3 + 2] = pixels[i * 4 + 3];
                 }
                 this->doWrite(out_pixels, frame.width, frame.height, count);
                 delete[] out_pixels;
@@ -231,29 +232,29 @@ namespace malmo
         else if (frame.channels == 3 || frame.channels == 1)
         {
             // write the pixel data directly
-            this->doWrite((char*)&frame.pixels[0], frame.width, frame.height, count);
+            this->doWrite((char*)&pixels[0], frame.width, frame.height, count);
         }
         else throw std::runtime_error("Unsupported number of channels");
     }
 
-    bool VideoFrameWriter::write(TimestampedVideoFrame frame)
+    bool VideoFrameWriter::write(boost::shared_ptr<TimestampedVideoFrame> frame)
     {
         boost::lock_guard<boost::mutex> write_guard(this->write_mutex);
 
-        if (!this->drop_input_frames || frame.timestamp - this->last_timestamp >= this->frame_duration) {
-            this->last_timestamp = frame.timestamp;
+        if (!this->drop_input_frames || frame->timestamp - this->last_timestamp >= this->frame_duration) {
+            this->last_timestamp = frame->timestamp;
 
             std::stringstream name;
             name << "frame_" << std::setfill('0') << std::setw(6) << this->frame_index + 1;
             std::stringstream posdata;
-            posdata << "xyzyp: " << frame.xPos << " " << frame.yPos << " " << frame.zPos << " " << frame.yaw << " " << frame.pitch;
-            this->frame_info_stream << boost::posix_time::to_iso_string(frame.timestamp) << " " << name.str() << " " << posdata.str() << std::endl;
+            posdata << "xyzyp: " << frame->xPos << " " << frame->yPos << " " << frame->zPos << " " << frame->yaw << " " << frame->pitch;
+            this->frame_info_stream << boost::posix_time::to_iso_string(frame->timestamp) << " " << name.str() << " " << posdata.str() << std::endl;
 
             this->frame_index++;
             {
                 boost::lock_guard<boost::mutex> buffer_guard(this->frame_buffer_mutex);
 
-                LOGTRACE(LT("Pushing frame "), this->frame_index, LT(", "), frame.width, LT("x"), frame.height, LT("x"), frame.channels, LT(" to write buffer."));
+                LOGTRACE(LT("Pushing frame "), this->frame_index, LT(", "), frame->width, LT("x"), frame->height, LT("x"), frame->channels, LT(" to write buffer."));
                 this->frame_buffer.push(frame);
             }
 
@@ -43,7 +43,7 @@ namespace malmo
         virtual ~IFrameWriter() {}
         virtual void open() = 0;
         virtual void close() = 0;
-        virtual bool write(TimestampedVideoFrame frame) = 0;
+        virtual bool write(boost::shared_ptr<TimestampedVideoFrame> frame) = 0;
         virtual bool isOpen() const = 0;
         virtual size_t getFrameWriteCount() const = 0;
     };
@@ -56,7 +56,7 @@ namespace malmo
         virtual void open();
         virtual void close();
         
-        virtual bool write(TimestampedVideoFrame frame);
+        virtual bool write(boost::shared_ptr<TimestampedVideoFrame> frame);
         virtual bool isOpen() const;
         virtual size_t getFrameWriteCount() const { return frames_actually_written; }
 
@@ -85,7 +85,7 @@ namespace malmo
         int frame_index;
         int frames_actually_written = 0;
 
-        std::queue<TimestampedVideoFrame> frame_buffer;
+        std::queue< boost::shared_ptr<TimestampedVideoFrame> > frame_buffer;
         boost::mutex write_mutex;
         boost::mutex frame_buffer_mutex;
         boost::mutex frames_available_mutex;
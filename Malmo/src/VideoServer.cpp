@@ -24,10 +24,17 @@
 
 // Boost:
 #include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <stdexcept>
 
 namespace malmo 
 {
-    VideoServer::VideoServer( boost::asio::io_service& io_service, int port, short width, short height, short channels, TimestampedVideoFrame::FrameType frametype, const boost::function<void(TimestampedVideoFrame message)> handle_frame )
+    // Enough to ride out a short stall in the handler without the sender having to drop frames.
+    const std::size_t SHARED_MEMORY_SLOTS = 4;
+
+    VideoServer::VideoServer( boost::asio::io_service& io_service, int port, short width, short height, short channels, TimestampedVideoFrame::FrameType frametype, const boost::function<void(const boost::shared_ptr<TimestampedVideoFrame> message)> handle_frame )
         : handle_frame( handle_frame )
         , width( width )
         , height( height )
@@ -38,7 +45,58 @@ namespace malmo
         , queued_frames(0)
         , transform(TimestampedVideoFrame::REVERSE_SCANLINE)
         , server( io_service, port, boost::bind( &VideoServer::handleMessage, this, _1 ), "vid" )
+        , frame_pool( MAX_POOLED_FRAMES )
+        , processed_frame_pool( MAX_POOLED_FRAMES )
+        , shared_memory_buffer_pool( MAX_POOLED_FRAMES )
+    {
+    }
+
+    VideoServer::~VideoServer()
+    {
+        if (this->shared_memory_ring){
+            this->shared_memory_thread.interrupt();
+            this->shared_memory_ring->interrupt();
+            this->shared_memory_thread.join();
+        }
+    }
+
+    VideoServer& VideoServer::preprocess(const FramePreprocessor& preprocessor)
+    {
+        boost::shared_ptr<FramePreprocessor> prepared;
+        if (!preprocessor.isIdentity()){
+            prepared = boost::make_shared<FramePreprocessor>(preprocessor);
+            prepared->prepare(this->width, this->height, this->channels);
+        }
+        boost::lock_guard<boost::mutex> scope_guard(this->preprocessor_mutex);
+        this->preprocessor = prepared;
+        return *this;
+    }
+
+    VideoServer& VideoServer::receiveFromSharedMemory(const std::string& name)
+    {
+        if (this->shared_memory_ring)
+            throw std::runtime_error("Video server is already receiving through shared memory " + this->shared_memory_ring->getName());
+        const std::size_t frame_size = TimestampedVideoFrame::FRAME_HEADER_SIZE + this->width * this->height * this->channels;
+        this->shared_memory_ring = SharedMemoryRing::create(name, SHARED_MEMORY_SLOTS, frame_size);
+        this->shared_memory_thread = boost::thread(boost::bind(&VideoServer::readSharedMemory, this, this->shared_memory_ring));
+        return *this;
+    }
+
+    std::string VideoServer::getSharedMemoryName() const
     {
+        return this->shared_memory_ring ? this->shared_memory_ring->getName() : std::string();
+    }
+
+    void VideoServer::readSharedMemory(boost::shared_ptr<SharedMemoryRing> ring)
+    {
+        for (;;){
+            boost::shared_ptr< std::vector<unsigned char> > buffer = this->shared_memory_buffer_pool.acquire();
+            const bool received = ring->read(*buffer, boost::posix_time::seconds(1));
+            boost::this_thread::interruption_point();
+            if (received){
+                handleMessage(TimestampedUnsignedCharVector(boost::posix_time::microsec_clock::universal_time(), buffer));
+            }
+        }
     }
 
     void VideoServer::start()
@@ -126,15 +184,30 @@ namespace malmo
 
     void VideoServer::handleMessage( TimestampedUnsignedCharVector message )
     {
-        if (message.data.size() != TimestampedVideoFrame::FRAME_HEADER_SIZE + this->width * this->height * this->channels)
+        if (message.data->size() != TimestampedVideoFrame::FRAME_HEADER_SIZE + this->width * this->height * this->channels)
         {
             // Have seen this happen during stress testing when a reward packet from (I think) a previous mission arrives during the next
             // one when the same port has been reassigned. Could throw here but chose to silently ignore since very rare.
             return;
         }
-        TimestampedVideoFrame frame(this->width, this->height, this->channels, message, this->transform, this->frametype);
+        boost::lock_guard<boost::mutex> message_guard(this->message_mutex);
+        boost::shared_ptr<TimestampedVideoFrame> frame = this->frame_pool.acquire();
+        frame->assign(this->width, this->height, this->channels, message, this->transform, this->frametype);
         this->received_frames++;
-        this->handle_frame(frame); 
+
+        boost::shared_ptr<const FramePreprocessor> preprocessor;
+        {
+            boost::lock_guard<boost::mutex> scope_guard(this->preprocessor_mutex);
+            preprocessor = this->preprocessor;
+        }
+        if (preprocessor){
+            boost::shared_ptr<TimestampedVideoFrame> processed = this->processed_frame_pool.acquire();
+            preprocessor->apply(*frame, *processed);
+            this->handle_frame(processed);
+        }
+        else {
+            this->handle_frame(frame);
+        }
 
         for (const auto& writer : this->writers){
             if (writer->isOpen()){
@@ -150,6 +223,17 @@ namespace malmo
         return this->server.getPort();
     }
 
+    VideoServer& VideoServer::listenOnLocalSocket(const std::string& name)
+    {
+        this->server.listenOnLocalSocket(name);
+        return *this;
+    }
+
+    std::string VideoServer::getLocalSocket() const
+    {
+        return this->server.getLocalSocket();
+    }
+
     short VideoServer::getWidth() const
     {
         return this->width;
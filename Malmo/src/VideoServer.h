@@ -21,12 +21,16 @@
 #define _VIDEOSERVER_H_
 
 // Local:
+#include "FramePreprocessor.h"
+#include "RecyclingPool.h"
+#include "SharedMemoryRing.h"
 #include "TCPServer.h"
 #include "TimestampedVideoFrame.h"
 #include "VideoFrameWriter.h"
 
 // Boost:
 #include <boost/function.hpp>
+#include <boost/thread.hpp>
 
 // STL:
 #include <vector>
@@ -39,7 +43,9 @@ namespace malmo
     {
         public:
 
-            VideoServer( boost::asio::io_service& io_service, int port, short width, short height, short channels, TimestampedVideoFrame::FrameType frametype, const boost::function<void(const TimestampedVideoFrame message)> handle_frame );
+            VideoServer( boost::asio::io_service& io_service, int port, short width, short height, short channels, TimestampedVideoFrame::FrameType frametype, const boost::function<void(const boost::shared_ptr<TimestampedVideoFrame> message)> handle_frame );
+
+            ~VideoServer();
             
             //! Request that the video is saved in an mp4 file. Call before either startInBackground() or startRecording().
             VideoServer& recordMP4(std::string path, int frames_per_second, int64_t bit_rate, bool drop_input_frames);
@@ -47,9 +53,29 @@ namespace malmo
             //! Request that each frame of the video is saved in an individual file. Call before either startInBackground() or startRecording().
             VideoServer& recordBmps(std::string path);
 
+            //! Request that each frame is transformed before being passed on. Recordings still get the original frames.
+            //! Throws std::invalid_argument if the preprocessing doesn't suit this server's frames.
+            VideoServer& preprocess(const FramePreprocessor& preprocessor);
+
+            //! Request that frames are also accepted through a shared-memory ring, for a sender on the same machine. Each slot holds one
+            //! message as it would have been sent over TCP. The ring is created straight away and read on a thread of its own until
+            //! the server is destroyed; the TCP port stays open. Throws std::runtime_error if the ring can't be created.
+            //! \param name The name of the shared-memory segment.
+            VideoServer& receiveFromSharedMemory(const std::string& name);
+
+            //! Gets the name of the shared-memory segment this server receives frames through.
+            //! \returns The name of the segment, or an empty string if receiveFromSharedMemory() hasn't been called.
+            std::string getSharedMemoryName() const;
+
             //! Gets the port this server is listening on.
             //! \returns The port this server is listening on.
             int getPort() const;
+
+            //! Also listen on a UNIX-domain socket, for clients on the same machine. See TCPServer::listenOnLocalSocket.
+            VideoServer& listenOnLocalSocket(const std::string& name);
+
+            //! Gets the name of the UNIX-domain socket this server is listening on, or an empty string if there isn't one.
+            std::string getLocalSocket() const;
             
             //! Gets the width of the video.
             //! \returns The width of the video in pixels.
@@ -80,9 +106,12 @@ namespace malmo
 
         private:
 
+            static const int MAX_POOLED_FRAMES = 64;
+
             void handleMessage( const TimestampedUnsignedCharVector message );
+            void readSharedMemory( boost::shared_ptr<SharedMemoryRing> ring );
             
-            boost::function<void(const TimestampedVideoFrame message)> handle_frame;
+            boost::function<void(const boost::shared_ptr<TimestampedVideoFrame> message)> handle_frame;
             short width;
             short height;
             short channels;
@@ -91,6 +120,20 @@ namespace malmo
             TCPServer server;
             std::vector<std::unique_ptr<IFrameWriter>> writers;
 
+            // Each frame is built once, in place, and then shared (read-only) between the handler and the writers.
+            RecyclingPool<TimestampedVideoFrame> frame_pool;
+
+            // Preprocessed frames go only to the handler. (Swapped as a whole, since it can be changed while frames are arriving.)
+            boost::shared_ptr<const FramePreprocessor> preprocessor;
+            boost::mutex preprocessor_mutex;
+            RecyclingPool<TimestampedVideoFrame> processed_frame_pool;
+
+            // Frames can arrive from the TCP server and from the shared-memory thread at the same time, so each is handled under this lock.
+            boost::mutex message_mutex;
+            boost::shared_ptr<SharedMemoryRing> shared_memory_ring;
+            boost::thread shared_memory_thread;
+            RecyclingPool< std::vector<unsigned char> > shared_memory_buffer_pool;
+
             // diagnostics:
             std::size_t received_frames;
             std::size_t queued_frames;
@@ -20,6 +20,9 @@
 // Local:
 #include "WorldState.h"
 
+// STL:
+#include <utility>
+
 namespace malmo
 {
     WorldState::WorldState()
@@ -28,6 +31,10 @@ namespace malmo
         , number_of_video_frames_since_last_state(0)
         , number_of_rewards_since_last_state(0)
         , number_of_observations_since_last_state(0)
+        , number_of_video_frames_dropped_since_last_state(0)
+        , number_of_rewards_dropped_since_last_state(0)
+        , number_of_observations_dropped_since_last_state(0)
+        , number_of_incomplete_video_bundles_since_last_state(0)
     {
     }
     
@@ -38,13 +45,37 @@ namespace malmo
         this->number_of_observations_since_last_state = 0;
         this->number_of_rewards_since_last_state = 0;
         this->number_of_video_frames_since_last_state = 0;
+        this->number_of_incomplete_video_bundles_since_last_state = 0;
+        this->number_of_video_frames_dropped_since_last_state = 0;
+        this->number_of_rewards_dropped_since_last_state = 0;
+        this->number_of_observations_dropped_since_last_state = 0;
         this->observations.clear();
         this->rewards.clear();
         this->video_frames.clear();
+        this->video_bundles.clear();
         this->mission_control_messages.clear();
         this->errors.clear();
     }
 
+    void WorldState::swap(WorldState& other)
+    {
+        std::swap(this->is_mission_running, other.is_mission_running);
+        std::swap(this->has_mission_begun, other.has_mission_begun);
+        std::swap(this->number_of_observations_since_last_state, other.number_of_observations_since_last_state);
+        std::swap(this->number_of_rewards_since_last_state, other.number_of_rewards_since_last_state);
+        std::swap(this->number_of_video_frames_since_last_state, other.number_of_video_frames_since_last_state);
+        std::swap(this->number_of_incomplete_video_bundles_since_last_state, other.number_of_incomplete_video_bundles_since_last_state);
+        std::swap(this->number_of_video_frames_dropped_since_last_state, other.number_of_video_frames_dropped_since_last_state);
+        std::swap(this->number_of_rewards_dropped_since_last_state, other.number_of_rewards_dropped_since_last_state);
+        std::swap(this->number_of_observations_dropped_since_last_state, other.number_of_observations_dropped_since_last_state);
+        this->observations.swap(other.observations);
+        this->rewards.swap(other.rewards);
+        this->video_frames.swap(other.video_frames);
+        this->video_bundles.swap(other.video_bundles);
+        this->mission_control_messages.swap(other.mission_control_messages);
+        this->errors.swap(other.errors);
+    }
+
     std::ostream& operator<<(std::ostream& os, const WorldState& ws)
     {
         os << "WorldState (";
@@ -21,6 +21,7 @@
 #define _WORLDSTATE_H_
 
 // Local:
+#include "FrameBundle.h"
 #include "TimestampedReward.h"
 #include "TimestampedString.h"
 #include "TimestampedVideoFrame.h"
@@ -35,9 +36,13 @@ namespace malmo
     {
         WorldState();
 
-        //! Resets the world state to be empty, with no mission running.
+        //! Resets the world state to be empty, with no mission running. The vectors keep their storage, for reuse.
         void clear();
 
+        //! Exchanges the contents of two world states, without copying any of the messages.
+        //! \param other The world state to exchange with.
+        void swap(WorldState& other);
+
         //! Specifies whether the mission had begun when this world state was taken (whether or not it has since finished).
         bool has_mission_begun;
 
@@ -62,12 +67,42 @@ namespace malmo
          */
         int number_of_observations_since_last_state;
 
+        //! Contains the number of video frames that were received but dropped, since the last time the world state was taken, because too many were waiting.
+        /*! Always zero unless the number of video frames kept is limited.
+         *  \see AgentHost::setVideoFramesLimit
+         */
+        int number_of_video_frames_dropped_since_last_state;
+
+        //! Contains the number of rewards that were received but dropped, since the last time the world state was taken, because too many were waiting.
+        /*! Always zero unless the number of rewards kept is limited.
+         *  \see AgentHost::setRewardsLimit
+         */
+        int number_of_rewards_dropped_since_last_state;
+
+        //! Contains the number of observations that were received but dropped, since the last time the world state was taken, because too many were waiting.
+        /*! Always zero unless the number of observations kept is limited.
+         *  \see AgentHost::setObservationsLimit
+         */
+        int number_of_observations_dropped_since_last_state;
+
         //! Contains the timestamped video frames that are stored in this world state.
         /*! May differ from the number of video frames that were received, depending on the video policy that was used.
          * \see AgentHost::setVideoPolicy
          */
         std::vector< boost::shared_ptr< TimestampedVideoFrame > > video_frames;
 
+        //! Contains the number of frame bundles that were given up on, incomplete, since the last time the world state was taken.
+        /*! Always zero unless video alignment is switched on.
+         *  \see video_bundles
+         */
+        int number_of_incomplete_video_bundles_since_last_state;
+
+        //! Contains the frames from the different video streams, grouped by the moment they were rendered.
+        /*! Only filled if video alignment is switched on. Follows the video policy, like video_frames.
+         * \see AgentHost::setVideoAlignment
+         */
+        std::vector< boost::shared_ptr< FrameBundle > > video_bundles;
+
         //! Contains the timestamped rewards that are stored in this world state.
         /*! May differ from the number of rewards that were received, depending on the rewards policy that was used.
          * \see AgentHost::setRewardsPolicy
@@ -0,0 +1,105 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Local:
+#include "WorldStateCondition.h"
+
+namespace malmo
+{
+    WorldStateCondition::WorldStateCondition()
+        : WorldStateCondition(ANY)
+    {
+    }
+
+    WorldStateCondition::WorldStateCondition(Combination combination)
+        : combination(combination)
+        , observations(0)
+        , rewards(0)
+        , video_frames(0)
+        , video_frames_of_type(TimestampedVideoFrame::_MAX_FRAME_TYPE, 0)
+        , mission_begun(false)
+        , mission_ended(false)
+    {
+    }
+
+    void WorldStateCondition::requireObservations(int count)
+    {
+        this->observations = count;
+    }
+
+    void WorldStateCondition::requireRewards(int count)
+    {
+        this->rewards = count;
+    }
+
+    void WorldStateCondition::requireVideoFrames(int count)
+    {
+        this->video_frames = count;
+    }
+
+    void WorldStateCondition::requireVideoFramesOfType(TimestampedVideoFrame::FrameType frametype, int count)
+    {
+        this->video_frames_of_type[frametype] = count;
+    }
+
+    void WorldStateCondition::requireMissionBegun()
+    {
+        this->mission_begun = true;
+    }
+
+    void WorldStateCondition::requireMissionEnded()
+    {
+        this->mission_ended = true;
+    }
+
+    bool WorldStateCondition::isSatisfiedBy(const WorldState& world_state, const std::vector<int>& video_frames_by_type) const
+    {
+        std::vector<bool> results;
+        if (this->observations > 0)
+            results.push_back(world_state.number_of_observations_since_last_state >= this->observations);
+        if (this->rewards > 0)
+            results.push_back(world_state.number_of_rewards_since_last_state >= this->rewards);
+        if (this->video_frames > 0)
+            results.push_back(world_state.number_of_video_frames_since_last_state >= this->video_frames);
+        for (size_t frametype = 0; frametype < this->video_frames_of_type.size(); frametype++) {
+            if (this->video_frames_of_type[frametype] > 0)
+                results.push_back(frametype < video_frames_by_type.size() && video_frames_by_type[frametype] >= this->video_frames_of_type[frametype]);
+        }
+        if (this->mission_begun)
+            results.push_back(world_state.has_mission_begun);
+        if (this->mission_ended)
+            results.push_back(world_state.has_mission_begun && !world_state.is_mission_running);
+
+        if (results.empty()) {
+            // Nothing in particular was asked for, so anything will do.
+            return world_state.number_of_observations_since_last_state > 0
+                || world_state.number_of_rewards_since_last_state > 0
+                || world_state.number_of_video_frames_since_last_state > 0
+                || !world_state.mission_control_messages.empty()
+                || !world_state.errors.empty();
+        }
+        for (bool result : results) {
+            if (result && this->combination == ANY)
+                return true;
+            if (!result && this->combination == ALL)
+                return false;
+        }
+        return this->combination == ALL;
+    }
+}
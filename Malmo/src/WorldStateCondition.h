@@ -0,0 +1,93 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+#ifndef _WORLDSTATECONDITION_H_
+#define _WORLDSTATECONDITION_H_
+
+// Local:
+#include "TimestampedVideoFrame.h"
+#include "WorldState.h"
+
+// STL:
+#include <vector>
+
+namespace malmo
+{
+    //! Specifies what AgentHost::waitForWorldState should wait for: some number of new observations, rewards or video frames
+    //! (all streams, or one in particular), the mission beginning or the mission ending - or any combination of these.
+    //! "New" means received since the world state was last taken. A condition with nothing required is met by anything new arriving.
+    class WorldStateCondition
+    {
+        public:
+
+            //! How the required things are combined.
+            enum Combination {
+                  ANY                        //!< The condition is met as soon as any of them has happened. This is the default.
+                , ALL                        //!< The condition is only met once all of them have happened.
+            };
+
+            //! Constructs a condition that is met by anything new arriving.
+            WorldStateCondition();
+
+            //! Constructs a condition with nothing required yet.
+            //! \param combination How the required things will be combined.
+            WorldStateCondition(Combination combination);
+
+            //! Requires a number of new observations.
+            //! \param count The number of observations.
+            void requireObservations(int count);
+
+            //! Requires a number of new rewards.
+            //! \param count The number of rewards.
+            void requireRewards(int count);
+
+            //! Requires a number of new video frames, from any of the video streams.
+            //! \param count The number of frames.
+            void requireVideoFrames(int count);
+
+            //! Requires a number of new video frames of one type.
+            //! \param frametype The video stream the frames must come from.
+            //! \param count The number of frames.
+            void requireVideoFramesOfType(TimestampedVideoFrame::FrameType frametype, int count);
+
+            //! Requires the mission to have begun.
+            void requireMissionBegun();
+
+            //! Requires the mission to have ended.
+            void requireMissionEnded();
+
+            //! Checks whether the condition is met.
+            //! \param world_state The world state, with everything received since it was last taken.
+            //! \param video_frames_by_type The number of video frames of each type received since then, indexed by frame type.
+            //! \returns True if the condition is met.
+            bool isSatisfiedBy(const WorldState& world_state, const std::vector<int>& video_frames_by_type) const;
+
+        private:
+
+            Combination combination;
+            int observations;
+            int rewards;
+            int video_frames;
+            std::vector<int> video_frames_of_type;     // indexed by frame type; 0 where not required
+            bool mission_begun;
+            bool mission_ended;
+    };
+}
+
+#endif
@@ -19,9 +19,16 @@
 
 // Malmo:
 #include <AgentHost.h>
+#include <ClientPool.h>
+#include <MissionRecordSpec.h>
+#include <MissionSpec.h>
 #include <WorldState.h>
 using namespace malmo;
 
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
 // STL:
 #include <iostream>
 using namespace std;
@@ -59,6 +66,76 @@ int main()
     if( world_state.video_frames.size() != 0 )
         return EXIT_FAILURE;
     
+    // With no mission running nothing can arrive, so waiting should give up after the timeout.
+    WorldStateCondition condition;
+    condition.requireObservations( 1 );
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    world_state = agent_host.waitForWorldState( 200, condition );
+    const boost::posix_time::time_duration waited = boost::posix_time::microsec_clock::universal_time() - start;
+    if( waited < boost::posix_time::milliseconds( 190 ) || waited > boost::posix_time::seconds( 5 ) )
+        return EXIT_FAILURE;
+
+    if( world_state.number_of_observations_since_last_state != 0 || world_state.is_mission_running )
+        return EXIT_FAILURE;
+
+    // Swapping in a used world state gives back an empty one.
+    world_state.number_of_observations_since_last_state = 3;
+    world_state.is_mission_running = true;
+    agent_host.swapWorldState( world_state );
+    if( world_state.number_of_observations_since_last_state != 0 || world_state.is_mission_running )
+        return EXIT_FAILURE;
+
+    // Stepping with no mission running can't send the command: it returns straight away with the error, and no latencies are counted.
+    world_state = agent_host.step( "move 1", condition, 5000 );
+    if( world_state.errors.size() != 1 || world_state.is_mission_running )
+        return EXIT_FAILURE;
+
+    if( agent_host.getCommandToObservationLatencies().getCount() != 0 || agent_host.getCommandToFrameLatencies().getCount() != 0 )
+        return EXIT_FAILURE;
+
+    // An asynchronous start hands back what startMission would have thrown - here, that there is no role 3 in a single-agent mission.
+    MissionStartFuture no_start;
+    if( no_start.isValid() )
+        return EXIT_FAILURE;
+
+    ClientPool client_pool;
+    client_pool.add( ClientInfo( "127.0.0.1" ) );
+    MissionStartFuture mission_start = agent_host.startMissionAsync( MissionSpec(), client_pool, MissionRecordSpec(), 3, "" );
+    if( !mission_start.isValid() || !mission_start.waitFor( 5000 ) || !mission_start.isReady() )
+        return EXIT_FAILURE;
+
+    try {
+        mission_start.get();
+        return EXIT_FAILURE;
+    }
+    catch( const MissionException& e ) {
+        if( e.getMissionErrorCode() != MissionException::MISSION_BAD_ROLE_REQUEST )
+            return EXIT_FAILURE;
+    }
+
+    // The negotiation has a thread of its own, so while a client keeps it waiting the io threads are free - here, to be replaced at once.
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor silent_client( io_service, boost::asio::ip::tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) ); // (connects, never replies)
+    ClientPool silent_pool;
+    silent_pool.add( ClientInfo( "127.0.0.1", silent_client.local_endpoint().port() ) );
+    agent_host.setClientTimeouts( 1000, 2000, 2000 );
+    MissionStartFuture waiting_start = agent_host.startMissionAsync( MissionSpec(), silent_pool, MissionRecordSpec(), 0, "" );
+    const boost::posix_time::ptime before_replacing = boost::posix_time::microsec_clock::universal_time();
+    agent_host.setNumberOfIoThreads( 2, false );
+    if( boost::posix_time::microsec_clock::universal_time() - before_replacing > boost::posix_time::milliseconds( 1000 ) )
+        return EXIT_FAILURE;
+
+    if( !waiting_start.waitFor( 20000 ) )
+        return EXIT_FAILURE;
+    try {
+        waiting_start.get();
+        return EXIT_FAILURE;
+    }
+    catch( const MissionException& e ) {
+        if( e.getMissionErrorCode() != MissionException::MISSION_INSUFFICIENT_CLIENTS_AVAILABLE )
+            return EXIT_FAILURE;
+    }
+
     cout << agent_host.getUsage() << endl;
 
     return EXIT_SUCCESS;
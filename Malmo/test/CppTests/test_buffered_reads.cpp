@@ -0,0 +1,153 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Checks that a TCPServer splits what arrives on a connection back into the messages that were sent, however the bytes
+// are batched or fragmented on the way, for both size-headed and newline-delimited messages.
+
+// Malmo:
+#include <TCPServer.h>
+
+// Boost:
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace malmo;
+
+std::vector<std::string> received;
+boost::mutex received_mutex;
+
+void onMessageReceived( TimestampedUnsignedCharVector message )
+{
+    boost::lock_guard<boost::mutex> scope_guard(received_mutex);
+    received.push_back( std::string( message.data->begin(), message.data->end() ) );
+}
+
+std::string withSizeHeader( const std::string& message )
+{
+    const uint32_t size = htonl( static_cast<uint32_t>( message.size() ) );
+    return std::string( reinterpret_cast<const char*>( &size ), sizeof( size ) ) + message;
+}
+
+bool waitFor( size_t num_messages )
+{
+    for (int wait = 0; wait < 200; wait++) {
+        {
+            boost::lock_guard<boost::mutex> scope_guard(received_mutex);
+            if (received.size() >= num_messages)
+                return true;
+        }
+        boost::this_thread::sleep( boost::posix_time::milliseconds(25) );
+    }
+    return false;
+}
+
+// Sends the messages in the given chunks, then checks that exactly the expected messages arrived, in order.
+bool sendAndCheck( const std::string& test_name, bool expect_size_header, const std::vector<std::string>& chunks, const std::vector<std::string>& expected )
+{
+    {
+        boost::lock_guard<boost::mutex> scope_guard(received_mutex);
+        received.clear();
+    }
+    boost::asio::io_service io_service;
+    boost::shared_ptr<boost::asio::io_service::work> work = boost::make_shared<boost::asio::io_service::work>( boost::ref(io_service) );
+    boost::thread bt( boost::bind( &boost::asio::io_service::run, &io_service ) );
+
+    bool ok = true;
+    {
+        TCPServer server( io_service, 0, onMessageReceived, "test" );
+        server.expectSizeHeader( expect_size_header );
+        server.start();
+
+        boost::asio::ip::tcp::socket socket( io_service );
+        socket.connect( boost::asio::ip::tcp::endpoint( boost::asio::ip::address::from_string( "127.0.0.1" ), server.getPort() ) );
+        socket.set_option( boost::asio::ip::tcp::no_delay( true ) );
+        for (const std::string& chunk : chunks) {
+            boost::asio::write( socket, boost::asio::buffer( chunk ) );
+            if (chunk.size() < 4)
+                boost::this_thread::sleep( boost::posix_time::milliseconds(2) );  // make sure tiny fragments arrive separately
+        }
+
+        waitFor( expected.size() );
+        boost::this_thread::sleep( boost::posix_time::milliseconds(50) );   // in case anything extra turns up
+        boost::lock_guard<boost::mutex> scope_guard(received_mutex);
+        if (received != expected) {
+            std::cout << test_name << ": received " << received.size() << " messages, expected " << expected.size() << std::endl;
+            for (size_t i = 0; i < received.size() && i < expected.size(); i++) {
+                if (received[i] != expected[i]) {
+                    std::cout << "  first difference at message " << i << " (" << received[i].size() << " bytes vs " << expected[i].size() << ")" << std::endl;
+                    break;
+                }
+            }
+            ok = false;
+        }
+    }
+
+    work.reset();
+    io_service.stop();
+    bt.join();
+    return ok;
+}
+
+int main()
+{
+    // Many small size-headed messages in a single write.
+    std::vector<std::string> messages;
+    std::string batch;
+    for (int i = 0; i < 1000; i++) {
+        messages.push_back( "reward " + std::to_string(i) );
+        batch += withSizeHeader( messages.back() );
+    }
+    if (!sendAndCheck( "batched", true, std::vector<std::string>( 1, batch ), messages ))
+        return EXIT_FAILURE;
+
+    // One message dribbled in a byte at a time, followed by another in the same write as its tail.
+    const std::string dribbled = withSizeHeader( "dribbled" ) + withSizeHeader( "" ) + withSizeHeader( "after" );
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < 10; i++)
+        chunks.push_back( dribbled.substr( i, 1 ) );
+    chunks.push_back( dribbled.substr( 10 ) );
+    const char* dribbled_expected[] = { "dribbled", "", "after" };
+    if (!sendAndCheck( "fragmented", true, chunks, std::vector<std::string>( dribbled_expected, dribbled_expected + 3 ) ))
+        return EXIT_FAILURE;
+
+    // A message much bigger than the read-ahead buffer, surrounded by small ones.
+    std::string big( 1 << 20, ' ' );
+    for (size_t i = 0; i < big.size(); i++)
+        big[i] = static_cast<char>( 'a' + i % 26 );
+    const std::vector<std::string> big_expected = { "before", big, "after" };
+    if (!sendAndCheck( "oversized", true, std::vector<std::string>( 1, withSizeHeader( "before" ) + withSizeHeader( big ) + withSizeHeader( "after" ) ), big_expected ))
+        return EXIT_FAILURE;
+
+    // Newline-delimited: several lines per write, a line split across writes, and a line longer than the read-ahead buffer.
+    const std::string long_line = big.substr( 0, 200000 ) + "\n";
+    const std::vector<std::string> line_chunks = { "one\ntwo\nthr", "ee\n", long_line + "four\n" };
+    const std::vector<std::string> lines_expected = { "one\n", "two\n", "three\n", long_line, "four\n" };
+    if (!sendAndCheck( "lines", false, line_chunks, lines_expected ))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
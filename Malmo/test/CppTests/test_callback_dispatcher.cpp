@@ -0,0 +1,190 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <CallbackDispatcher.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+using namespace std;
+
+// Waits for a flag to be set, giving up after a few seconds.
+bool waitFor(const std::atomic<bool>& flag)
+{
+    const ptime deadline = microsec_clock::universal_time() + seconds(5);
+    while (!flag && microsec_clock::universal_time() < deadline)
+        boost::this_thread::sleep(milliseconds(1));
+    return flag;
+}
+
+// Callbacks in one queue run one at a time, in order, however many threads there are.
+bool testOrder()
+{
+    const int num_callbacks = 2000;
+    int next_expected = 0;
+    std::atomic<int> running(0);
+    std::atomic<bool> ok(true);
+    std::atomic<bool> done(false);
+    {
+        CallbackDispatcher dispatcher(4, 1, num_callbacks);
+        for (int i = 0; i < num_callbacks; i++) {
+            dispatcher.post(0, [&, i]() {
+                if (++running != 1 || i != next_expected)
+                    ok = false;
+                next_expected = i + 1;
+                running--;
+                if (i == num_callbacks - 1)
+                    done = true;
+            });
+        }
+        if (!waitFor(done)) {
+            cout << "Callbacks didn't all run." << endl;
+            return false;
+        }
+    }
+    if (!ok)
+        cout << "Callbacks in one queue overlapped or ran out of order." << endl;
+    return ok;
+}
+
+// A callback blocked in one queue doesn't stop the others.
+bool testQueuesRunInParallel()
+{
+    std::atomic<bool> other_ran(false);
+    std::atomic<bool> blocked_finished(false);
+    CallbackDispatcher dispatcher(2, 2, 10);
+    dispatcher.post(0, [&]() { waitFor(other_ran); blocked_finished = true; });
+    dispatcher.post(1, [&]() { other_ran = true; });
+    if (!waitFor(blocked_finished)) {
+        cout << "A blocked queue held up another queue." << endl;
+        return false;
+    }
+    return true;
+}
+
+// A full queue drops callbacks straight away rather than holding up the thread that posts them.
+bool testBoundedQueue()
+{
+    const int max_queued = 5;
+    std::atomic<bool> release(false);
+    std::atomic<int> num_run(0);
+    CallbackDispatcher dispatcher(1, 1, max_queued);
+    const ptime start = microsec_clock::universal_time();
+    int num_accepted = 0;
+    for (int i = 0; i < 100; i++) {
+        if (dispatcher.post(0, [&]() { waitFor(release); num_run++; }))
+            num_accepted++;
+    }
+    const time_duration posting_time = microsec_clock::universal_time() - start;
+    release = true;
+    if (num_accepted != max_queued || dispatcher.getDroppedCount(0) != 100 - max_queued) {
+        cout << "Accepted " << num_accepted << " callbacks and dropped " << dispatcher.getDroppedCount(0) << endl;
+        return false;
+    }
+    if (posting_time > seconds(1)) {
+        cout << "Posting to a full queue took " << posting_time << endl;
+        return false;
+    }
+
+    // Once there is room again, callbacks are accepted.
+    std::atomic<bool> done(false);
+    const ptime deadline = microsec_clock::universal_time() + seconds(5);
+    while (!dispatcher.post(0, [&]() { done = true; }) && microsec_clock::universal_time() < deadline)
+        boost::this_thread::sleep(milliseconds(1));
+    if (!waitFor(done) || num_run != max_queued) {
+        cout << "Queue didn't recover once it had room." << endl;
+        return false;
+    }
+    return true;
+}
+
+// An exception thrown by a callback doesn't stop the ones after it.
+bool testExceptions()
+{
+    std::atomic<bool> done(false);
+    CallbackDispatcher dispatcher(1, 1, 10);
+    dispatcher.post(0, []() { throw std::runtime_error("Deliberate failure"); });
+    dispatcher.post(0, [&]() { done = true; });
+    if (!waitFor(done)) {
+        cout << "A callback that threw stopped the next one running." << endl;
+        return false;
+    }
+    return true;
+}
+
+// Stopping waits for a running callback, however long it takes, rather than leaving it running.
+bool testStopWaitsForCallbacks()
+{
+    std::atomic<bool> started(false);
+    std::atomic<bool> finished(false);
+    CallbackDispatcher dispatcher(2, 1, 10);
+    dispatcher.post(0, [&]() { started = true; boost::this_thread::sleep(milliseconds(1500)); finished = true; });
+    if (!waitFor(started)) {
+        cout << "Callback didn't start." << endl;
+        return false;
+    }
+    dispatcher.stop();
+    if (!finished) {
+        cout << "Stopping didn't wait for the running callback." << endl;
+        return false;
+    }
+    return true;
+}
+
+// A callback can stop, and let go of, the dispatcher it is running on - as when it sets new callback threads.
+bool testStopFromCallback()
+{
+    std::atomic<bool> done(false);
+    boost::shared_ptr<CallbackDispatcher> dispatcher(new CallbackDispatcher(2, 1, 10));
+    boost::shared_ptr<CallbackDispatcher>* current = &dispatcher;
+    {
+        // (Posting through a copy of our own, as the agent host does, since the callback may let go of the dispatcher before post returns.)
+        boost::shared_ptr<CallbackDispatcher> poster = dispatcher;
+        poster->post(0, [current, &done]() {
+            boost::shared_ptr<CallbackDispatcher> replaced;
+            replaced.swap(*current);
+            replaced->stop();
+            replaced.reset();
+            done = true;
+        });
+    }
+    if (!waitFor(done)) {
+        cout << "A callback couldn't stop its own dispatcher." << endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    if (!testOrder() || !testQueuesRunInParallel() || !testBoundedQueue() || !testExceptions())
+        return EXIT_FAILURE;
+    if (!testStopWaitsForCallbacks() || !testStopFromCallback())
+        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
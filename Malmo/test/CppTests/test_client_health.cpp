@@ -0,0 +1,185 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <ClientPool.h>
+#include <TCPClient.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+ShortReply reply(double elapsed_ms, const string& text)
+{
+    ShortReply result;
+    result.ok = true;
+    result.elapsed_ms = elapsed_ms;
+    result.reply = text;
+    return result;
+}
+
+bool checkOrder(const ClientPool& pool, const vector<int>& expected_ports, const char* what)
+{
+    const vector<ClientInfo> ordered = pool.getClientsByReadiness();
+    bool ok = ordered.size() == expected_ports.size();
+    for (size_t i = 0; ok && i < ordered.size(); i++)
+        ok = ordered[i].control_port == expected_ports[i];
+    if (!ok) {
+        cout << what << ": got";
+        for (const ClientInfo& client : ordered)
+            cout << " " << client.control_port << " (" << pool.getClientRecord(client) << ")";
+        cout << endl;
+    }
+    return ok;
+}
+
+int main()
+{
+    const ClientInfo a("127.0.0.1", 10001), b("127.0.0.1", 10002), c("127.0.0.1", 10003);
+    ClientPool pool;
+    pool.add(a);
+    pool.add(b);
+    pool.add(c);
+    bool ok = true;
+
+    ok &= checkOrder(pool, { 10001, 10002, 10003 }, "Nothing seen");
+
+    // Quicker clients first, and clients not seen yet before both.
+    pool.health->recordExchange(a, reply(50, "MALMOOK"), ClientHealth::REQUEST);
+    pool.health->recordExchange(b, reply(10, "MALMOOK"), ClientHealth::REQUEST);
+    ok &= checkOrder(pool, { 10003, 10002, 10001 }, "By latency");
+
+    // A busy reply, or a failure, puts a client behind the others - until it answers again.
+    pool.health->recordExchange(b, reply(10, "MALMOBUSY"), ClientHealth::REQUEST);
+    ok &= checkOrder(pool, { 10003, 10001, 10002 }, "After a busy reply");
+    pool.health->recordExchange(c, ShortReply(), ClientHealth::REQUEST);
+    ok &= checkOrder(pool, { 10001, 10002, 10003 }, "After a failure");
+    for (int i = 0; i < 10; i++)
+        pool.health->recordExchange(c, reply(1, "MALMOOK"), ClientHealth::REQUEST);
+    ok &= checkOrder(pool, { 10003, 10001, 10002 }, "After answering again");
+
+    // Copies of the pool share the records; among equals, the client that gets through missions faster goes first.
+    ClientPool copy = pool;
+    ClientPool twins;
+    twins.health = pool.health;
+    const ClientInfo d("127.0.0.1", 10004), e("127.0.0.1", 10005);
+    twins.add(d);
+    twins.add(e);
+    copy.health->recordExchange(d, reply(20, "MALMOOK"), ClientHealth::REQUEST);
+    copy.health->recordExchange(e, reply(20, "MALMOOK"), ClientHealth::REQUEST);
+    copy.health->recordMissionEnded(d, 60);
+    copy.health->recordMissionEnded(e, 30);
+    ok &= checkOrder(twins, { 10005, 10004 }, "By missions per hour");
+    if (pool.getClientRecord(e).missions_completed != 1 || pool.getClientRecord(e).getMissionsPerHour() != 120) {
+        cout << "Expected one 30s mission: " << pool.getClientRecord(e) << endl;
+        ok = false;
+    }
+
+    // Connecting and answering are timed apart, and the time a client takes over a MissionInit isn't held against it.
+    ClientPool offered;
+    const ClientInfo f("127.0.0.1", 10006), g("127.0.0.1", 10007);
+    offered.add(f);
+    offered.add(g);
+    offered.health->recordExchange(f, reply(5, ""), ClientHealth::CONNECT);
+    offered.health->recordExchange(g, reply(5, ""), ClientHealth::CONNECT);
+    offered.health->recordExchange(f, reply(20, "MALMOOK"), ClientHealth::REQUEST);
+    offered.health->recordExchange(g, reply(20, "MALMOOK"), ClientHealth::REQUEST);
+    offered.health->recordExchange(f, reply(3000, "MALMOOK"), ClientHealth::MISSION_INIT);
+    const ClientRecord f_record = offered.getClientRecord(f);
+    if (f_record.connects != 1 || f_record.connect_ms != 5 || f_record.replies != 1 || f_record.reply_ms != 20) {
+        cout << "Expected one 5ms connect and one 20ms reply: " << f_record << endl;
+        ok = false;
+    }
+    ok &= checkOrder(offered, { 10006, 10007 }, "After a MissionInit");
+
+    // Background probes connect to each client every so often.
+    boost::asio::io_service io_service;
+    boost::asio::ip::tcp::acceptor listening(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+    int dead_port;
+    {
+        boost::asio::ip::tcp::acceptor unused(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), 0));
+        dead_port = unused.local_endpoint().port();
+    }
+    const ClientInfo live("127.0.0.1", listening.local_endpoint().port()), dead("127.0.0.1", dead_port);
+    ClientPool probed;
+    probed.add(live);
+    probed.add(dead);
+    probed.startHealthProbes(50, 500);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(500));
+    probed.stopHealthProbes();
+    const ClientRecord live_record = probed.getClientRecord(live);
+    const ClientRecord dead_record = probed.getClientRecord(dead);
+    if (live_record.connects < 2 || live_record.recent_failures != 0 || dead_record.connects != 0 || dead_record.recent_failures < 2) {
+        cout << "Probes: " << live_record << "; " << dead_record << endl;
+        ok = false;
+    }
+    ok &= checkOrder(probed, { live.control_port, dead.control_port }, "After probes");
+
+    // The probes belong to the pool object that started them: a copy can't stop them, but destroying the owner does.
+    {
+        ClientPool owner;
+        owner.add(live);
+        owner.startHealthProbes(20, 500);
+        {
+            ClientPool copy = owner;
+            copy.stopHealthProbes();
+        }
+        const int connects_before = owner.getClientRecord(live).connects;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+        if (owner.getClientRecord(live).connects <= connects_before) {
+            cout << "A copy of the pool stopped the probes it didn't start." << endl;
+            ok = false;
+        }
+        probed = owner;
+    }
+    const int connects_after_owner = probed.getClientRecord(live).connects;
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    if (probed.getClientRecord(live).connects != connects_after_owner) {
+        cout << "The probes outlived the pool that started them." << endl;
+        ok = false;
+    }
+
+    // Copies sharing the records can start and stop probes from several threads at once.
+    {
+        ClientPool shared;
+        shared.add(live);
+        boost::thread_group threads;
+        for (int t = 0; t < 4; t++) {
+            threads.create_thread([shared]() {
+                ClientPool copy = shared;
+                for (int i = 0; i < 20; i++) {
+                    copy.startHealthProbes(10, 100);
+                    copy.stopHealthProbes();
+                }
+                copy.startHealthProbes(10, 100);
+            });
+        }
+        threads.join_all();
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
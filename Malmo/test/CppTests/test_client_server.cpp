@@ -37,7 +37,7 @@ const std::vector<unsigned char> expected_data = ToVector("hello from test_clien
 
 void onMessageReceived( TimestampedUnsignedCharVector message )
 {
-	if (message.data != expected_data)
+	if (*message.data != expected_data)
         exit( EXIT_FAILURE );
     num_messages_received++;
 }
@@ -0,0 +1,164 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <ControlConnectionPool.h>
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <istream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace malmo;
+using boost::asio::ip::tcp;
+
+// Behaves like the Mod's mission control port: takes one connection at a time, and replies to each line with "OK:" and the line,
+// prefixed with its length. Closes the connection after a reply if told to, as a restarted client would.
+std::atomic<int> connections_accepted(0);
+std::atomic<bool> close_after_reply(false);
+std::atomic<bool> stopping(false);
+
+void serve( tcp::acceptor& acceptor )
+{
+    while( !stopping ) {
+        tcp::socket socket( acceptor.get_executor() );
+        boost::system::error_code ec;
+        acceptor.accept( socket, ec );
+        if( ec || stopping )
+            return;
+        connections_accepted++;
+        boost::asio::streambuf buffer;
+        while( boost::asio::read_until( socket, buffer, '\n', ec ) ) {
+            std::istream stream( &buffer );
+            std::string line;
+            std::getline( stream, line );
+            const std::string reply = "OK:" + line;
+            const uint32_t size_header = htonl( (uint32_t)reply.size() );
+            boost::asio::write( socket, boost::asio::buffer( &size_header, sizeof( size_header ) ), ec );
+            boost::asio::write( socket, boost::asio::buffer( reply ), ec );
+            if( close_after_reply ) {
+                socket.close( ec );
+                break;
+            }
+        }
+    }
+}
+
+bool expectReply( const ShortReply& reply, const std::string& expected )
+{
+    if( !reply.ok || reply.reply != expected ) {
+        std::cout << "Expected " << expected << ", got " << reply.reply << " (" << reply.error << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    boost::asio::io_service io_service;
+    tcp::acceptor acceptor( io_service, tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) );
+    const int port = acceptor.local_endpoint().port();
+    boost::thread server( serve, boost::ref( acceptor ) );
+
+    ControlConnectionPool pool;
+
+    std::cout << "Reusing one connection.." << std::endl;
+    for( int i = 0; i < 10; i++ ) {
+        if( !expectReply( pool.exchange( "127.0.0.1", port, "hello " + std::to_string( i ) + "\n", false, 5000, 5000 ), "OK:hello " + std::to_string( i ) ) )
+            return EXIT_FAILURE;
+    }
+    if( connections_accepted != 1 || pool.getNumberOfConnections() != 1 )
+        return EXIT_FAILURE;
+
+    std::cout << "Pipelining.." << std::endl;
+    std::vector< std::pair<std::string, int> > endpoints( 4, std::make_pair( std::string( "127.0.0.1" ), port ) );
+    std::vector<std::string> messages = { "a\n", "b\n", "", "c\n" };
+    std::vector<ShortReply> replies = pool.exchange( endpoints, messages, false, 5000, 5000 );
+    if( !expectReply( replies[0], "OK:a" ) || !expectReply( replies[1], "OK:b" ) || !expectReply( replies[2], "" ) || !expectReply( replies[3], "OK:c" ) )
+        return EXIT_FAILURE;
+    if( connections_accepted != 1 )
+        return EXIT_FAILURE;
+
+    std::cout << "Reconnecting.." << std::endl;
+    close_after_reply = true;
+    if( !expectReply( pool.exchange( "127.0.0.1", port, "closing\n", false, 5000, 5000 ), "OK:closing" ) )
+        return EXIT_FAILURE;
+    boost::this_thread::sleep( boost::posix_time::milliseconds( 100 ) );   // let the close arrive
+    close_after_reply = false;
+    if( !expectReply( pool.exchange( "127.0.0.1", port, "again\n", false, 5000, 5000 ), "OK:again" ) )
+        return EXIT_FAILURE;
+    if( connections_accepted != 2 || pool.getNumberOfConnections() != 1 )
+        return EXIT_FAILURE;
+
+    std::cout << "Failing fast.." << std::endl;
+    int dead_port;
+    {
+        tcp::acceptor unused( io_service, tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) );
+        dead_port = unused.local_endpoint().port();
+    }
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    const ShortReply dead = pool.exchange( "127.0.0.1", dead_port, "hello\n", false, 5000, 5000 );
+    if( dead.ok || dead.timed_out || dead.error.empty() || boost::posix_time::microsec_clock::universal_time() - start > boost::posix_time::seconds( 2 ) )
+        return EXIT_FAILURE;
+    if( pool.getNumberOfConnections() != 1 )
+        return EXIT_FAILURE;
+
+    std::cout << "Timing out.." << std::endl;
+    {
+        // (connections to a listening socket complete without being accepted, but nothing will ever reply)
+        tcp::acceptor silent( io_service, tcp::endpoint( boost::asio::ip::address_v4::loopback(), 0 ) );
+        const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        const ShortReply silence = pool.exchange( "127.0.0.1", silent.local_endpoint().port(), "hello\n", false, 5000, 200 );
+        const boost::posix_time::time_duration taken = boost::posix_time::microsec_clock::universal_time() - start;
+        if( silence.ok || !silence.timed_out || silence.error.find( "reply" ) == std::string::npos ) {
+            std::cout << "Expected a reply timeout, got: " << silence.error << std::endl;
+            return EXIT_FAILURE;
+        }
+        if( taken < boost::posix_time::milliseconds( 190 ) || taken > boost::posix_time::seconds( 2 ) ) {
+            std::cout << "Took " << taken.total_milliseconds() << "ms." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if( pool.getNumberOfConnections() != 1 )
+        return EXIT_FAILURE;
+
+    std::cout << "Closing.." << std::endl;
+    pool.close();
+    if( pool.getNumberOfConnections() != 0 )
+        return EXIT_FAILURE;
+
+    // wake the server from accept so it can see it's stopping
+    stopping = true;
+    {
+        tcp::socket socket( io_service );
+        boost::system::error_code ec;
+        socket.connect( tcp::endpoint( boost::asio::ip::address_v4::loopback(), port ), ec );
+    }
+    server.join();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <FrameAligner.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+const ptime start = microsec_clock::universal_time();
+
+boost::shared_ptr<TimestampedVideoFrame> makeFrame(TimestampedVideoFrame::FrameType frametype, int tick, int arrival_ms)
+{
+    boost::shared_ptr<TimestampedVideoFrame> frame = boost::make_shared<TimestampedVideoFrame>();
+    frame->frametype = frametype;
+    frame->timestamp = start + milliseconds(arrival_ms);
+    frame->xPos = static_cast<float>(tick);     // the player moves one block each tick
+    frame->yaw = 90.0f;
+    return frame;
+}
+
+int main()
+{
+    FrameAligner aligner(milliseconds(20));
+    aligner.expect(TimestampedVideoFrame::VIDEO);
+    aligner.expect(TimestampedVideoFrame::DEPTH_MAP);
+    aligner.expect(TimestampedVideoFrame::LUMINANCE);
+    vector< boost::shared_ptr<FrameBundle> > ready;
+
+    // Tick 0 arrives in full, in any order:
+    aligner.add(makeFrame(TimestampedVideoFrame::DEPTH_MAP, 0, 0), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::VIDEO, 0, 2), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::COLOUR_MAP, 0, 3), ready);     // not expected - ignored
+    if (!ready.empty()) {
+        cout << "Bundle released before it was complete." << endl;
+        return EXIT_FAILURE;
+    }
+    aligner.add(makeFrame(TimestampedVideoFrame::LUMINANCE, 0, 5), ready);
+    if (ready.size() != 1 || !ready[0]->is_complete || ready[0]->getNumberOfFrames() != 3 || ready[0]->hasFrame(TimestampedVideoFrame::COLOUR_MAP) || ready[0]->getFrame(TimestampedVideoFrame::VIDEO)->timestamp != start + milliseconds(2)) {
+        cout << "Expected one complete bundle for tick 0." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Tick 1 loses its luminance frame; tick 2 arrives before tick 1 has timed out, and the pose tells them apart:
+    ready.clear();
+    aligner.add(makeFrame(TimestampedVideoFrame::VIDEO, 1, 50), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::DEPTH_MAP, 1, 51), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::LUMINANCE, 2, 60), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::VIDEO, 2, 61), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::DEPTH_MAP, 2, 62), ready);
+    if (ready.size() != 2 || ready[0]->is_complete || ready[0]->xPos != 1.0f || ready[0]->hasFrame(TimestampedVideoFrame::LUMINANCE) || !ready[1]->is_complete || ready[1]->xPos != 2.0f) {
+        cout << "Expected an incomplete bundle for tick 1, then a complete one for tick 2." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // A bundle that is still waiting when a much later frame arrives is given up on:
+    ready.clear();
+    aligner.add(makeFrame(TimestampedVideoFrame::VIDEO, 3, 100), ready);
+    aligner.add(makeFrame(TimestampedVideoFrame::VIDEO, 4, 200), ready);
+    if (ready.size() != 1 || ready[0]->is_complete || ready[0]->xPos != 3.0f) {
+        cout << "Expected tick 3 to time out." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Flushing gives up on whatever is left:
+    ready.clear();
+    aligner.flush(ready);
+    if (ready.size() != 1 || ready[0]->xPos != 4.0f || aligner.getNumberOfIncompleteBundles() != 3) {
+        cout << "Expected flush to release tick 4, making three incomplete bundles in all." << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
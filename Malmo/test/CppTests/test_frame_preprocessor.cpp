@@ -0,0 +1,152 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <FramePreprocessor.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+const int width = 8;
+const int height = 4;
+const int channels = 3;
+
+unsigned char sourceValue(int x, int y, int c) { return static_cast<unsigned char>(x * 20 + y * 5 + c); }
+
+TimestampedVideoFrame makeFrame()
+{
+    vector<unsigned char> buffer(TimestampedVideoFrame::FRAME_HEADER_SIZE + width * height * channels);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < channels; c++)
+                buffer[TimestampedVideoFrame::FRAME_HEADER_SIZE + (y * width + x) * channels + c] = sourceValue(x, y, c);
+    return TimestampedVideoFrame(width, height, channels, TimestampedUnsignedCharVector(microsec_clock::universal_time(), buffer));
+}
+
+float floatAt(const TimestampedVideoFrame& frame, size_t i)
+{
+    float f;
+    memcpy(&f, &frame.getPixels()[i * sizeof(float)], sizeof(float));
+    return f;
+}
+
+int main()
+{
+    const TimestampedVideoFrame frame = makeFrame();
+    TimestampedVideoFrame out;
+
+    // An empty preprocessor does nothing:
+    FramePreprocessor identity;
+    if (!identity.isIdentity()) {
+        cout << "Default preprocessor should be the identity." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Crop then halve with area averaging - each output pixel is the mean of a 2x2 block:
+    FramePreprocessor shrink;
+    shrink.crop(2, 0, 4, 4);
+    shrink.resize(2, 2);
+    shrink.prepare(width, height, channels);
+    shrink.apply(frame, out);
+    if (out.width != 2 || out.height != 2 || out.channels != channels || out.channels_first || out.float_pixels || out.getPixels().size() != 2 * 2 * channels) {
+        cout << "Unexpected shape after crop and resize." << endl;
+        return EXIT_FAILURE;
+    }
+    for (int y = 0; y < 2; y++)
+        for (int x = 0; x < 2; x++)
+            for (int c = 0; c < channels; c++) {
+                const int sx = 2 + x * 2, sy = y * 2;
+                const int mean = (sourceValue(sx, sy, c) + sourceValue(sx + 1, sy, c) + sourceValue(sx, sy + 1, c) + sourceValue(sx + 1, sy + 1, c) + 2) / 4;
+                if (out.getPixels()[(y * 2 + x) * channels + c] != mean || out.getView().getValue(x, y, c) != mean) {
+                    cout << "Area average mismatch at " << x << "," << y << "," << c << endl;
+                    return EXIT_FAILURE;
+                }
+            }
+
+    // Bilinear doubling of a column: output pixels 1 and 2 fall a quarter of the way between source pixels 0 and 1:
+    FramePreprocessor enlarge;
+    enlarge.crop(0, 0, 2, 1);
+    enlarge.resize(4, 1, FramePreprocessor::BILINEAR);
+    enlarge.prepare(width, height, channels);
+    enlarge.apply(frame, out);
+    const float left = sourceValue(0, 0, 0), right = sourceValue(1, 0, 0);
+    if (out.getPixels()[0] != left || out.getPixels()[3 * channels] != right
+        || out.getPixels()[channels] != static_cast<int>(0.75f * left + 0.25f * right + 0.5f)
+        || out.getPixels()[2 * channels] != static_cast<int>(0.25f * left + 0.75f * right + 0.5f)) {
+        cout << "Bilinear interpolation mismatch." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Grayscale, channels-first, float - the output is a single plane of scaled luma values:
+    FramePreprocessor luma;
+    luma.convertToGrayscale();
+    luma.reorderToChannelsFirst();
+    luma.convertToFloat();
+    luma.prepare(width, height, channels);
+    luma.apply(frame, out);
+    if (out.channels != 1 || !out.channels_first || !out.float_pixels || out.getPixels().size() != width * height * sizeof(float) || !out.getView().empty()) {
+        cout << "Unexpected shape after grayscale conversion." << endl;
+        return EXIT_FAILURE;
+    }
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++) {
+            const float expected = (0.299f * sourceValue(x, y, 0) + 0.587f * sourceValue(x, y, 1) + 0.114f * sourceValue(x, y, 2)) / 255.0f;
+            if (fabs(floatAt(out, y * width + x) - expected) > 1e-5f) {
+                cout << "Luma mismatch at " << x << "," << y << endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+    // Channels-first keeps each colour plane together:
+    FramePreprocessor planar;
+    planar.reorderToChannelsFirst();
+    planar.prepare(width, height, channels);
+    planar.apply(frame, out);
+    for (int c = 0; c < channels; c++)
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (out.getPixels()[(c * height + y) * width + x] != sourceValue(x, y, c)) {
+                    cout << "Planar mismatch at " << x << "," << y << "," << c << endl;
+                    return EXIT_FAILURE;
+                }
+
+    // A crop that doesn't fit should be rejected up front:
+    FramePreprocessor bad;
+    bad.crop(6, 0, 4, 4);
+    try {
+        bad.prepare(width, height, channels);
+        cout << "Expected an exception for an out-of-bounds crop." << endl;
+        return EXIT_FAILURE;
+    }
+    catch (const invalid_argument&) {
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <FrameStack.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+const int width = 4;
+const int height = 2;
+const int channels = 3;
+const int depth = 3;
+
+// Every value in frame n is tagged with n, so we can tell which frame ended up in which slot.
+unsigned char value(int n, int x, int y, int c) { return static_cast<unsigned char>(n * 64 + (y * width + x) * channels + c); }
+
+TimestampedVideoFrame makeFrame(int n, TimestampedVideoFrame::Transform transform = TimestampedVideoFrame::IDENTITY)
+{
+    vector<unsigned char> buffer(TimestampedVideoFrame::FRAME_HEADER_SIZE + width * height * channels);
+    for (int y = 0; y < height; y++) {
+        const int row = transform == TimestampedVideoFrame::REVERSE_SCANLINE ? height - 1 - y : y;
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < channels; c++)
+                buffer[TimestampedVideoFrame::FRAME_HEADER_SIZE + (row * width + x) * channels + c] = value(n, x, y, c);
+    }
+    return TimestampedVideoFrame(width, height, channels, TimestampedUnsignedCharVector(microsec_clock::universal_time() + seconds(n), buffer), transform);
+}
+
+bool slotHoldsFrame(const FrameStack& stack, int slot, int n)
+{
+    const vector<unsigned char>& data = stack.getData();
+    for (int c = 0; c < channels; c++)
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                if (data[slot * stack.getFrameSize() + (c * height + y) * width + x] != value(n, x, y, c))
+                    return false;
+    return true;
+}
+
+int main()
+{
+    FrameStack stack(depth);
+    if (stack.getDepth() != depth || stack.getCount() != 0 || !stack.getData().empty()) {
+        cout << "New stack should be empty." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Push more frames than fit - the stack should end up holding the last three, CHW, in rotating slots:
+    for (int n = 0; n < 5; n++)
+        stack.push(makeFrame(n));
+    if (stack.getCount() != depth || stack.getData().size() != depth * width * height * channels || stack.getFrameSize() != width * height * channels) {
+        cout << "Unexpected stack size." << endl;
+        return EXIT_FAILURE;
+    }
+    for (int age = 0; age < depth; age++) {
+        const int n = 4 - age;
+        if (!slotHoldsFrame(stack, stack.getSlot(age), n)) {
+            cout << "Slot for age " << age << " doesn't hold frame " << n << endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (stack.getNewestSlot() != 1 || stack.getTimestamp(stack.getSlot(0)) <= stack.getTimestamp(stack.getSlot(1))) {
+        cout << "Newest slot should be 1, with the latest timestamp." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // A snapshot keeps its contents when the original moves on:
+    const FrameStack snapshot = stack;
+    stack.push(makeFrame(5));
+    if (!slotHoldsFrame(snapshot, snapshot.getSlot(0), 4) || !slotHoldsFrame(stack, stack.getSlot(0), 5) || &snapshot.getData() == &stack.getData()) {
+        cout << "Snapshot was changed by a push." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Taking a snapshot after every frame, as an agent does, the stack takes turns between two buffers rather than copying itself each time:
+    FrameStack taking_turns(depth);
+    FrameStack held;
+    vector<const vector<unsigned char>*> buffers;
+    for (int n = 0; n < 6; n++) {
+        taking_turns.push(makeFrame(n));
+        held = taking_turns;
+        buffers.push_back(&taking_turns.getData());
+        for (int age = 0; age < held.getCount(); age++) {
+            if (!slotHoldsFrame(held, held.getSlot(age), n - age)) {
+                cout << "After frame " << n << ", the snapshot's slot for age " << age << " doesn't hold frame " << n - age << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        if (n >= 3 && (buffers[n] != buffers[n - 2] || buffers[n] == buffers[n - 1])) {
+            cout << "Expected the stack to take turns between two buffers." << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // A frame that is still upside down is read the right way up:
+    stack.push(makeFrame(8, TimestampedVideoFrame::REVERSE_SCANLINE));
+    if (!slotHoldsFrame(stack, stack.getNewestSlot(), 8)) {
+        cout << "Upside-down frame wasn't turned the right way up." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // A reset empties the stack and zeroes the slots:
+    stack.reset();
+    if (stack.getCount() != 0 || stack.getData().size() != depth * stack.getFrameSize() || stack.getData()[0] != 0 || !stack.getTimestamp(0).is_not_a_date_time()) {
+        cout << "Reset should clear the stack." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Putting frames in given slots leaves the newest index and the count alone:
+    stack.put(2, makeFrame(7));
+    stack.put(0, makeFrame(6));
+    if (!slotHoldsFrame(stack, 0, 6) || !slotHoldsFrame(stack, 2, 7) || stack.getData()[stack.getFrameSize()] != 0 || stack.getCount() != 0 || !stack.getTimestamp(1).is_not_a_date_time()) {
+        cout << "Put frames should be in their own slots only." << endl;
+        return EXIT_FAILURE;
+    }
+    stack.reset();
+
+    try {
+        stack.getSlot(depth);
+        cout << "Expected an exception for an age beyond the stack." << endl;
+        return EXIT_FAILURE;
+    }
+    catch (const out_of_range&) {
+    }
+
+    try {
+        stack.put(depth, makeFrame(0));
+        cout << "Expected an exception for a slot beyond the stack." << endl;
+        return EXIT_FAILURE;
+    }
+    catch (const out_of_range&) {
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,116 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <FrameTransforms.h>
+using namespace malmo;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+// Check every instruction set this CPU supports against the scalar path, for awkward sizes that exercise the tails.
+bool checkSwapRedBlue(SimdLevel level, int channels, size_t num_pixels)
+{
+    vector<unsigned char> input(num_pixels * channels);
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<unsigned char>(rand());
+
+    vector<unsigned char> expected(input), actual(input);
+    setSimdLevel(SIMD_NONE);
+    swapRedBlue(expected.empty() ? 0 : &expected[0], num_pixels, channels);
+    setSimdLevel(level);
+    swapRedBlue(actual.empty() ? 0 : &actual[0], num_pixels, channels);
+
+    if (actual != expected) {
+        cout << "swapRedBlue mismatch: level " << level << ", " << channels << " channels, " << num_pixels << " pixels" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool checkDeinterleave(SimdLevel level, int channels, size_t num_pixels)
+{
+    vector<unsigned char> input(num_pixels * channels);
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<unsigned char>(rand());
+
+    vector<unsigned char> expected(input.size()), actual(input.size());
+    for (size_t i = 0; i < num_pixels; i++)
+        for (int c = 0; c < channels; c++)
+            expected[c * num_pixels + i] = input[i * channels + c];
+
+    setSimdLevel(level);
+    if (!input.empty())
+        deinterleaveChannels(&input[0], &actual[0], num_pixels, channels);
+
+    if (actual != expected) {
+        cout << "deinterleaveChannels mismatch: level " << level << ", " << channels << " channels, " << num_pixels << " pixels" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool checkFlip(size_t row_bytes, size_t rows)
+{
+    vector<unsigned char> input(row_bytes * rows), actual(row_bytes * rows);
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<unsigned char>(rand());
+
+    if (!input.empty())
+        flipScanlines(&input[0], &actual[0], row_bytes, rows);
+
+    for (size_t y = 0; y < rows; y++)
+        for (size_t x = 0; x < row_bytes; x++)
+            if (actual[y * row_bytes + x] != input[(rows - 1 - y) * row_bytes + x]) {
+                cout << "flipScanlines mismatch: " << row_bytes << " x " << rows << endl;
+                return false;
+            }
+    return true;
+}
+
+int main()
+{
+    const SimdLevel best = getSimdLevel();
+    cout << "Best SIMD level: " << best << endl;
+
+    const SimdLevel levels[] = { SIMD_NONE, SIMD_SSE2, SIMD_SSSE3, SIMD_AVX2, SIMD_NEON };
+    const size_t sizes[] = { 0, 1, 4, 5, 9, 10, 11, 15, 16, 17, 31, 32, 33, 63, 100, 320 * 240, 1920 * 1080 + 7 };
+    const int channel_counts[] = { 1, 3, 4 };
+
+    for (SimdLevel level : levels) {
+        if (!setSimdLevel(level))
+            continue;
+        for (int channels : channel_counts)
+            for (size_t num_pixels : sizes)
+                if (!checkSwapRedBlue(level, channels, num_pixels) || !checkDeinterleave(level, channels, num_pixels))
+                    return EXIT_FAILURE;
+    }
+
+    setSimdLevel(best);
+    if (getSimdLevel() != best)
+        return EXIT_FAILURE;
+
+    if (!checkFlip(0, 0) || !checkFlip(3, 1) || !checkFlip(320 * 3, 240) || !checkFlip(1920 * 4, 1080))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
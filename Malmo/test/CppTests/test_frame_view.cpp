@@ -0,0 +1,118 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <TimestampedVideoFrame.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+using namespace std;
+
+const int width = 7;
+const int height = 5;
+const int channels = 3;
+
+// Each byte of the message identifies its own row, column and channel, bottom row first as the Mod sends it.
+unsigned char sentValue(int x, int y, int c) { return static_cast<unsigned char>(((height - 1 - y) * 16 + x) * 4 + c); }
+
+TimestampedUnsignedCharVector makeMessage()
+{
+    vector<unsigned char> buffer(TimestampedVideoFrame::FRAME_HEADER_SIZE + width * height * channels);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < channels; c++)
+                buffer[TimestampedVideoFrame::FRAME_HEADER_SIZE + ((height - 1 - y) * width + x) * channels + c] = sentValue(x, y, c);
+    return TimestampedUnsignedCharVector(microsec_clock::universal_time(), buffer);
+}
+
+int main()
+{
+    TimestampedVideoFrame frame(width, height, channels, makeMessage(), TimestampedVideoFrame::REVERSE_SCANLINE);
+
+    // The view should present the image top row first, without having packed anything:
+    FrameView view = frame.getView();
+    if (view.getWidth() != width || view.getHeight() != height || view.getRowStride() != -width * channels || view.isPacked()) {
+        cout << "Unexpected view layout." << endl;
+        return EXIT_FAILURE;
+    }
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < channels; c++)
+                if (view.getValue(x, y, c) != sentValue(x, y, c)) {
+                    cout << "View value mismatch at " << x << "," << y << "," << c << endl;
+                    return EXIT_FAILURE;
+                }
+
+    // Packed pixels should match the view:
+    const vector<unsigned char>& pixels = frame.getPixels();
+    if (pixels != view.packed() || pixels.size() != width * height * channels) {
+        cout << "Packed pixels don't match the view." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Crops and subsamples are just views onto the same buffer:
+    FrameView cropped = view.crop(2, 1, 3, 2);
+    FrameView subsampled = view.subsample(2);
+    if (cropped.getValue(0, 0, 1) != sentValue(2, 1, 1) || cropped.getValue(2, 1, 2) != sentValue(4, 2, 2)) {
+        cout << "Crop mismatch." << endl;
+        return EXIT_FAILURE;
+    }
+    if (subsampled.getWidth() != 4 || subsampled.getHeight() != 3 || subsampled.getValue(3, 2, 0) != sentValue(6, 4, 0)) {
+        cout << "Subsample mismatch." << endl;
+        return EXIT_FAILURE;
+    }
+    vector<unsigned char> packed_crop = cropped.packed();
+    if (packed_crop.size() != 3 * 2 * channels || packed_crop[channels * 3] != sentValue(2, 2, 0)) {
+        cout << "Packed crop mismatch." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Out of range access should throw:
+    try {
+        view.getValue(width, 0, 0);
+        cout << "Expected out_of_range." << endl;
+        return EXIT_FAILURE;
+    }
+    catch (const std::out_of_range&) {}
+
+    // Views and copies must survive the frame being refilled with something else:
+    TimestampedVideoFrame copy(frame);
+    vector<unsigned char> before = cropped.packed();
+    frame.assign(width, height, channels, makeMessage(), TimestampedVideoFrame::RAW_BMP);
+    if (cropped.packed() != before || copy.getPixels() != pixels || !(copy == copy)) {
+        cout << "View or copy changed when the frame was refilled." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // RAW_BMP keeps the row order but swaps blue and red:
+    if (frame.getView().getValue(1, 0, 0) != sentValue(1, height - 1, 2) || !frame.getView().isPacked()) {
+        cout << "RAW_BMP mismatch." << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
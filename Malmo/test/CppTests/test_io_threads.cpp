@@ -0,0 +1,137 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <ClientConnection.h>
+#include <TCPServer.h>
+
+// Boost:
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace malmo;
+
+const int num_servers = 3;
+const int num_connections = 2;  // per server
+const int num_threads = 4;
+const int num_messages_sent = 200;  // per connection
+const int batch_size = 7;
+
+// Per server: the next message we expect on each connection, and how many handlers are running right now.
+// (These are deliberately not protected - the server's strand should stop its handlers from overlapping.)
+int next_expected[num_servers][num_connections];
+std::atomic<int> handlers_running[num_servers];
+std::atomic<bool> failed(false);
+
+void onMessageReceived( int server, TimestampedUnsignedCharVector message )
+{
+    if (++handlers_running[server] != 1) {
+        std::cout << "Two handlers ran at once for server " << server << std::endl;
+        failed = true;
+    }
+    boost::this_thread::yield();    // give another thread the chance to barge in
+
+    const std::string text(message.data->begin(), message.data->end());
+    const int connection = text[0] - '0';
+    if (connection < 0 || connection >= num_connections || text != std::to_string(connection) + ":" + std::to_string(next_expected[server][connection]) + "\n") {
+        std::cout << "Server " << server << " got " << text << " out of order." << std::endl;
+        failed = true;
+    }
+    else
+        next_expected[server][connection]++;
+    handlers_running[server]--;
+}
+
+int main()
+{
+    boost::asio::io_service io_service;
+    std::vector< boost::shared_ptr<TCPServer> > servers;
+    for (int s = 0; s < num_servers; s++) {
+        for (int c = 0; c < num_connections; c++)
+            next_expected[s][c] = 0;
+        handlers_running[s] = 0;
+        servers.push_back(boost::make_shared<TCPServer>(io_service, 0, boost::bind(&onMessageReceived, s, _1), "test_io_threads"));
+        servers.back()->expectSizeHeader(false);
+        servers.back()->start();
+    }
+
+    boost::thread_group threads;
+    for (int i = 0; i < num_threads; i++)
+        threads.create_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+
+    const boost::posix_time::milliseconds sleep_time(100);
+    boost::this_thread::sleep( sleep_time ); // allow time for the threads and servers to start
+
+    std::cout << "Sending messages.." << std::endl;
+    std::vector< boost::shared_ptr<ClientConnection> > connections;
+    for (int s = 0; s < num_servers; s++)
+        for (int c = 0; c < num_connections; c++)
+            connections.push_back(ClientConnection::create(io_service, "127.0.0.1", servers[s]->getPort()));
+    // The first half one at a time, the rest in batches that each go out in one write:
+    for (int i = 0; i < num_messages_sent / 2; i++)
+        for (size_t k = 0; k < connections.size(); k++)
+            connections[k]->send(std::to_string(k % num_connections) + ":" + std::to_string(i));
+    for (int i = num_messages_sent / 2; i < num_messages_sent; i += batch_size) {
+        const bool last_batch = i + batch_size >= num_messages_sent;
+        if (last_batch)
+            boost::this_thread::sleep( sleep_time * 10 ); // let the connections go idle, so we can count the writes the last batch takes
+        std::vector<int> writes_before;
+        for (size_t k = 0; k < connections.size(); k++) {
+            std::vector<std::string> batch;
+            for (int j = i; j < std::min(i + batch_size, num_messages_sent); j++)
+                batch.push_back(std::to_string(k % num_connections) + ":" + std::to_string(j));
+            writes_before.push_back(connections[k]->getWritesStarted());
+            connections[k]->send(batch);
+        }
+        if (last_batch) {
+            boost::this_thread::sleep( sleep_time * 10 ); // allow time for the messages to get through
+            for (size_t k = 0; k < connections.size(); k++) {
+                const int writes = connections[k]->getWritesStarted() - writes_before[k];
+                if (writes != 1) {
+                    std::cout << "The last batch took " << writes << " writes on connection " << k << "." << std::endl;
+                    failed = true;
+                }
+            }
+        }
+    }
+
+    io_service.stop();
+    threads.join_all();
+
+    std::cout << "Exiting.." << std::endl;
+
+    for (int s = 0; s < num_servers; s++) {
+        for (int c = 0; c < num_connections; c++) {
+            if (next_expected[s][c] != num_messages_sent) {
+                std::cout << "Server " << s << " received " << next_expected[s][c] << " of " << num_messages_sent << " messages on connection " << c << "." << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <LatencyHistogram.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/thread.hpp>
+
+// STL:
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+bool check(double result, double expected, double tolerance, const char* what)
+{
+    if (std::abs(result - expected) > tolerance) {
+        cout << what << ": expected " << expected << " but got " << result << endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+
+    LatencyHistogram histogram;
+    ok &= check(histogram.getCount(), 0, 0, "Count, when empty");
+    ok &= check(histogram.getPercentileMs(50), 0, 0, "Median, when empty");
+
+    // 1ms to 100ms, one of each.
+    for (int ms = 1; ms <= 100; ms++)
+        histogram.add(boost::posix_time::milliseconds(ms));
+    ok &= check(histogram.getCount(), 100, 0, "Count");
+    ok &= check(histogram.getMeanMs(), 50.5, 1e-9, "Mean");
+    ok &= check(histogram.getMinMs(), 1, 1e-9, "Min");
+    ok &= check(histogram.getMaxMs(), 100, 1e-9, "Max");
+    // Percentiles are bucket upper bounds: no lower than the true value, and less than a bucket's width above it.
+    const double width = std::pow(2.0, 0.25);
+    for (double percentile : { 1.0, 10.0, 50.0, 90.0, 99.0 }) {
+        const double got = histogram.getPercentileMs(percentile);
+        if (got < percentile || got > percentile * width) {
+            cout << "Percentile " << percentile << ": got " << got << endl;
+            ok = false;
+        }
+    }
+    ok &= check(histogram.getPercentileMs(100), 100, 1e-9, "100th percentile");
+
+    // A copy is a snapshot; the original can be reset independently.
+    LatencyHistogram snapshot(histogram);
+    histogram.reset();
+    ok &= check(histogram.getCount(), 0, 0, "Count, after reset");
+    ok &= check(histogram.getMaxMs(), 0, 0, "Max, after reset");
+    ok &= check(snapshot.getCount(), 100, 0, "Count, of snapshot");
+
+    // Out of range latencies go in the end buckets.
+    histogram.add(boost::posix_time::microseconds(-5));
+    histogram.add(boost::posix_time::hours(1));
+    vector<int> buckets = histogram.getBucketCounts();
+    ok &= check(buckets.front(), 1, 0, "First bucket");
+    ok &= check(buckets.back(), 1, 0, "Last bucket");
+    ok &= check(histogram.getMinMs(), 0, 0, "Min, negative latency");
+
+    // Adds from several threads at once are all counted.
+    histogram.reset();
+    const int num_threads = 4;
+    const int adds_per_thread = 100000;
+    vector< boost::shared_ptr<boost::thread> > threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.push_back(boost::make_shared<boost::thread>([&histogram, t]() {
+            for (int i = 0; i < adds_per_thread; i++)
+                histogram.add(boost::posix_time::microseconds(1 + (i % 1000) * (t + 1)));
+        }));
+    }
+    for (auto& thread : threads)
+        thread->join();
+    buckets = histogram.getBucketCounts();
+    int total = 0;
+    for (int count : buckets)
+        total += count;
+    ok &= check(histogram.getCount(), num_threads * adds_per_thread, 0, "Count, after concurrent adds");
+    ok &= check(total, num_threads * adds_per_thread, 0, "Bucket total, after concurrent adds");
+    ok &= check(histogram.getMinMs(), 0.001, 1e-9, "Min, after concurrent adds");
+    ok &= check(histogram.getMaxMs(), (1 + 999 * num_threads) / 1000.0, 1e-9, "Max, after concurrent adds");
+
+    cout << snapshot << endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <ClientConnection.h>
+#include <LocalSocket.h>
+#include <StringServer.h>
+
+// Boost:
+#include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace malmo;
+
+const int num_messages_sent = 100;
+std::atomic<int> num_messages_received;
+std::atomic<bool> out_of_order;
+
+void onMessageReceived( TimestampedString message )
+{
+    std::string text = message.text;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+        text.pop_back();
+    if (text != std::to_string(num_messages_received))
+        out_of_order = true;
+    num_messages_received++;
+}
+
+// Sends messages through a ClientConnection and checks they all arrive, in order.
+bool sendAndCheck( boost::asio::io_service& io_service, int port, const std::string& local_socket )
+{
+    num_messages_received = 0;
+    out_of_order = false;
+    {
+        boost::shared_ptr<ClientConnection> connection = ClientConnection::create( io_service, "127.0.0.1", port, local_socket );
+        for (int i = 0; i < num_messages_sent; i++)
+            connection->send( std::to_string(i) );
+
+        for (int wait = 0; wait < 100 && num_messages_received < num_messages_sent; wait++)
+            boost::this_thread::sleep( boost::posix_time::milliseconds(50) );
+    }
+    if (num_messages_received != num_messages_sent || out_of_order) {
+        std::cout << "Received " << num_messages_received << " of " << num_messages_sent << " messages" << (out_of_order ? ", out of order" : "") << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool testLocalSocket( const std::string& name )
+{
+    std::cout << "Testing local socket " << name << std::endl;
+    boost::asio::io_service io_service;
+    boost::shared_ptr<boost::asio::io_service::work> work = boost::make_shared<boost::asio::io_service::work>( boost::ref(io_service) );
+    boost::thread bt( boost::bind( &boost::asio::io_service::run, &io_service ) );
+    bool ok = true;
+    {
+        StringServer server( io_service, 0, onMessageReceived, "test" );
+        server.expectSizeHeader( false );
+        server.start();
+        server.listenOnLocalSocket( name );     // (after start, as AgentHost does when it reuses a server)
+        if (server.getLocalSocket() != name) {
+            std::cout << "Server reports the wrong socket name." << std::endl;
+            ok = false;
+        }
+
+        // Only the local socket leads to the server, so everything must go that way.
+        const int wrong_port = server.getPort() == 65535 ? 65534 : server.getPort() + 1;
+        if (ok && !sendAndCheck( io_service, wrong_port, name )) {
+            std::cout << "Failed to send through the local socket." << std::endl;
+            ok = false;
+        }
+
+        // And a connection to a socket that doesn't exist should fall back to TCP.
+        if (ok && !sendAndCheck( io_service, server.getPort(), name + "_missing" )) {
+            std::cout << "Failed to fall back to TCP." << std::endl;
+            ok = false;
+        }
+    }
+    if (ok && name[0] != '@' && boost::filesystem::exists( name )) {
+        std::cout << "Socket file was left behind." << std::endl;
+        ok = false;
+    }
+
+    work.reset();
+    io_service.stop();
+    bt.join();
+    return ok;
+}
+
+int main()
+{
+    if (!IsLocalSocketSupported()) {
+        std::cout << "UNIX-domain sockets aren't supported on this platform - nothing to test." << std::endl;
+        return EXIT_SUCCESS;
+    }
+
+    // The default names (in the abstract namespace on Linux), and a socket file.
+    const std::string prefix = MakeLocalSocketPrefix();
+    if (!testLocalSocket( GetLocalSocketName( prefix, 1 ) ))
+        return EXIT_FAILURE;
+    const boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path( "malmo_%%%%%%%%.sock" );
+    if (!testLocalSocket( file.string() ))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
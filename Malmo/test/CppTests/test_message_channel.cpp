@@ -0,0 +1,427 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <MessageChannel.h>
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+// STL:
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace boost::posix_time;
+using namespace malmo;
+using namespace std;
+
+const int num_producers = 4;
+const int num_messages = 20000;     // per producer
+
+typedef pair<int, int> Message;     // (producer, sequence number)
+
+// Counts the allocations made by the whole test, so that we can check that a warmed-up channel doesn't make any.
+std::atomic<size_t> num_allocations(0);
+
+void* operator new(size_t size)
+{
+    num_allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+// (Not inlined, or GCC takes the free() for a mismatch with the new-expressions whose deletes it inlines.)
+#if defined(__GNUC__)
+__attribute__((noinline))
+#endif
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+bool testQueuedMessages()
+{
+    MessageChannel<Message> channel;
+    std::atomic<int> producers_done(0);
+    boost::thread_group producers;
+    for (int p = 0; p < num_producers; p++) {
+        producers.create_thread([&channel, &producers_done, p]() {
+            for (int i = 0; i < num_messages; i++)
+                channel.push(Message(p, i), true);
+            producers_done++;
+        });
+    }
+
+    // Each message must arrive exactly once, and each producer's messages in the order they were pushed.
+    vector<int> next_expected(num_producers, 0);
+    size_t total_counted = 0;
+    bool ok = true;
+    for (;;) {
+        const bool finished = producers_done == num_producers;    // (checked before taking, so nothing can be missed)
+        vector<Message> messages;
+        total_counted += channel.take(messages);
+        for (const auto& message : messages) {
+            if (message.second != next_expected[message.first]) {
+                cout << "Producer " << message.first << ": expected " << next_expected[message.first] << " but got " << message.second << endl;
+                ok = false;
+            }
+            next_expected[message.first] = message.second + 1;
+        }
+        if (finished)
+            break;
+    }
+    producers.join_all();
+    for (int p = 0; p < num_producers; p++) {
+        if (next_expected[p] != num_messages) {
+            cout << "Producer " << p << ": only got " << next_expected[p] << " messages." << endl;
+            ok = false;
+        }
+    }
+    if (total_counted != num_producers * num_messages) {
+        cout << "Counted " << total_counted << " messages instead of " << num_producers * num_messages << endl;
+        ok = false;
+    }
+    return ok;
+}
+
+bool testLatestMessage()
+{
+    MessageChannel<Message> channel;
+    channel.push(Message(0, 0), true);
+    channel.push(Message(0, 1), false);
+    channel.push(Message(0, 2), false);
+    channel.push(Message(0, 3), true);
+    vector<Message> messages;
+    const size_t counted = channel.take(messages);
+    // The queued messages come first, then the one that replaced the other.
+    if (counted != 4 || messages != vector<Message>{ Message(0, 0), Message(0, 3), Message(0, 2) }) {
+        cout << "Latest message was not kept correctly." << endl;
+        return false;
+    }
+    messages.clear();
+    if (channel.take(messages) != 0 || !messages.empty()) {
+        cout << "Messages were taken twice." << endl;
+        return false;
+    }
+    return true;
+}
+
+// Once the spare nodes have been made, pushing and taking (into a vector with room) doesn't allocate, queued or not.
+bool testNoAllocationsOnceWarm()
+{
+    const int num_rounds = 100;
+    const int per_round = 500;
+    MessageChannel< boost::shared_ptr<Message> > channel;
+    boost::shared_ptr<Message> message = boost::make_shared<Message>(0, 0);
+    vector< boost::shared_ptr<Message> > messages;
+    messages.reserve(per_round + 1);
+    for (int i = 0; i < per_round; i++)
+        channel.push(message, i % 2 == 0);
+    channel.take(messages);
+    messages.clear();
+
+    const size_t allocations_before = num_allocations;
+    for (int round = 0; round < num_rounds; round++) {
+        for (int i = 0; i < per_round; i++)
+            channel.push(message, i % 2 == 0);
+        channel.take(messages);
+        messages.clear();
+    }
+    const size_t allocations = num_allocations - allocations_before;
+    if (allocations != 0) {
+        cout << "A warmed-up channel made " << allocations << " allocations for " << num_rounds * per_round << " messages." << endl;
+        return false;
+    }
+    return true;
+}
+
+// A bounded channel keeps the first or the last messages, in order, and counts the rest as dropped.
+bool testLimit(bool drop_oldest)
+{
+    const int limit = 100;
+    const int num_pushed = 1000;
+    MessageChannel<Message> channel;
+    channel.setLimit(limit, drop_oldest);
+    for (int i = 0; i < num_pushed; i++)
+        channel.push(Message(0, i), true);
+    vector<Message> messages;
+    const size_t counted = channel.take(messages);
+    const size_t dropped = channel.takeDroppedCount();
+    if (counted != num_pushed || dropped != num_pushed - limit || messages.size() != limit) {
+        cout << "Limited channel counted " << counted << ", dropped " << dropped << " and kept " << messages.size() << endl;
+        return false;
+    }
+    const int first_kept = drop_oldest ? num_pushed - limit : 0;
+    for (int i = 0; i < limit; i++) {
+        if (messages[i].second != first_kept + i) {
+            cout << "Limited channel kept the wrong messages, or out of order." << endl;
+            return false;
+        }
+    }
+
+    // Once emptied, there is room again.
+    messages.clear();
+    channel.push(Message(0, num_pushed), true);
+    if (channel.take(messages) != 1 || messages.size() != 1 || channel.takeDroppedCount() != 0) {
+        cout << "Limited channel didn't make room again." << endl;
+        return false;
+    }
+    return true;
+}
+
+// With several producers, nothing is lost without being counted, and no more than the limit is ever waiting.
+bool testLimitWithProducers(bool drop_oldest)
+{
+    const int limit = 64;
+    MessageChannel<Message> channel;
+    channel.setLimit(limit, drop_oldest);
+    std::atomic<int> producers_done(0);
+    boost::thread_group producers;
+    for (int p = 0; p < num_producers; p++) {
+        producers.create_thread([&channel, &producers_done, p]() {
+            for (int i = 0; i < num_messages; i++)
+                channel.push(Message(p, i), true);
+            producers_done++;
+        });
+    }
+    vector<int> last_seen(num_producers, -1);
+    size_t total_taken = 0;
+    size_t total_counted = 0;
+    size_t total_dropped = 0;
+    bool ok = true;
+    for (;;) {
+        const bool finished = producers_done == num_producers;
+        vector<Message> messages;
+        total_counted += channel.take(messages);
+        total_dropped += channel.takeDroppedCount();
+        total_taken += messages.size();
+        if (messages.size() > static_cast<size_t>(limit)) {
+            cout << "Took " << messages.size() << " messages from a channel limited to " << limit << endl;
+            ok = false;
+        }
+        for (const auto& message : messages) {
+            if (message.second <= last_seen[message.first]) {
+                cout << "Producer " << message.first << "'s messages arrived out of order." << endl;
+                ok = false;
+            }
+            last_seen[message.first] = std::max(last_seen[message.first], message.second);
+        }
+        if (finished)
+            break;
+    }
+    producers.join_all();
+    if (total_counted != num_producers * num_messages || total_taken + total_dropped != total_counted) {
+        cout << "Counted " << total_counted << ", took " << total_taken << " and dropped " << total_dropped << endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// The limit can be changed while producers are pushing, and their messages still arrive in order.
+bool testLimitChangedWhilePushing()
+{
+    MessageChannel<Message> channel;
+    std::atomic<int> producers_done(0);
+    boost::thread_group producers;
+    for (int p = 0; p < num_producers; p++) {
+        producers.create_thread([&channel, &producers_done, p]() {
+            for (int i = 0; i < num_messages; i++)
+                channel.push(Message(p, i), true);
+            producers_done++;
+        });
+    }
+    const size_t limits[] = { 0, 16, 64, 1 };
+    vector<int> last_seen(num_producers, -1);
+    bool ok = true;
+    for (int change = 0; producers_done != num_producers; change++) {
+        channel.setLimit(limits[change % 4], change % 3 == 0);
+        vector<Message> messages;
+        channel.take(messages);
+        for (const auto& message : messages) {
+            if (message.second <= last_seen[message.first]) {
+                cout << "Producer " << message.first << "'s messages arrived out of order after the limit changed." << endl;
+                ok = false;
+            }
+            last_seen[message.first] = message.second;
+        }
+    }
+    producers.join_all();
+    return ok;
+}
+
+// One producer's messages arrive in the order it pushed them, across takes as well as within them, however the channel is bounded.
+bool testOrderAcrossTakes(size_t limit, bool drop_oldest)
+{
+    const int num_pushed = 200000;
+    MessageChannel<Message> channel;
+    channel.setLimit(limit, drop_oldest);
+    std::atomic<bool> producer_done(false);
+    boost::thread producer([&]() {
+        for (int i = 0; i < num_pushed; i++)
+            channel.push(Message(0, i), true);
+        producer_done = true;
+    });
+
+    int last_taken = -1;
+    size_t num_takes = 0;
+    bool ok = true;
+    for (;;) {
+        const bool finished = producer_done;
+        vector<Message> messages;
+        channel.take(messages);
+        num_takes++;
+        for (const auto& message : messages) {
+            if (message.second <= last_taken) {
+                cout << "With limit " << limit << (drop_oldest ? " (dropping oldest)" : "") << ", message " << message.second << " arrived after " << last_taken << " (take " << num_takes << ")" << endl;
+                ok = false;
+            }
+            last_taken = message.second;
+        }
+        if (finished)
+            break;
+    }
+    producer.join();
+    if (limit == 0 && last_taken != num_pushed - 1) {
+        cout << "The last message taken was " << last_taken << endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// What a producer sees while the consumer keeps taking copies of what has been received so far.
+struct PushTimes
+{
+    double mean_us;
+    double median_us;
+    double p99_us;
+    double p999_us;
+    double max_us;
+    double messages_per_second;
+};
+
+template< typename Push, typename Snapshot >
+PushTimes timePushes(Push push, Snapshot snapshot)
+{
+    typedef std::chrono::steady_clock clock;
+    std::atomic<bool> producing(true);
+    boost::thread consumer([&]() {
+        while (producing)
+            snapshot();
+    });
+
+    vector< vector<double> > times_us(num_producers, vector<double>(num_messages));
+    const clock::time_point start = clock::now();
+    boost::thread_group producers;
+    for (int p = 0; p < num_producers; p++) {
+        producers.create_thread([&, p]() {
+            boost::shared_ptr<Message> message = boost::make_shared<Message>(p, 0);
+            for (int i = 0; i < num_messages; i++) {
+                const clock::time_point before = clock::now();
+                push(message);
+                times_us[p][i] = std::chrono::duration<double, std::micro>(clock::now() - before).count();
+            }
+        });
+    }
+    producers.join_all();
+    const double elapsed_s = std::chrono::duration<double>(clock::now() - start).count();
+    producing = false;
+    consumer.join();
+
+    vector<double> all_us;
+    for (const auto& producer_us : times_us)
+        all_us.insert(all_us.end(), producer_us.begin(), producer_us.end());
+    std::sort(all_us.begin(), all_us.end());
+    PushTimes times;
+    times.mean_us = 0;
+    for (double us : all_us)
+        times.mean_us += us / all_us.size();
+    times.median_us = all_us[all_us.size() / 2];
+    times.p99_us = all_us[all_us.size() * 99 / 100];
+    times.p999_us = all_us[all_us.size() * 999 / 1000];
+    times.max_us = all_us.back();
+    times.messages_per_second = num_producers * num_messages / elapsed_s;
+    return times;
+}
+
+void printTimes(const char* name, const PushTimes& times)
+{
+    cout << name << ": push mean " << times.mean_us << "us, median " << times.median_us << "us, 99% " << times.p99_us << "us, 99.9% " << times.p999_us
+         << "us, max " << times.max_us << "us, " << static_cast<int>(times.messages_per_second) << " messages/s" << endl;
+}
+
+void runBenchmark()
+{
+    // Before: every producer and the consumer share one mutex, and the consumer copies the stored messages while holding it.
+    {
+        boost::mutex mutex;
+        vector< boost::shared_ptr<Message> > stored;
+        PushTimes times = timePushes(
+            [&](const boost::shared_ptr<Message>& message) {
+                boost::lock_guard<boost::mutex> scope_guard(mutex);
+                stored.push_back(message);
+            },
+            [&]() {
+                boost::lock_guard<boost::mutex> scope_guard(mutex);
+                vector< boost::shared_ptr<Message> > copy(stored);
+                stored.clear();
+            });
+        printTimes("Single mutex  ", times);
+    }
+    // After: producers push into the channel; only the consumer touches the stored messages.
+    {
+        MessageChannel< boost::shared_ptr<Message> > channel;
+        vector< boost::shared_ptr<Message> > stored;
+        PushTimes times = timePushes(
+            [&](const boost::shared_ptr<Message>& message) {
+                channel.push(message, true);
+            },
+            [&]() {
+                channel.take(stored);
+                vector< boost::shared_ptr<Message> > copy(stored);
+                stored.clear();
+            });
+        printTimes("MessageChannel", times);
+    }
+}
+
+int main()
+{
+    if (!testQueuedMessages() || !testLatestMessage() || !testNoAllocationsOnceWarm())
+        return EXIT_FAILURE;
+    if (!testLimit(true) || !testLimit(false) || !testLimitWithProducers(true) || !testLimitWithProducers(false))
+        return EXIT_FAILURE;
+    if (!testOrderAcrossTakes(0, false) || !testOrderAcrossTakes(64, true) || !testOrderAcrossTakes(64, false))
+        return EXIT_FAILURE;
+    if (!testLimitChangedWhilePushing())
+        return EXIT_FAILURE;
+
+    runBenchmark();
+    return EXIT_SUCCESS;
+}
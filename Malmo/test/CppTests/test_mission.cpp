@@ -156,6 +156,20 @@ int main()
         cout << "Error validating known-good XML: " << e.what() << "\n" << e << endl;
         return EXIT_FAILURE;
     }
+
+    // check that known-bad XML doesn't validate, now that the schemas have been compiled for the first parse
+    string xml4 = xml3;
+    xml4.replace( xml4.find( "<Summary>" ), 0, "<Mystery/>" );
+    try
+    {
+        const bool validate = true;
+        MissionSpec my_mission4( xml4, validate );
+        cout << "Known-bad XML was accepted." << endl;
+        return EXIT_FAILURE;
+    }
+    catch( const xml_schema::parsing& )
+    {
+    }
        
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,101 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <MissionInitSpec.h>
+#include <MissionInitTemplate.h>
+#include <MissionSpec.h>
+using namespace malmo;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <string>
+using namespace std;
+
+// Checks that the template gives the XML that setting the fields and serialising would, and that it validates.
+bool offeredAsExpected(const MissionInitTemplate& mission_init_template, MissionInitSpec mission_init, const string& address, int control_port, int commands_port, bool offer_prefixes)
+{
+    const string xml = mission_init_template.getXML(address, control_port, commands_port, offer_prefixes);
+
+    mission_init.setClientAddress(address);
+    mission_init.setClientMissionControlPort(control_port);
+    mission_init.setClientCommandsPort(commands_port);
+    if (!offer_prefixes)
+    {
+        mission_init.setAgentSharedMemoryPrefix("");
+        mission_init.setAgentLocalSocketPrefix("");
+    }
+    const bool pretty_print = false;
+    const string expected_xml = mission_init.getAsXML(pretty_print);
+    if (xml != expected_xml)
+    {
+        cout << "Mismatch between the template's XML and the mission init's:\n\n" << xml << "\n\n" << expected_xml << endl;
+        return false;
+    }
+
+    try
+    {
+        const bool validate = true;
+        MissionInitSpec offered(xml, validate);
+        if (offered.getClientAddress() != address || offered.getClientMissionControlPort() != control_port || offered.getClientCommandsPort() != commands_port)
+        {
+            cout << "Unexpected client fields in the template's XML." << endl;
+            return false;
+        }
+    }
+    catch (const xml_schema::exception& e)
+    {
+        cout << "Error validating the template's XML: " << e.what() << "\n" << e << endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    MissionSpec mission;
+    mission.setSummary("template mission");
+    mission.drawCuboid(-20, 0, -20, 20, 10, 20, "stone");
+    mission.requestVideo(320, 240);
+
+    MissionInitSpec mission_init(mission, "template_experiment", 0);
+    mission_init.setAgentSharedMemoryPrefix("/malmo_video_");
+    mission_init.setAgentLocalSocketPrefix("/tmp/malmo_socket_");
+
+    const MissionInitTemplate mission_init_template(mission_init);
+
+    if (!offeredAsExpected(mission_init_template, mission_init, "127.0.0.1", 10000, 0, true))
+        return EXIT_FAILURE;
+    if (!offeredAsExpected(mission_init_template, mission_init, "10.0.0.42", 10001, 10101, false))
+        return EXIT_FAILURE;
+    if (!offeredAsExpected(mission_init_template, mission_init, "a<b>&c", 10002, 10102, true))
+        return EXIT_FAILURE;
+
+    // Without prefixes there is nothing to leave out.
+    mission_init.setAgentSharedMemoryPrefix("");
+    mission_init.setAgentLocalSocketPrefix("");
+    const MissionInitTemplate plain_template(mission_init);
+    if (!offeredAsExpected(plain_template, mission_init, "127.0.0.1", 10000, 0, true))
+        return EXIT_FAILURE;
+    if (!offeredAsExpected(plain_template, mission_init, "10.0.0.42", 10001, 10101, false))
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
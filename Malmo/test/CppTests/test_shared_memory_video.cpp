@@ -0,0 +1,260 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Sends video frames to a VideoServer through a shared-memory ring, the way a client on the same machine would, and compares
+// the time taken with sending the same frames over a TCP connection. Also serves as an example producer.
+
+// Malmo:
+#include <SharedMemoryRing.h>
+#include <VideoServer.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/asio.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const short width = 320;
+const short height = 240;
+const int channels = 3;
+const int port = 10014;
+const int num_frames = 500;
+const int frame_size = TimestampedVideoFrame::FRAME_HEADER_SIZE + width * height * channels;
+
+std::atomic<int> num_frames_received(0);
+std::atomic<bool> failed(false);
+
+void handleFrame(boost::shared_ptr<TimestampedVideoFrame> frame)
+{
+    // The frame number is in the first byte of the last row sent, which the server flips to the top.
+    if (frame->getPixels()[0] != static_cast<unsigned char>(num_frames_received) || frame->xPos != num_frames_received) {
+        cout << "Frame " << num_frames_received << " arrived out of order, or was corrupted." << endl;
+        failed = true;
+    }
+    num_frames_received++;
+}
+
+uint32_t hton_float(float value)
+{
+    uint32_t temp;
+    *((float*)&temp) = value;
+    return htonl(temp);
+}
+
+void makeFrame(int i, vector<unsigned char>& message)
+{
+    message.assign(frame_size, 0);
+    uint32_t* ptr = reinterpret_cast<uint32_t*>(&message[0]);
+    *ptr = hton_float((float)i);
+    message[TimestampedVideoFrame::FRAME_HEADER_SIZE + (height - 1) * width * channels] = static_cast<unsigned char>(i);
+}
+
+bool waitForFrames(int expected)
+{
+    const ptime deadline = microsec_clock::universal_time() + seconds(20);
+    while (num_frames_received < expected && microsec_clock::universal_time() < deadline)
+        boost::this_thread::sleep(microseconds(100));
+    return num_frames_received == expected;
+}
+
+// Finds a message in a ring's segment by its contents, and overwrites its size with one far bigger than any slot.
+bool corruptMessageSize(const string& name, const unsigned char* message, size_t size)
+{
+#ifdef _WIN32
+    return false;
+#else
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+        return false;
+    unsigned char* segment = static_cast<unsigned char*>(mmap(0, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    close(fd);
+    if (segment == MAP_FAILED)
+        return false;
+    bool found = false;
+    const uint64_t size_header = size;
+    const uint64_t bad_size = uint64_t(1) << 40;
+    for (size_t offset = 0; !found && offset + sizeof(size_header) + size <= static_cast<size_t>(info.st_size); offset += sizeof(size_header)) {
+        if (memcmp(segment + offset, &size_header, sizeof(size_header)) == 0 && memcmp(segment + offset + sizeof(size_header), message, size) == 0) {
+            memcpy(segment + offset, &bad_size, sizeof(bad_size));
+            found = true;
+        }
+    }
+    munmap(segment, info.st_size);
+    return found;
+#endif
+}
+
+bool testRing()
+{
+    const string name = SharedMemoryRing::getSegmentName(SharedMemoryRing::makeUniquePrefix(), 0);
+    boost::shared_ptr<SharedMemoryRing> consumer = SharedMemoryRing::create(name, 4, 16);
+    boost::shared_ptr<SharedMemoryRing> producer = SharedMemoryRing::open(name);
+    if (producer->getSlotCount() != 4 || producer->getSlotSize() != 16) {
+        cout << "Producer sees the wrong ring geometry." << endl;
+        return false;
+    }
+
+    for (unsigned char i = 0; i < 4; i++) {
+        const vector<unsigned char> message(i + 1, i);
+        if (!producer->write(message.data(), message.size())) {
+            cout << "Failed to write message " << (int)i << endl;
+            return false;
+        }
+    }
+    const unsigned char extra[1] = { 99 };
+    const unsigned char too_big[17] = { 0 };
+    if (producer->write(extra, 1) || producer->write(too_big, 17) || consumer->getDroppedCount() != 2 || consumer->getWrittenCount() != 4) {
+        cout << "Full ring or oversized message wasn't dropped." << endl;
+        return false;
+    }
+
+    vector<unsigned char> buffer;
+    for (unsigned char i = 0; i < 4; i++) {
+        if (!consumer->read(buffer, milliseconds(100)) || buffer != vector<unsigned char>(i + 1, i)) {
+            cout << "Failed to read message " << (int)i << endl;
+            return false;
+        }
+    }
+    if (consumer->read(buffer, milliseconds(10))) {
+        cout << "Read a message from an empty ring." << endl;
+        return false;
+    }
+
+    // A message whose size runs past its slot, as from a mismatched producer, is skipped and counted as dropped.
+    const unsigned char marked[5] = { 0xab, 0xab, 0xab, 0xab, 0xab };
+    if (!producer->write(marked, 5) || !producer->write(extra, 1) || !corruptMessageSize(name, marked, 5)) {
+        cout << "Couldn't set up a message with a bad size." << endl;
+        return false;
+    }
+    const uint64_t dropped_before = consumer->getDroppedCount();
+    if (!consumer->read(buffer, milliseconds(100)) || buffer.size() != 1 || buffer[0] != 99 || consumer->getDroppedCount() != dropped_before + 1) {
+        cout << "A message with a bad size wasn't skipped." << endl;
+        return false;
+    }
+
+    // A waiting consumer should be woken both by the doorbell and by interrupt().
+    boost::thread late_producer([&]() { boost::this_thread::sleep(milliseconds(50)); producer->write(extra, 1); });
+    const bool woken = consumer->read(buffer, seconds(5)) && buffer.size() == 1 && buffer[0] == 99;
+    late_producer.join();
+    if (!woken) {
+        cout << "Consumer missed the doorbell." << endl;
+        return false;
+    }
+    boost::thread interrupter([&]() { boost::this_thread::sleep(milliseconds(50)); consumer->interrupt(); });
+    const ptime start = microsec_clock::universal_time();
+    const bool read_after_interrupt = consumer->read(buffer, seconds(5));
+    interrupter.join();
+    if (read_after_interrupt || microsec_clock::universal_time() - start > seconds(2)) {
+        cout << "Consumer wasn't interrupted." << endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    if (!SharedMemoryRing::isSupported()) {
+        cout << "Shared memory isn't supported on this platform - nothing to test." << endl;
+        return EXIT_SUCCESS;
+    }
+
+    try {
+        if (!testRing())
+            return EXIT_FAILURE;
+
+        boost::asio::io_service io_service;
+        boost::shared_ptr<boost::asio::io_service::work> work = boost::make_shared<boost::asio::io_service::work>(io_service);
+        boost::thread io_thread(boost::bind(&boost::asio::io_service::run, &io_service));
+
+        const string name = SharedMemoryRing::getSegmentName(SharedMemoryRing::makeUniquePrefix(), TimestampedVideoFrame::VIDEO);
+        {
+            VideoServer server(io_service, port, width, height, channels, TimestampedVideoFrame::VIDEO, handleFrame);
+            server.receiveFromSharedMemory(name);
+            server.start();
+            if (server.getSharedMemoryName() != name) {
+                cout << "Server reports the wrong segment name." << endl;
+                return EXIT_FAILURE;
+            }
+
+            vector< vector<unsigned char> > frames(num_frames);
+            for (int i = 0; i < num_frames; i++)
+                makeFrame(i, frames[i]);
+
+            // Over shared memory. A real producer would drop frames when the ring is full; here we want them all, so wait for room.
+            boost::shared_ptr<SharedMemoryRing> producer = SharedMemoryRing::open(name);
+            ptime start = microsec_clock::universal_time();
+            for (int i = 0; i < num_frames; i++) {
+                while (!producer->write(frames[i].data(), frames[i].size()))
+                    boost::this_thread::yield();
+            }
+            if (!waitForFrames(num_frames)) {
+                cout << "Only received " << num_frames_received << " of " << num_frames << " frames through shared memory." << endl;
+                return EXIT_FAILURE;
+            }
+            const time_duration shared_memory_time = microsec_clock::universal_time() - start;
+
+            // Over TCP, on one connection, as the Mod sends them.
+            num_frames_received = 0;
+            boost::asio::ip::tcp::socket socket(io_service);
+            socket.connect(boost::asio::ip::tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"), port));
+            start = microsec_clock::universal_time();
+            for (int i = 0; i < num_frames; i++) {
+                const uint32_t size_header = htonl(static_cast<uint32_t>(frame_size));
+                boost::asio::write(socket, boost::asio::buffer(&size_header, sizeof(size_header)));
+                boost::asio::write(socket, boost::asio::buffer(frames[i]));
+            }
+            if (!waitForFrames(num_frames)) {
+                cout << "Only received " << num_frames_received << " of " << num_frames << " frames over TCP." << endl;
+                return EXIT_FAILURE;
+            }
+            const time_duration tcp_time = microsec_clock::universal_time() - start;
+            socket.close();
+
+            cout << num_frames << " frames of " << frame_size << " bytes: shared memory " << shared_memory_time.total_microseconds() / num_frames
+                 << "us/frame, TCP " << tcp_time.total_microseconds() / num_frames << "us/frame" << endl;
+        }
+
+        work.reset();
+        io_service.stop();
+        io_thread.join();
+    }
+    catch (const exception& e) {
+        cout << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -30,6 +30,8 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace malmo;
 
@@ -67,7 +69,7 @@ bool testStringServer( bool withReply )
     std::cout << "Sending messages.." << std::endl;
     for( int i = 0; i < num_messages_sent; i++ ) {
         if( withReply ) {
-            std::string reply = SendStringAndGetShortReply(io_service, "127.0.0.1", server.getPort(), expected_message, true);
+            std::string reply = SendStringAndGetShortReply("127.0.0.1", server.getPort(), expected_message, true, 5000, 5000);
             if( reply != expected_reply ) {
                 std::cout << "Unexpected reply." << std::endl;
                 return false;
@@ -90,8 +92,88 @@ bool testStringServer( bool withReply )
     return true;
 }
 
+bool testShortReplies()
+{
+    num_messages_received = 0;
+
+    std::cout << "Starting servers.." << std::endl;
+    boost::asio::io_service io_service;
+    StringServer replying_server( io_service, 0, onMessageReceived, "test" );
+    replying_server.confirmWithFixedReply( expected_reply );
+    replying_server.start();
+    StringServer silent_server( io_service, 0, onMessageReceived, "test" );
+    silent_server.start();
+    boost::thread bt(boost::bind(&boost::asio::io_service::run, &io_service));
+
+    // find a port that nothing is listening on
+    int dead_port;
+    {
+        boost::asio::ip::tcp::acceptor acceptor( io_service, boost::asio::ip::tcp::endpoint( boost::asio::ip::tcp::v4(), 0 ) );
+        dead_port = acceptor.local_endpoint().port();
+    }
+
+    boost::this_thread::sleep( boost::posix_time::milliseconds(100) ); // allow time for the thread and servers to start
+
+    std::cout << "Sending messages.." << std::endl;
+    std::vector< std::pair<std::string, int> > endpoints;
+    endpoints.push_back( std::make_pair( std::string("127.0.0.1"), replying_server.getPort() ) );
+    endpoints.push_back( std::make_pair( std::string("127.0.0.1"), dead_port ) );
+    endpoints.push_back( std::make_pair( std::string("127.0.0.1"), silent_server.getPort() ) );
+    endpoints.push_back( std::make_pair( std::string("127.0.0.1"), replying_server.getPort() ) );
+    endpoints.push_back( std::make_pair( std::string("127.0.0.1"), silent_server.getPort() ) );
+    std::vector<std::string> messages( endpoints.size(), expected_message );
+    messages.back() = "";   // connect only
+
+    const int timeout_ms = 500;
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    std::vector<ShortReply> replies = SendStringsAndGetShortReplies( endpoints, messages, true, timeout_ms, timeout_ms );
+    const boost::posix_time::time_duration taken = boost::posix_time::microsec_clock::universal_time() - start;
+
+    boost::this_thread::sleep( boost::posix_time::milliseconds(100) ); // allow time for the messages to get through
+
+    io_service.stop();
+    bt.join();
+
+    std::cout << "Exiting.." << std::endl;
+
+    if( replies.size() != endpoints.size() ) {
+        std::cout << "Wrong number of replies." << std::endl;
+        return false;
+    }
+    if( !replies[0].ok || replies[0].reply != expected_reply || !replies[3].ok || replies[3].reply != expected_reply ) {
+        std::cout << "Expected replies from the replying server." << std::endl;
+        return false;
+    }
+    if( replies[1].ok || replies[1].timed_out || replies[1].error.empty() ) {
+        std::cout << "Expected the dead port to fail." << std::endl;
+        return false;
+    }
+    if( replies[2].ok || !replies[2].timed_out ) {
+        std::cout << "Expected the silent server to time out." << std::endl;
+        return false;
+    }
+    if( !replies[4].ok || !replies[4].reply.empty() ) {
+        std::cout << "Expected to connect to the silent server." << std::endl;
+        return false;
+    }
+    // the exchanges run together, so the whole batch takes about one timeout
+    if( taken < boost::posix_time::milliseconds( timeout_ms - 10 ) || taken > boost::posix_time::milliseconds( 2 * timeout_ms ) ) {
+        std::cout << "Took " << taken.total_milliseconds() << "ms." << std::endl;
+        return false;
+    }
+    if( num_messages_received != 3 ) {
+        std::cout << "Expected three messages to arrive." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 int main()
 {
+    if( !testShortReplies() )
+        return EXIT_FAILURE;
+
 	for( int i = 0; i < 10; i++ )
 	{
 		if( !testStringServer( false ) )
@@ -0,0 +1,106 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <VectorAgentHost.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+using namespace std;
+
+int main()
+{
+    const int num_environments = 3;
+    VectorAgentHost vector_agent_host( num_environments, 2, false );
+    if( vector_agent_host.getNumberOfEnvironments() != num_environments )
+        return EXIT_FAILURE;
+
+    // The environments' io threads belong to the VectorAgentHost.
+    try {
+        vector_agent_host.getAgentHost( 0 ).setNumberOfIoThreads( 4, false );
+        cout << "Expected an exception for setting the io threads of an environment." << endl;
+        return EXIT_FAILURE;
+    }
+    catch( const runtime_error& ) {
+    }
+
+    try {
+        vector_agent_host.step( vector<string>( num_environments + 1, "move 1" ), WorldStateCondition(), 100 );
+        cout << "Expected an exception for the wrong number of commands." << endl;
+        return EXIT_FAILURE;
+    }
+    catch( const invalid_argument& ) {
+    }
+
+    // With no missions running the commands can't be sent: every step is over straight away, with the error.
+    WorldStateCondition condition( WorldStateCondition::ALL );
+    condition.requireObservations( 1 );
+    condition.requireVideoFrames( 1 );
+    const boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    BatchedWorldState batch = vector_agent_host.step( vector<string>( num_environments, "move 1" ), condition, 5000 );
+    if( boost::posix_time::microsec_clock::universal_time() - start > boost::posix_time::seconds( 2 ) ) {
+        cout << "Steps should be over as soon as the commands fail." << endl;
+        return EXIT_FAILURE;
+    }
+    if( batch.world_states.size() != num_environments || batch.frames.getDepth() != num_environments || !batch.frames.getTimestamp( 0 ).is_not_a_date_time() )
+        return EXIT_FAILURE;
+    for( const auto& world_state : batch.world_states ) {
+        if( world_state.errors.size() != 1 || world_state.is_mission_running )
+            return EXIT_FAILURE;
+    }
+    // Every step is over, and no environment sent a frame.
+    if( batch.steps_completed != vector<bool>( num_environments, true ) || batch.frames_updated != vector<bool>( num_environments, false ) ) {
+        cout << "Expected every step complete, with no new frames." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Asynchronous steps are each handed back once; an empty command isn't waited for.
+    vector<string> commands( num_environments, "move 1" );
+    commands[1] = "";
+    vector_agent_host.stepAsync( commands, condition );
+    set<int> completed;
+    WorldState world_state;
+    for( int index; ( index = vector_agent_host.waitForAnyStep( 1000, world_state ) ) != -1; ) {
+        if( !completed.insert( index ).second || world_state.errors.size() != 1 )
+            return EXIT_FAILURE;
+    }
+    if( completed != set<int>{ 0, 2 } ) {
+        cout << "Expected environments 0 and 2 to complete." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // An environment that wasn't waiting for a step isn't reported as having completed one.
+    vector_agent_host.stepAsync( commands, condition );
+    batch = vector_agent_host.waitForSteps( 1000 );
+    if( batch.steps_completed != vector<bool>{ true, false, true } ) {
+        cout << "Expected only environments 0 and 2 to have completed steps." << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -44,9 +44,10 @@ const int num_frames = 50;
 const std::string filename = "video_server_test.mp4";
 std::atomic<int> num_messages_received(0);
 
-void handleFrame(TimestampedVideoFrame frame)
+void handleFrame(boost::shared_ptr<TimestampedVideoFrame> message)
 {
-    if (frame.pixels[0] != num_messages_received)
+    const TimestampedVideoFrame& frame = *message;
+    if (frame.getPixels()[0] != num_messages_received)
     {
         std::cout << "Pixel not set, frames passed out of order." << endl;
         exit(EXIT_FAILURE);
@@ -86,7 +87,7 @@ int main()
 
     try{
         boost::asio::io_service io_service;
-        VideoServer server(io_service, port, width, width, channels, TimestampedVideoFrame::VIDEO, boost::function<void(const TimestampedVideoFrame)>(handleFrame));
+        VideoServer server(io_service, port, width, width, channels, TimestampedVideoFrame::VIDEO, boost::function<void(const boost::shared_ptr<TimestampedVideoFrame>)>(handleFrame));
         server.recordMP4(filename, 10, 400000, true);
         server.startRecording();
         server.start();
@@ -24,6 +24,7 @@ using namespace malmo;
 // Boost:
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/make_shared.hpp>
 using namespace boost::posix_time;
 
 // STL:
@@ -45,9 +46,9 @@ void runTest(std::unique_ptr<VideoFrameWriter> writer)
 {
     writer->open();
     ptime timestamp = microsec_clock::universal_time();
-    vector<unsigned char> buffer(width * width * 3);
+    vector<unsigned char> buffer(TimestampedVideoFrame::FRAME_HEADER_SIZE + width * width * 3);
     for (int i = 0; i < frames; i++){
-        for (int r = 0, p = 0; r < width; r++){
+        for (int r = 0, p = TimestampedVideoFrame::FRAME_HEADER_SIZE; r < width; r++){
             for (int c = 0; c < width; c++, p += 3){
                 buffer[p] = width - c;
                 buffer[p + 2] = r;
@@ -57,7 +58,7 @@ void runTest(std::unique_ptr<VideoFrameWriter> writer)
         int boxPos = (i * (width - box_size)) / frames;
         for (int r = 0; r < box_size; r++){
             for (int c = 0; c < box_size; c++){
-                int p = (boxPos + r) * width * 3 + (boxPos + c) * 3;
+                int p = TimestampedVideoFrame::FRAME_HEADER_SIZE + (boxPos + r) * width * 3 + (boxPos + c) * 3;
                 buffer[p] = 255;
                 buffer[p + 1] = i < 5 ? 0 : 255;
                 buffer[p + 2] = i < 5 ? 0 : 255;
@@ -65,7 +66,7 @@ void runTest(std::unique_ptr<VideoFrameWriter> writer)
         }
 
         TimestampedUnsignedCharVector message(timestamp, buffer);
-        writer->write(TimestampedVideoFrame(width, width, 3, message));
+        writer->write(boost::make_shared<TimestampedVideoFrame>(width, width, 3, message));
         timestamp += milliseconds(frame_length);
     }
 
@@ -0,0 +1,97 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <WorldState.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+using namespace boost::posix_time;
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+using namespace std;
+
+const int num_messages = 5000;
+const int num_rounds = 200;
+
+void fill(WorldState& world_state, const boost::shared_ptr<TimestampedString>& message)
+{
+    world_state.is_mission_running = true;
+    world_state.has_mission_begun = true;
+    world_state.number_of_observations_since_last_state = num_messages;
+    for (int i = 0; i < num_messages; i++) {
+        world_state.observations.push_back(message);
+        world_state.mission_control_messages.push_back(message);
+    }
+}
+
+int main()
+{
+    const boost::shared_ptr<TimestampedString> message = boost::make_shared<TimestampedString>(microsec_clock::universal_time(), "{}");
+
+    // Swapping exchanges everything, and clearing keeps the storage for next time.
+    WorldState filled;
+    WorldState empty;
+    fill(filled, message);
+    filled.swap(empty);
+    if (!filled.observations.empty() || filled.is_mission_running || filled.number_of_observations_since_last_state != 0) {
+        cout << "Swapping didn't empty the filled world state." << endl;
+        return EXIT_FAILURE;
+    }
+    if (empty.observations.size() != num_messages || !empty.is_mission_running || empty.number_of_observations_since_last_state != num_messages) {
+        cout << "Swapping didn't fill the empty world state." << endl;
+        return EXIT_FAILURE;
+    }
+    empty.clear();
+    if (empty.observations.capacity() < num_messages) {
+        cout << "Clearing the world state released its storage." << endl;
+        return EXIT_FAILURE;
+    }
+    if (message.use_count() != 1) {
+        cout << "Messages are still referenced after clearing." << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Compare taking the world state by copying and clearing with taking it by swapping buffers.
+    WorldState producer_side;
+    ptime start = microsec_clock::universal_time();
+    for (int round = 0; round < num_rounds; round++) {
+        fill(producer_side, message);
+        WorldState taken(producer_side);
+        producer_side.clear();
+    }
+    const time_duration copy_time = microsec_clock::universal_time() - start;
+
+    WorldState consumer_side;
+    start = microsec_clock::universal_time();
+    for (int round = 0; round < num_rounds; round++) {
+        fill(producer_side, message);
+        consumer_side.clear();
+        producer_side.swap(consumer_side);
+    }
+    const time_duration swap_time = microsec_clock::universal_time() - start;
+
+    cout << num_rounds << " world states of " << 2 * num_messages << " messages: copy and clear " << copy_time.total_microseconds() / num_rounds
+         << "us each, swap " << swap_time.total_microseconds() / num_rounds << "us each (including filling)" << endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,98 @@
+// --------------------------------------------------------------------------------------------------
+//  Copyright (c) 2016 Microsoft Corporation
+//  
+//  Permission is hereby granted, free of charge, to any person obtaining a copy of this software and
+//  associated documentation files (the "Software"), to deal in the Software without restriction,
+//  including without limitation the rights to use, copy, modify, merge, publish, distribute,
+//  sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is
+//  furnished to do so, subject to the following conditions:
+//  
+//  The above copyright notice and this permission notice shall be included in all copies or
+//  substantial portions of the Software.
+//  
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+//  NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+//  DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// --------------------------------------------------------------------------------------------------
+
+// Malmo:
+#include <WorldStateCondition.h>
+using namespace malmo;
+
+// Boost:
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/make_shared.hpp>
+
+// STL:
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+bool check(bool result, bool expected, const char* what)
+{
+    if (result != expected)
+        cout << what << ": expected " << expected << " but got " << result << endl;
+    return result == expected;
+}
+
+int main()
+{
+    WorldState world_state;
+    vector<int> frames_by_type(TimestampedVideoFrame::_MAX_FRAME_TYPE, 0);
+    bool ok = true;
+
+    // With nothing required, anything new will do.
+    WorldStateCondition anything;
+    ok &= check(anything.isSatisfiedBy(world_state, frames_by_type), false, "Anything, when empty");
+    world_state.mission_control_messages.push_back(boost::make_shared<TimestampedString>(boost::posix_time::microsec_clock::universal_time(), "<ping/>"));
+    ok &= check(anything.isSatisfiedBy(world_state, frames_by_type), true, "Anything, after a control message");
+    world_state.clear();
+
+    WorldStateCondition any;
+    any.requireObservations(2);
+    any.requireVideoFramesOfType(TimestampedVideoFrame::DEPTH_MAP, 1);
+    any.requireMissionEnded();
+    WorldStateCondition all(WorldStateCondition::ALL);
+    all.requireObservations(2);
+    all.requireVideoFramesOfType(TimestampedVideoFrame::DEPTH_MAP, 1);
+
+    world_state.number_of_observations_since_last_state = 1;
+    ok &= check(any.isSatisfiedBy(world_state, frames_by_type), false, "Any, one observation");
+
+    world_state.number_of_observations_since_last_state = 2;
+    ok &= check(any.isSatisfiedBy(world_state, frames_by_type), true, "Any, two observations");
+    ok &= check(all.isSatisfiedBy(world_state, frames_by_type), false, "All, two observations");
+
+    // Frames of the wrong type don't count.
+    world_state.number_of_video_frames_since_last_state = 3;
+    frames_by_type[TimestampedVideoFrame::VIDEO] = 3;
+    ok &= check(all.isSatisfiedBy(world_state, frames_by_type), false, "All, two observations and colour frames");
+
+    frames_by_type[TimestampedVideoFrame::DEPTH_MAP] = 1;
+    ok &= check(all.isSatisfiedBy(world_state, frames_by_type), true, "All, two observations and a depth frame");
+
+    // The mission has ended once it has begun and is no longer running.
+    world_state.clear();
+    frames_by_type.assign(frames_by_type.size(), 0);
+    ok &= check(any.isSatisfiedBy(world_state, frames_by_type), false, "Any, before the mission");
+    world_state.has_mission_begun = true;
+    world_state.is_mission_running = true;
+    ok &= check(any.isSatisfiedBy(world_state, frames_by_type), false, "Any, during the mission");
+    world_state.is_mission_running = false;
+    ok &= check(any.isSatisfiedBy(world_state, frames_by_type), true, "Any, after the mission");
+
+    WorldStateCondition begun;
+    begun.requireMissionBegun();
+    ok &= check(begun.isSatisfiedBy(world_state, frames_by_type), true, "Begun, after the mission");
+
+    WorldStateCondition rewards;
+    rewards.requireRewards(1);
+    rewards.requireVideoFrames(5);
+    world_state.number_of_rewards_since_last_state = 1;
+    ok &= check(rewards.isSatisfiedBy(world_state, frames_by_type), true, "Any, a reward");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}